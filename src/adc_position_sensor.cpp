@@ -0,0 +1,28 @@
+#include "adc_position_sensor.h"
+#include <Arduino.h>
+
+// Below/above these the sensor is saturated or disconnected
+#define ADC_RAIL_LOW_MV 50
+#define ADC_RAIL_HIGH_MV 3050
+
+bool AdcPositionSensor::begin_impl() {
+    analogReadResolution(12);
+    analogSetPinAttenuation(POSITION_SENSOR_ADC_PIN, ADC_11db);
+    
+    uint32_t mv = analogReadMilliVolts(POSITION_SENSOR_ADC_PIN);
+    return mv > ADC_RAIL_LOW_MV && mv < ADC_RAIL_HIGH_MV;
+}
+
+bool AdcPositionSensor::read_impl(float* mm) {
+    uint32_t sum = 0;
+    for (int i = 0; i < POSITION_SENSOR_ADC_OVERSAMPLE; i++) {
+        sum += analogReadMilliVolts(POSITION_SENSOR_ADC_PIN);
+    }
+    uint32_t mv = sum / POSITION_SENSOR_ADC_OVERSAMPLE;
+    if (mv <= ADC_RAIL_LOW_MV || mv >= ADC_RAIL_HIGH_MV) {
+        return false;
+    }
+    
+    *mm = POSITION_SENSOR_ADC_MM_AT_0V + POSITION_SENSOR_ADC_MM_PER_VOLT * (mv / 1000.0f);
+    return true;
+}
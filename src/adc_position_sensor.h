@@ -0,0 +1,48 @@
+#ifndef ADC_POSITION_SENSOR_H
+#define ADC_POSITION_SENSOR_H
+
+#include "position_sensor.h"
+
+// Analog height sensor (e.g. IR reflective or a photodiode across the
+// chamber) on an ADC1 pin; ADC2 is unusable while Wi-Fi is on
+#ifndef POSITION_SENSOR_ADC_PIN
+#define POSITION_SENSOR_ADC_PIN 34
+#endif
+
+// Linear calibration: mm = MM_AT_0V + MM_PER_VOLT * volts
+#ifndef POSITION_SENSOR_ADC_MM_AT_0V
+#define POSITION_SENSOR_ADC_MM_AT_0V 25.0f
+#endif
+#ifndef POSITION_SENSOR_ADC_MM_PER_VOLT
+#define POSITION_SENSOR_ADC_MM_PER_VOLT 3.0f
+#endif
+
+// Conversions averaged per reading (~10 µs each)
+#ifndef POSITION_SENSOR_ADC_OVERSAMPLE
+#define POSITION_SENSOR_ADC_OVERSAMPLE 4
+#endif
+
+/**
+ * Bead height from a calibrated analog voltage
+ * Readings pinned at either rail are reported invalid.
+ */
+class AdcPositionSensor : public PositionSensor<AdcPositionSensor> {
+public:
+    static constexpr const char* NAME = "adc";
+
+    bool begin_impl();
+    bool read_impl(float* mm);
+};
+
+/**
+ * Placeholder when no sensor is fitted: begin() fails and the loop stays open
+ */
+class NoPositionSensor : public PositionSensor<NoPositionSensor> {
+public:
+    static constexpr const char* NAME = "none";
+
+    bool begin_impl() { return false; }
+    bool read_impl(float* mm) { (void)mm; return false; }
+};
+
+#endif // ADC_POSITION_SENSOR_H
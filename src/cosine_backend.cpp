@@ -0,0 +1,32 @@
+#include "cosine_backend.h"
+#include "cw_generator.h"
+
+bool CosineBackend::init_impl(float frequency, phase_t phase) {
+    cw_generator_set_frequency(frequency);
+    m_inverted = phase_to_steps<PHASE_STEPS>(phase) != 0;
+    return true;
+}
+
+void CosineBackend::set_phase_impl(phase_t phase) {
+    // Round to the nearest of 0° / 180°
+    m_inverted = phase_to_steps<PHASE_STEPS>(phase) != 0;
+    cw_generator_set_inverted(DAC_CHANNEL_2, m_inverted);
+}
+
+void CosineBackend::set_frequency_impl(float frequency) {
+    cw_generator_set_frequency(frequency);
+}
+
+void CosineBackend::start_impl() {
+    cw_generator_enable(DAC_CHANNEL_1);
+    cw_generator_enable(DAC_CHANNEL_2, m_inverted);
+}
+
+void CosineBackend::scope_snapshot_impl(scope_snapshot_t* snapshot) {
+    snapshot->waveform = SCOPE_WAVEFORM_SINE;
+}
+
+void CosineBackend::stop_impl() {
+    cw_generator_disable(DAC_CHANNEL_1);
+    cw_generator_disable(DAC_CHANNEL_2);
+}
@@ -0,0 +1,28 @@
+#ifndef COSINE_BACKEND_H
+#define COSINE_BACKEND_H
+
+#include "waveform_backend.h"
+
+/**
+ * Hardware cosine (CW) generator backend
+ * Both DAC channels are driven by the single CW generator, so the output is
+ * a clean sine with zero CPU cost, but the only phase control available is
+ * output inversion: phase snaps to 0° or 180° (2 steps).
+ */
+class CosineBackend : public WaveformBackend<CosineBackend> {
+public:
+    static constexpr const char* NAME = "cosine";
+    static constexpr uint32_t PHASE_STEPS = 2;
+
+    bool init_impl(float frequency, phase_t phase);
+    void set_phase_impl(phase_t phase);
+    void set_frequency_impl(float frequency);
+    void start_impl();
+    void stop_impl();
+    void scope_snapshot_impl(scope_snapshot_t* snapshot);
+
+private:
+    bool m_inverted = false;
+};
+
+#endif // COSINE_BACKEND_H
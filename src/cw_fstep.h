@@ -0,0 +1,34 @@
+#ifndef CW_FSTEP_H
+#define CW_FSTEP_H
+
+#include <stdint.h>
+
+/**
+ * CW generator frequency quantization
+ * freq = dig_clk_rtc_freq × SENS_SAR_SW_FSTEP / 65536, so the generator
+ * only reaches multiples of ~130 Hz. Shared by cw_generator.cpp and
+ * tools/replay.cpp, which models channel 1 at the frequency the generator
+ * really runs at; keep this header free of Arduino dependencies.
+ */
+
+#define CW_FSTEP_CLOCK_HZ   8500000     // RTC_FAST_CLK_FREQ_APPROX, nominal RTC fast clock
+
+/**
+ * fstep register value for a requested frequency (truncated, 1..65535)
+ */
+static inline uint32_t cw_fstep(float frequency) {
+    uint32_t freq_step = (uint32_t)((frequency * 65536.0f) / (float)CW_FSTEP_CLOCK_HZ);
+    if (freq_step < 1) freq_step = 1;
+    if (freq_step > 65535) freq_step = 65535;
+    return freq_step;
+}
+
+/**
+ * Frequency an fstep value produces
+ * @return Frequency in Hz
+ */
+static inline float cw_fstep_frequency(uint32_t freq_step) {
+    return (float)CW_FSTEP_CLOCK_HZ * freq_step / 65536.0f;
+}
+
+#endif // CW_FSTEP_H
@@ -0,0 +1,52 @@
+#include "cw_generator.h"
+#include "soc/sens_reg.h"
+#include "soc/rtc.h"
+#include "cw_fstep.h"
+
+static_assert(CW_FSTEP_CLOCK_HZ == RTC_FAST_CLK_FREQ_APPROX, "cw_fstep.h assumes the nominal RTC fast clock");
+
+// SENS_DAC_INVx patterns: 2 = invert MSB (proper sine), 3 = invert all except MSB
+#define CW_INVERT_NORMAL    2
+#define CW_INVERT_INVERTED  3
+
+void cw_generator_set_frequency(float frequency) {
+    SET_PERI_REG_BITS(SENS_SAR_DAC_CTRL1_REG, SENS_SW_FSTEP, cw_fstep(frequency), SENS_SW_FSTEP_S);
+}
+
+float cw_generator_get_frequency() {
+    return cw_fstep_frequency(GET_PERI_REG_BITS2(SENS_SAR_DAC_CTRL1_REG, SENS_SW_FSTEP, SENS_SW_FSTEP_S));
+}
+
+void cw_generator_set_inverted(dac_channel_t channel, bool inverted) {
+    uint32_t invert = inverted ? CW_INVERT_INVERTED : CW_INVERT_NORMAL;
+    if (channel == DAC_CHANNEL_1) {
+        SET_PERI_REG_BITS(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_INV1, invert, SENS_DAC_INV1_S);
+    } else {
+        SET_PERI_REG_BITS(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_INV2, invert, SENS_DAC_INV2_S);
+    }
+}
+
+void cw_generator_enable(dac_channel_t channel, bool inverted) {
+    // Enable tone generator common to both channels
+    SET_PERI_REG_MASK(SENS_SAR_DAC_CTRL1_REG, SENS_SW_TONE_EN);
+    
+    // Connect generator to the channel
+    if (channel == DAC_CHANNEL_1) {
+        SET_PERI_REG_MASK(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_CW_EN1_M);
+    } else {
+        SET_PERI_REG_MASK(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_CW_EN2_M);
+    }
+    
+    // Fix waveform inversion (makes a proper sine)
+    cw_generator_set_inverted(channel, inverted);
+    
+    dac_output_enable(channel);
+}
+
+void cw_generator_disable(dac_channel_t channel) {
+    if (channel == DAC_CHANNEL_1) {
+        CLEAR_PERI_REG_MASK(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_CW_EN1_M);
+    } else {
+        CLEAR_PERI_REG_MASK(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_CW_EN2_M);
+    }
+}
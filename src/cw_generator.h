@@ -0,0 +1,46 @@
+#ifndef CW_GENERATOR_H
+#define CW_GENERATOR_H
+
+#include <Arduino.h>
+#include "driver/dac.h"
+
+/**
+ * Thin register helpers for the ESP32 hardware cosine (CW) generator
+ * The generator is common to both DAC channels; each channel can only
+ * choose whether it is connected and how the output is inverted.
+ */
+
+/**
+ * Set the CW generator frequency
+ * Formula: freq = dig_clk_rtc_freq × SENS_SAR_SW_FSTEP / 65536
+ * @param frequency Frequency in Hz
+ */
+void cw_generator_set_frequency(float frequency);
+
+/**
+ * Frequency the CW generator actually produces, from the programmed fstep
+ * @return Frequency in Hz, quantized to dig_clk_rtc_freq / 65536 (~130 Hz)
+ */
+float cw_generator_get_frequency();
+
+/**
+ * Connect the CW generator to a DAC channel and enable its output
+ * @param channel DAC channel (DAC_CHANNEL_1 or DAC_CHANNEL_2)
+ * @param inverted true to output the generator inverted (180° shifted)
+ */
+void cw_generator_enable(dac_channel_t channel, bool inverted = false);
+
+/**
+ * Change only the inversion of an already connected channel
+ * @param channel DAC channel
+ * @param inverted true to output the generator inverted (180° shifted)
+ */
+void cw_generator_set_inverted(dac_channel_t channel, bool inverted);
+
+/**
+ * Disconnect the CW generator from a DAC channel
+ * @param channel DAC channel
+ */
+void cw_generator_disable(dac_channel_t channel);
+
+#endif // CW_GENERATOR_H
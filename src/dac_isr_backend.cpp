@@ -0,0 +1,77 @@
+#include "dac_isr_backend.h"
+#include "phase_shifted_dac.h"
+#include "cw_generator.h"
+
+bool DacIsrBackend::init_impl(float frequency, phase_t phase) {
+    // Setup Channel 1: Hardware cosine generator (reference)
+    cw_generator_set_frequency(frequency);
+    cw_generator_enable(DAC_CHANNEL_1);
+    
+    // Setup Channel 2: Phase-shifted sine wave using timer interrupt,
+    // at the highest sample rate the measured ISR cost allows
+    return phase_shifted_dac_init(frequency, PHASE_SHIFTED_DAC_AUTO_RATE, phase);
+}
+
+void DacIsrBackend::set_phase_impl(phase_t phase) {
+    phase_shifted_dac_set_phase(phase);
+}
+
+void DacIsrBackend::set_frequency_impl(float frequency) {
+    // Update hardware cosine generator frequency
+    cw_generator_set_frequency(frequency);
+    
+    // Update phase-shifted DAC frequency
+    phase_shifted_dac_set_frequency(frequency);
+}
+
+bool DacIsrBackend::reconfigure_impl(float frequency, phase_t phase) {
+    cw_generator_set_frequency(frequency);
+    phase_shifted_dac_set_phase(phase);
+    
+    // Re-select the rate for the new frequency; switches at a period boundary
+    return phase_shifted_dac_reconfigure(frequency, PHASE_SHIFTED_DAC_AUTO_RATE, nullptr);
+}
+
+bool DacIsrBackend::set_sample_rate_impl(uint32_t sample_rate, uint32_t* applied_rate) {
+    return phase_shifted_dac_reconfigure(phase_shifted_dac_get_frequency(), sample_rate, applied_rate);
+}
+
+void DacIsrBackend::start_impl() {
+    phase_shifted_dac_start();
+}
+
+void DacIsrBackend::stop_impl() {
+    phase_shifted_dac_stop();
+}
+
+void DacIsrBackend::isr_stats_impl(uint32_t* samples, uint32_t* deadline_misses) {
+    phase_shifted_dac_stats_t stats;
+    phase_shifted_dac_get_stats(&stats);
+    *samples = stats.samples;
+    *deadline_misses = stats.deadline_misses;
+}
+
+void DacIsrBackend::scope_snapshot_impl(scope_snapshot_t* snapshot) {
+    phase_shifted_dac_snapshot(snapshot);
+    // Channel 1 is the CW generator on its own clock: model it at its real frequency
+    snapshot->ch1_increment = phase_increment(cw_generator_get_frequency(), snapshot->sample_rate);
+}
+
+void DacIsrBackend::sample_clock_impl(uint32_t* sample_rate, uint32_t* isr_cycles) {
+    phase_shifted_dac_stats_t stats;
+    phase_shifted_dac_get_stats(&stats);
+    *sample_rate = phase_shifted_dac_get_sample_rate();
+    *isr_cycles = stats.isr_cycles_max > stats.isr_cycles_calibrated ? stats.isr_cycles_max
+                                                                    : stats.isr_cycles_calibrated;
+}
+
+bool DacIsrBackend::trim_carrier_impl(int32_t rate_ppb, phase_t sync_offset) {
+    // Channel 2 only: the CW generator on channel 1 steps in ~130 Hz
+    phase_shifted_dac_trim(rate_ppb, sync_offset);
+    return true;
+}
+
+bool DacIsrBackend::read_carrier_impl(phase_t* carrier, int64_t* time_us) {
+    phase_shifted_dac_read_carrier(carrier, time_us);
+    return true;
+}
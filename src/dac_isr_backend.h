@@ -0,0 +1,31 @@
+#ifndef DAC_ISR_BACKEND_H
+#define DAC_ISR_BACKEND_H
+
+#include "waveform_backend.h"
+
+/**
+ * Timer-ISR DAC backend
+ * - Channel 1 (GPIO25): Hardware cosine generator (reference)
+ * - Channel 2 (GPIO26): Sine LUT written from a timer interrupt
+ *   (see phase_shifted_dac.h), phase resolution = LUT size
+ */
+class DacIsrBackend : public WaveformBackend<DacIsrBackend> {
+public:
+    static constexpr const char* NAME = "dac_isr";
+    static constexpr uint32_t PHASE_STEPS = 256;
+
+    bool init_impl(float frequency, phase_t phase);
+    void set_phase_impl(phase_t phase);
+    void set_frequency_impl(float frequency);
+    bool reconfigure_impl(float frequency, phase_t phase);
+    bool set_sample_rate_impl(uint32_t sample_rate, uint32_t* applied_rate);
+    void start_impl();
+    void stop_impl();
+    void isr_stats_impl(uint32_t* samples, uint32_t* deadline_misses);
+    void sample_clock_impl(uint32_t* sample_rate, uint32_t* isr_cycles);
+    void scope_snapshot_impl(scope_snapshot_t* snapshot);
+    bool trim_carrier_impl(int32_t rate_ppb, phase_t sync_offset);
+    bool read_carrier_impl(phase_t* carrier, int64_t* time_us);
+};
+
+#endif // DAC_ISR_BACKEND_H
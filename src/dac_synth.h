@@ -0,0 +1,80 @@
+#ifndef DAC_SYNTH_H
+#define DAC_SYNTH_H
+
+#include <math.h>
+#include <stdint.h>
+#include "phase_units.h"
+
+/**
+ * Sample synthesis shared by the DAC ISR (phase_shifted_dac.cpp) and the
+ * host replay tool, so offline replays produce bit-identical output.
+ * All phase quantities are phase_t turn units (2^32 = 2π).
+ */
+
+#define DAC_SYNTH_LUT_BITS      8
+#define DAC_SYNTH_LUT_SIZE      (1 << DAC_SYNTH_LUT_BITS)
+
+/**
+ * Generate sine lookup table (0-255 for 0-2π)
+ */
+static inline void generate_sine_lut(uint8_t* lut, uint16_t size) {
+    for (uint16_t i = 0; i < size; i++) {
+        float angle = 2.0f * M_PI * i / size;
+        float value = sinf(angle);
+        // Convert from [-1, 1] to [0, 255] for 8-bit DAC
+        lut[i] = (uint8_t)((value + 1.0f) * 127.5f);
+    }
+}
+
+#ifdef DAC_PREDISTORT
+#include "dac_predistort_table.h"
+static_assert(DAC_PREDISTORT_LUT_SIZE == DAC_SYNTH_LUT_SIZE,
+              "regenerate dac_predistort_table.h for this LUT size");
+#endif
+
+/**
+ * Fill the LUT the ISR plays: the plain sine, or with -DDAC_PREDISTORT the
+ * table tools/dac_predistort_gen.cpp built for the measured DAC curve and
+ * transducer harmonic weights. Either way the ISR cost is one table read.
+ */
+static inline void dac_synth_build_lut(uint8_t* lut) {
+#ifdef DAC_PREDISTORT
+    for (uint16_t i = 0; i < DAC_SYNTH_LUT_SIZE; i++) {
+        lut[i] = DAC_PREDISTORT_LUT[i];
+    }
+#else
+    generate_sine_lut(lut, DAC_SYNTH_LUT_SIZE);
+#endif
+}
+
+/**
+ * DAC code for the current carrier phase plus output phase offset
+ */
+static inline uint8_t dac_synth_sample(const uint8_t* lut, uint32_t accumulator, uint32_t offset) {
+    return lut[phase_to_index<DAC_SYNTH_LUT_BITS>(phase_from_turns(accumulator + offset))];
+}
+
+/**
+ * Advance the carrier by one sample
+ * @return true if the accumulator wrapped, i.e. a carrier period just ended;
+ *         staged sample-clock changes are applied only at this boundary
+ */
+static inline bool dac_synth_advance(uint32_t* accumulator, uint32_t increment) {
+    uint32_t previous = *accumulator;
+    *accumulator = previous + increment;
+    return *accumulator < previous;
+}
+
+/**
+ * Fixed sample-rate heuristic: at least 2x the frequency (Nyquist), 2.5x
+ * for good quality. The firmware now calibrates the rate at init; the
+ * replay tool falls back to this for captures without a sample-rate record.
+ */
+static inline uint32_t dac_synth_sample_rate(float frequency) {
+    uint32_t sample_rate = (uint32_t)(frequency * 2.5f);
+    if (sample_rate < 80000) sample_rate = 80000;  // Minimum sample rate
+    if (sample_rate > 200000) sample_rate = 200000;  // Maximum reasonable rate
+    return sample_rate;
+}
+
+#endif // DAC_SYNTH_H
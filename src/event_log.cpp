@@ -0,0 +1,118 @@
+#include "event_log.h"
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// snprintf() with %f needs the headroom
+#define EVENT_LOG_TASK_STACK_SIZE   3072
+// Lowest application priority: logging waits for everything else
+#define EVENT_LOG_TASK_PRIORITY     (tskIDLE_PRIORITY + 1)
+#define EVENT_LOG_LINE_SIZE         160
+
+static_assert((EVENT_LOG_CAPACITY & (EVENT_LOG_CAPACITY - 1)) == 0,
+              "EVENT_LOG_CAPACITY must be a power of two");
+
+typedef struct {
+    uint32_t ready;             // Set by the producer once rec is complete
+    event_log_record_t rec;
+} event_log_slot_t;
+
+static event_log_slot_t g_ring[EVENT_LOG_CAPACITY];
+static uint32_t g_head = 0;     // Slots reserved by producers
+static uint32_t g_tail = 0;     // Slots released by the drain task
+static uint32_t g_logged = 0;
+static uint32_t g_dropped = 0;
+static uint32_t g_drained = 0;
+static uint32_t g_max_depth = 0;
+static TaskHandle_t g_task = nullptr;
+
+bool event_log(event_id_t id, uint32_t a0, uint32_t a1, uint32_t a2) {
+    uint32_t now = micros();
+
+    // Reserve a slot; a CAS instead of a lock, so a preempted producer
+    // never holds up another task
+    uint32_t head = __atomic_load_n(&g_head, __ATOMIC_RELAXED);
+    do {
+        if (head - __atomic_load_n(&g_tail, __ATOMIC_ACQUIRE) >= EVENT_LOG_CAPACITY) {
+            __atomic_fetch_add(&g_dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&g_head, &head, head + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    event_log_slot_t* slot = &g_ring[head & (EVENT_LOG_CAPACITY - 1)];
+    slot->rec.timestamp_us = now;
+    slot->rec.id = (uint16_t)id;
+    slot->rec.reserved = 0;
+    slot->rec.args[0] = a0;
+    slot->rec.args[1] = a1;
+    slot->rec.args[2] = a2;
+    __atomic_store_n(&slot->ready, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&g_logged, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void write_record(const event_log_record_t* rec) {
+#ifdef EVENT_LOG_BINARY
+    uint32_t magic = EVENT_LOG_FRAME_MAGIC;
+    Serial.write((const uint8_t*)&magic, sizeof(magic));
+    Serial.write((const uint8_t*)rec, sizeof(*rec));
+#else
+    char line[EVENT_LOG_LINE_SIZE];
+    size_t len = event_log_format(rec, line, sizeof(line));
+    Serial.write((const uint8_t*)line, len);
+    Serial.write('\n');
+#endif
+}
+
+static void drain_task(void* arg) {
+    uint32_t dropped_reported = 0;
+
+    for (;;) {
+        uint32_t tail = g_tail;
+        uint32_t head = __atomic_load_n(&g_head, __ATOMIC_ACQUIRE);
+        if (head - tail > g_max_depth) {
+            g_max_depth = head - tail;
+        }
+
+        while (tail != head) {
+            event_log_slot_t* slot = &g_ring[tail & (EVENT_LOG_CAPACITY - 1)];
+            if (!__atomic_load_n(&slot->ready, __ATOMIC_ACQUIRE)) {
+                break;  // Reserved but still being filled; next round
+            }
+            event_log_record_t rec = slot->rec;
+            slot->ready = 0;
+            __atomic_store_n(&g_tail, ++tail, __ATOMIC_RELEASE);
+
+            // The UART write may block; the slot is already free by now
+            write_record(&rec);
+            g_drained++;
+        }
+
+        uint32_t dropped = __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+        if (dropped != dropped_reported) {
+            event_log_record_t rec = {};
+            rec.timestamp_us = micros();
+            rec.id = EVENT_LOG_DROPPED;
+            rec.args[0] = dropped - dropped_reported;
+            write_record(&rec);
+            dropped_reported = dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(EVENT_LOG_DRAIN_MS));
+    }
+}
+
+bool event_log_begin() {
+    if (g_task) return true;
+
+    return xTaskCreate(drain_task, "event_log", EVENT_LOG_TASK_STACK_SIZE, nullptr,
+                       EVENT_LOG_TASK_PRIORITY, &g_task) == pdPASS;
+}
+
+void event_log_get_stats(event_log_stats_t* stats) {
+    stats->logged = __atomic_load_n(&g_logged, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+    stats->drained = g_drained;
+    stats->max_depth = g_max_depth;
+}
@@ -0,0 +1,60 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+#include "event_log_format.h"
+
+/**
+ * Deferred asynchronous log
+ *
+ * event_log() stores an event ID, a timestamp and raw 32-bit arguments in
+ * a lock-free ring and returns: no formatting, no UART, no mutex, so it
+ * is cheap enough for phase updates and any task (not ISRs - it reads
+ * micros()). A lowest-priority task drains the ring every
+ * EVENT_LOG_DRAIN_MS and formats the events onto Serial, or with
+ * -DEVENT_LOG_BINARY writes them as binary frames for tools/log_decode.cpp
+ * and never formats on the device at all.
+ *
+ * When the ring is full the event is dropped and counted; the drain task
+ * reports the number lost as an EVENT_LOG_DROPPED event.
+ * The ring is multi-producer, single-consumer.
+ */
+
+#ifndef EVENT_LOG_CAPACITY
+#define EVENT_LOG_CAPACITY 64       // Records, power of two
+#endif
+
+#ifndef EVENT_LOG_DRAIN_MS
+#define EVENT_LOG_DRAIN_MS 10
+#endif
+
+typedef struct {
+    uint32_t logged;            // Events stored
+    uint32_t dropped;           // Events lost to a full ring
+    uint32_t drained;           // Events written out by the drain task
+    uint32_t max_depth;         // Highest ring occupancy seen by the drain task
+} event_log_stats_t;
+
+/**
+ * Start the drain task; events logged before this are kept until it runs
+ * @return true if successful, false otherwise
+ */
+bool event_log_begin();
+
+/**
+ * Record an event; never blocks
+ * @param id Event from EVENT_LOG_EVENTS
+ * @param a0 First argument, typed per the event's format
+ * @param a1 Second argument
+ * @param a2 Third argument
+ * @return false if the ring was full and the event was dropped
+ */
+bool event_log(event_id_t id, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0);
+
+/**
+ * Read log counters
+ * @param stats Filled with the current counters
+ */
+void event_log_get_stats(event_log_stats_t* stats);
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,149 @@
+#ifndef EVENT_LOG_FORMAT_H
+#define EVENT_LOG_FORMAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "phase_units.h"
+
+/**
+ * Deferred log: event table, record and formatter
+ *
+ * Callers only store an event ID and up to EVENT_LOG_MAX_ARGS raw 32-bit
+ * arguments; the text lives here and is applied later, either by the
+ * firmware's drain task or by tools/log_decode.cpp on the host.
+ * Keep this header free of Arduino dependencies.
+ *
+ * Argument types, one letter per conversion in the format:
+ *   u  unsigned integer        d  signed integer (also for %c)
+ *   p  phase_t turns, printed as degrees with a %f conversion
+ *   f  float bits (event_log_float_arg())
+ *
+ * Append new events at the end: captures decoded on the host carry only
+ * the ID.
+ */
+#define EVENT_LOG_EVENTS(X) \
+    X(EVENT_LOG_DROPPED,            "u", "Log: %u events dropped") \
+    X(EVENT_PHASE,                  "p", "Phase: %.1f°") \
+    X(EVENT_TEST_INIT_OK,           "",  "✓ Test mode initialized successfully!\n") \
+    X(EVENT_TEST_INIT_FAILED,       "",  "✗ Failed to initialize test mode!\nCheck your connections and try again.") \
+    X(EVENT_TEST_STARTED,           "",  "Test mode started - waveforms are now active") \
+    X(EVENT_TEST_STOPPED,           "",  "Test mode stopped") \
+    X(EVENT_TEST_SWEEP_STARTED,     "",  "Starting phase sweep test...\nObserve the phase relationship on your oscilloscope.\nPress any key to stop.\n") \
+    X(EVENT_TEST_SWEEP_PHASE,       "u", "Phase: %u°") \
+    X(EVENT_TEST_SWEEP_STOPPED,     "",  "Phase sweep stopped.") \
+    X(EVENT_TEST_PHASE_SET,         "p", "Phase set to: %.2f°") \
+    X(EVENT_TEST_FREQUENCY_SET,     "f", "Frequency set to: %.2f Hz") \
+    X(EVENT_TEST_SAMPLE_RATE_SET,   "u", "Sample rate requested: %u Hz (switches at the next period boundary)") \
+    X(EVENT_TEST_NO_SAMPLE_CLOCK,   "",  "This backend has no software sample clock") \
+    X(EVENT_TEST_UNKNOWN_COMMAND,   "d", "Unknown command: '%c'") \
+    X(EVENT_SYNC_LOCKED,            "du", "Sync: locked to master, rate %d ppb, expected error %u us") \
+    X(EVENT_SYNC_LOST,              "",  "Sync: lock lost") \
+    X(EVENT_SYNC_MOVE,              "pd", "Sync: move to %.1f° applied %d us after its time")
+
+#define EVENT_LOG_ENUM(id, types, format) id,
+typedef enum {
+    EVENT_LOG_EVENTS(EVENT_LOG_ENUM)
+    EVENT_LOG_COUNT
+} event_id_t;
+#undef EVENT_LOG_ENUM
+
+typedef struct {
+    const char* types;
+    const char* format;
+} event_log_format_t;
+
+#define EVENT_LOG_FORMAT_ENTRY(id, types, format) { types, format },
+static const event_log_format_t EVENT_LOG_FORMATS[EVENT_LOG_COUNT] = {
+    EVENT_LOG_EVENTS(EVENT_LOG_FORMAT_ENTRY)
+};
+#undef EVENT_LOG_FORMAT_ENTRY
+
+#define EVENT_LOG_MAX_ARGS 3
+
+/**
+ * One logged event (20 bytes); also the payload of a binary frame
+ */
+typedef struct {
+    uint32_t timestamp_us;      // micros() when logged
+    uint16_t id;                // event_id_t
+    uint16_t reserved;
+    uint32_t args[EVENT_LOG_MAX_ARGS];
+} event_log_record_t;
+
+// Binary sink (EVENT_LOG_BINARY): each record goes out as magic + record, little-endian
+#define EVENT_LOG_FRAME_MAGIC 0x474F4C4CUL     // "LLOG"
+
+static inline uint32_t event_log_float_arg(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * Format one record into a NUL-terminated line (no trailing newline)
+ * Each conversion is handed to snprintf() on its own with the argument
+ * converted per the event's type letter, so one table serves integers,
+ * floats and phases alike.
+ * @param rec Record
+ * @param out Destination
+ * @param size Capacity of out
+ * @return Length written, truncated to size - 1
+ */
+static inline size_t event_log_format(const event_log_record_t* rec, char* out, size_t size) {
+    if (size == 0) return 0;
+    if (rec->id >= EVENT_LOG_COUNT) {
+        snprintf(out, size, "Unknown event %u", (unsigned)rec->id);
+        return strlen(out);
+    }
+
+    const event_log_format_t* entry = &EVENT_LOG_FORMATS[rec->id];
+    const char* p = entry->format;
+    size_t len = 0;
+    unsigned arg = 0;
+
+    while (*p && len + 1 < size) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Copy one conversion spec, e.g. "%.1f", and format it alone
+        char spec[16];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p && !strchr("diucxXfeEgG", *p) && n < sizeof(spec) - 2) {
+            spec[n++] = *p++;
+        }
+        if (*p) spec[n++] = *p++;
+        spec[n] = '\0';
+
+        uint32_t value = arg < EVENT_LOG_MAX_ARGS ? rec->args[arg] : 0;
+        char type = entry->types[arg] ? entry->types[arg] : 'u';
+        if (entry->types[arg]) arg++;
+
+        int written;
+        if (type == 'p') {
+            written = snprintf(out + len, size - len, spec, (double)phase_to_degrees(phase_from_turns(value)));
+        } else if (type == 'f') {
+            float f;
+            memcpy(&f, &value, sizeof(f));
+            written = snprintf(out + len, size - len, spec, (double)f);
+        } else if (type == 'd') {
+            written = snprintf(out + len, size - len, spec, (int)value);
+        } else {
+            written = snprintf(out + len, size - len, spec, (unsigned)value);
+        }
+        if (written < 0) break;
+        len += (size_t)written < size - len ? (size_t)written : size - len - 1;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+#endif // EVENT_LOG_FORMAT_H
@@ -0,0 +1,71 @@
+#include "input_recorder.h"
+#include <Arduino.h>
+
+typedef struct {
+    uint32_t magic;
+    uint32_t total;             // Records ever written; next slot is total % capacity
+    uint32_t check;             // ~(magic ^ total), detects a torn header
+    input_record_t records[INPUT_RECORDER_CAPACITY];
+} recorder_ring_t;
+
+// Not cleared by the bootloader on soft reset
+static RTC_NOINIT_ATTR recorder_ring_t g_ring;
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t header_check() {
+    return ~(g_ring.magic ^ g_ring.total);
+}
+
+static bool ring_valid() {
+    return g_ring.magic == INPUT_RECORDER_MAGIC && g_ring.check == header_check();
+}
+
+void input_recorder_init(uint32_t reset_reason) {
+    if (!ring_valid()) {
+        // Power-on: RTC memory holds garbage
+        g_ring.magic = INPUT_RECORDER_MAGIC;
+        g_ring.total = 0;
+        g_ring.check = header_check();
+    }
+    input_recorder_record(INPUT_SOURCE_BOOT, INPUT_KIND_RESET, reset_reason);
+}
+
+void IRAM_ATTR input_recorder_record(input_source_t source, input_kind_t kind, uint32_t value) {
+    uint32_t now = micros();
+    
+    portENTER_CRITICAL_SAFE(&g_mux);
+    input_record_t* rec = &g_ring.records[g_ring.total % INPUT_RECORDER_CAPACITY];
+    rec->timestamp_us = now;
+    rec->source = (uint8_t)source;
+    rec->kind = (uint8_t)kind;
+    rec->reserved = 0;
+    rec->value = value;
+    g_ring.total++;
+    g_ring.check = header_check();
+    portEXIT_CRITICAL_SAFE(&g_mux);
+}
+
+void input_recorder_get_header(input_export_header_t* header) {
+    portENTER_CRITICAL(&g_mux);
+    header->magic = INPUT_RECORDER_MAGIC;
+    header->version = INPUT_RECORDER_VERSION;
+    header->record_size = sizeof(input_record_t);
+    header->total = g_ring.total;
+    header->count = g_ring.total < INPUT_RECORDER_CAPACITY ? g_ring.total : INPUT_RECORDER_CAPACITY;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+uint32_t input_recorder_read(uint32_t seq, input_record_t* out, uint32_t max) {
+    uint32_t copied = 0;
+    
+    portENTER_CRITICAL(&g_mux);
+    uint32_t oldest = g_ring.total > INPUT_RECORDER_CAPACITY ? g_ring.total - INPUT_RECORDER_CAPACITY : 0;
+    if (seq >= oldest) {
+        for (uint32_t n = seq; n < g_ring.total && copied < max; n++) {
+            out[copied++] = g_ring.records[n % INPUT_RECORDER_CAPACITY];
+        }
+    }
+    portEXIT_CRITICAL(&g_mux);
+    
+    return copied;
+}
@@ -0,0 +1,90 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <stdint.h>
+
+/**
+ * Record of every control input, kept in RTC slow memory
+ *
+ * The ring lives in an RTC_NOINIT section, so it survives a soft reset,
+ * watchdog reset or panic (but not a power cycle) and the setpoint stream
+ * that led to a dropped bead can be exported after the reboot via
+ * GET /record and replayed with tools/replay.cpp.
+ *
+ * This header is also compiled by the host replay tool, keep it free of
+ * Arduino dependencies.
+ */
+
+typedef enum {
+    INPUT_SOURCE_BOOT = 0,      // Restored/default state applied in setup()
+    INPUT_SOURCE_HTTP = 1,      // /set_phase, /set_position
+    INPUT_SOURCE_SERIAL = 2,    // test_mode serial commands
+    INPUT_SOURCE_UDP = 3,       // UDP control port
+    INPUT_SOURCE_SYNC = 4,      // Coordinated move from the rig sync master
+} input_source_t;
+
+typedef enum {
+    INPUT_KIND_RESET = 0,       // Session marker, value = esp_reset_reason()
+    INPUT_KIND_PHASE = 1,       // value = phase_t turns
+    INPUT_KIND_FREQUENCY = 2,   // value = frequency in Hz
+    INPUT_KIND_START = 3,
+    INPUT_KIND_STOP = 4,
+    INPUT_KIND_SAMPLE_RATE = 5, // value = software sample rate in Hz (0 = none)
+    INPUT_KIND_PAD = 255,       // Export filler for records overwritten while streaming
+} input_kind_t;
+
+/**
+ * One recorded input (12 bytes)
+ */
+typedef struct {
+    uint32_t timestamp_us;      // micros() at the time of the input (wraps after ~71 min)
+    uint8_t source;             // input_source_t
+    uint8_t kind;               // input_kind_t
+    uint16_t reserved;
+    uint32_t value;
+} input_record_t;
+
+#define INPUT_RECORDER_MAGIC        0x4345524CUL   // "LREC"
+#define INPUT_RECORDER_VERSION      1
+#define INPUT_RECORDER_CAPACITY     256
+
+/**
+ * Export header, followed by `count` records oldest first
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;             // Records in this export
+    uint32_t total;             // Records ever written; total - count were overwritten
+} input_export_header_t;
+
+/**
+ * Validate the ring left by the previous boot (or clear it) and append a
+ * reset marker
+ * @param reset_reason Reason of the reset that just happened
+ */
+void input_recorder_init(uint32_t reset_reason);
+
+/**
+ * Append one input, overwriting the oldest when full; safe from any task
+ */
+void input_recorder_record(input_source_t source, input_kind_t kind, uint32_t value);
+
+/**
+ * Fill the export header for the current ring contents
+ */
+void input_recorder_get_header(input_export_header_t* header);
+
+/**
+ * Copy records out in order, by absolute sequence number
+ * Record n (0-based since the ring was cleared) stays readable until
+ * record n + INPUT_RECORDER_CAPACITY is written.
+ * @param seq Sequence number of the first record (header.total - header.count = oldest)
+ * @param out Destination
+ * @param max Capacity of out
+ * @return Number of records copied; 0 once seq reaches the newest or was overwritten
+ */
+uint32_t input_recorder_read(uint32_t seq, input_record_t* out, uint32_t max);
+
+#endif // INPUT_RECORDER_H
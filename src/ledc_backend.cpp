@@ -0,0 +1,76 @@
+#include "ledc_backend.h"
+#include <Arduino.h>
+#include "driver/ledc.h"
+
+#define GPIO_CH1                25          // Channel 1 (GPIO 25)
+#define GPIO_CH2                26          // Channel 2 (GPIO 26)
+
+// LEDC PWM Configuration
+#define LEDC_TIMER              LEDC_TIMER_0
+#define LEDC_MODE               LEDC_HIGH_SPEED_MODE
+#define LEDC_CHANNEL_CH1        LEDC_CHANNEL_0
+#define LEDC_CHANNEL_CH2        LEDC_CHANNEL_1
+#define LEDC_DUTY_RES           LEDC_TIMER_10_BIT  // 10-bit for 40 kHz (1024 steps)
+#define LEDC_DUTY_50_PERCENT    512         // 50% duty (1024/2)
+
+static_assert(LedcBackend::PHASE_STEPS == (1 << LEDC_DUTY_RES), "phase steps must match duty resolution");
+
+static void configure_channel(int gpio, ledc_channel_t channel, uint32_t hpoint) {
+    ledc_channel_config_t cfg;
+    cfg.gpio_num = gpio;
+    cfg.speed_mode = LEDC_MODE;
+    cfg.channel = channel;
+    cfg.timer_sel = LEDC_TIMER;
+    cfg.duty = LEDC_DUTY_50_PERCENT;
+    cfg.hpoint = hpoint;
+    cfg.intr_type = LEDC_INTR_DISABLE;
+    ledc_channel_config(&cfg);
+}
+
+bool LedcBackend::init_impl(float frequency, phase_t phase) {
+    // Configure shared timer for both channels (ensures synchronization)
+    ledc_timer_config_t timer_cfg;
+    timer_cfg.speed_mode = LEDC_MODE;
+    timer_cfg.timer_num = LEDC_TIMER;
+    timer_cfg.duty_resolution = LEDC_DUTY_RES;
+    timer_cfg.freq_hz = (uint32_t)frequency;
+    timer_cfg.clk_cfg = LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer_cfg) != ESP_OK) {
+        return false;
+    }
+    
+    m_hpoint = phase_to_steps<PHASE_STEPS>(phase);
+    
+    // Channel 1: Reference, Channel 2: Phase-shiftable
+    configure_channel(GPIO_CH1, LEDC_CHANNEL_CH1, 0);
+    configure_channel(GPIO_CH2, LEDC_CHANNEL_CH2, m_hpoint);
+    
+    // Outputs stay idle until start()
+    stop_impl();
+    return true;
+}
+
+void LedcBackend::set_phase_impl(phase_t phase) {
+    // Convert phase to hpoint: 360° = 1024 steps (full period)
+    // New hpoint is latched by hardware at the next period boundary
+    m_hpoint = phase_to_steps<PHASE_STEPS>(phase);
+    ledc_set_duty_with_hpoint(LEDC_MODE, LEDC_CHANNEL_CH2, LEDC_DUTY_50_PERCENT, m_hpoint);
+    ledc_update_duty(LEDC_MODE, LEDC_CHANNEL_CH2);
+}
+
+void LedcBackend::set_frequency_impl(float frequency) {
+    ledc_set_freq(LEDC_MODE, LEDC_TIMER, (uint32_t)frequency);
+}
+
+void LedcBackend::start_impl() {
+    // ledc_update_duty() re-enables an output that ledc_stop() idled
+    ledc_set_duty_with_hpoint(LEDC_MODE, LEDC_CHANNEL_CH1, LEDC_DUTY_50_PERCENT, 0);
+    ledc_update_duty(LEDC_MODE, LEDC_CHANNEL_CH1);
+    ledc_set_duty_with_hpoint(LEDC_MODE, LEDC_CHANNEL_CH2, LEDC_DUTY_50_PERCENT, m_hpoint);
+    ledc_update_duty(LEDC_MODE, LEDC_CHANNEL_CH2);
+}
+
+void LedcBackend::stop_impl() {
+    ledc_stop(LEDC_MODE, LEDC_CHANNEL_CH1, 0);
+    ledc_stop(LEDC_MODE, LEDC_CHANNEL_CH2, 0);
+}
@@ -0,0 +1,27 @@
+#ifndef LEDC_BACKEND_H
+#define LEDC_BACKEND_H
+
+#include "waveform_backend.h"
+
+/**
+ * LEDC square-wave backend
+ * Channel 1 (GPIO25) and channel 2 (GPIO26) share one LEDC timer, so they
+ * are always synchronized; phase is the channel 2 hpoint (10-bit, 1024 steps).
+ * Square waves are converted to sine by the transducers.
+ */
+class LedcBackend : public WaveformBackend<LedcBackend> {
+public:
+    static constexpr const char* NAME = "ledc";
+    static constexpr uint32_t PHASE_STEPS = 1024;
+
+    bool init_impl(float frequency, phase_t phase);
+    void set_phase_impl(phase_t phase);
+    void set_frequency_impl(float frequency);
+    void start_impl();
+    void stop_impl();
+
+private:
+    uint32_t m_hpoint = 0;
+};
+
+#endif // LEDC_BACKEND_H
@@ -0,0 +1,23 @@
+#ifndef LEVITATION_BACKEND_H
+#define LEVITATION_BACKEND_H
+
+/**
+ * Compile-time selection of the waveform backend
+ * Each PlatformIO env defines exactly one LEVITATION_BACKEND_* flag
+ * (see platformio.ini); LEDC is the default when none is given.
+ */
+#if defined(LEVITATION_BACKEND_DAC_ISR)
+#include "dac_isr_backend.h"
+typedef DacIsrBackend levitation_backend_t;
+#elif defined(LEVITATION_BACKEND_MCPWM)
+#include "mcpwm_backend.h"
+typedef McpwmBackend levitation_backend_t;
+#elif defined(LEVITATION_BACKEND_COSINE)
+#include "cosine_backend.h"
+typedef CosineBackend levitation_backend_t;
+#else
+#include "ledc_backend.h"
+typedef LedcBackend levitation_backend_t;
+#endif
+
+#endif // LEVITATION_BACKEND_H
@@ -1,108 +1,190 @@
 #include "levitation_control.h"
+#include "levitation_backend.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "phase_shifted_dac.h"
-#include "soc/sens_reg.h"
-#include "driver/dac.h"
-#include "soc/rtc.h"
 
 static float g_frequency = 40000.0f;
-static float g_phase_shift = 0.0f;
+static phase_t g_phase_shift = PHASE_ZERO;
 static bool g_initialized = false;
+static bool g_running = false;
+static levitation_backend_t g_backend;
 
-bool levitation_init(float frequency, float initial_phase) {
-    if (g_initialized) {
-        levitation_stop();
+// Serializes every control-plane call (HTTP, serial, control tasks) so the
+// cached state and the backend registers can never disagree
+static StaticSemaphore_t g_lock_buffer;
+static SemaphoreHandle_t g_lock = nullptr;
+static uint32_t g_commands = 0;
+static uint32_t g_contended = 0;
+
+static void lock() {
+    if (!g_lock) return;
+    bool contended = xSemaphoreTake(g_lock, 0) != pdTRUE;
+    if (contended) {
+        xSemaphoreTake(g_lock, portMAX_DELAY);
+    }
+    // Counted under the lock; levitation_get_stats() reads them unlocked
+    g_commands++;
+    if (contended) g_contended++;
+}
+
+static void unlock() {
+    if (g_lock) xSemaphoreGive(g_lock);
+}
+
+bool levitation_init(float frequency, phase_t initial_phase) {
+    if (!g_lock) {
+        g_lock = xSemaphoreCreateMutexStatic(&g_lock_buffer);
     }
     
+    lock();
     g_frequency = frequency;
     g_phase_shift = initial_phase;
     
-    // Calculate frequency step for hardware cosine generator
-    // Formula: freq = dig_clk_rtc_freq × SENS_SAR_SW_FSTEP / 65536
-    // dig_clk_rtc_freq is typically 8 MHz
-    const float rtc_freq = RTC_FAST_CLK_FREQ_APPROX;
-    uint16_t freq_step = (uint16_t)((frequency * 65536.0f) / rtc_freq);
-    if (freq_step < 1) freq_step = 1;
-    if (freq_step > 65535) freq_step = 65535;
-    
-    // Setup Channel 1: Hardware cosine generator (reference)
-    // 1. Enable cosine waveform generator
-    SET_PERI_REG_MASK(SENS_SAR_DAC_CTRL1_REG, SENS_SW_TONE_EN);
-    
-    // 2. Connect generator to DAC channel 1 (GPIO25)
-    SET_PERI_REG_MASK(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_CW_EN1_M);
-    
-    // 3. Set frequency step
-    SET_PERI_REG_BITS(SENS_SAR_DAC_CTRL1_REG, SENS_SW_FSTEP, freq_step, SENS_SW_FSTEP_S);
-    
-    // 4. Fix waveform inversion (makes a proper sine)
-    SET_PERI_REG_BITS(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_INV1, 2, SENS_DAC_INV1_S);
-    
-    // 5. Enable DAC1 output
-    dac_output_enable(DAC_CHANNEL_1);
-    
-    // Setup Channel 2: Phase-shifted sine wave using timer interrupt
-    // Use a sample rate that's at least 2x the frequency (Nyquist)
-    uint32_t sample_rate = (uint32_t)(frequency * 2.5f);  // 2.5x for good quality
-    if (sample_rate < 80000) sample_rate = 80000;  // Minimum sample rate
-    if (sample_rate > 200000) sample_rate = 200000;  // Maximum reasonable rate
-    
-    if (!phase_shifted_dac_init(frequency, sample_rate, initial_phase)) {
-        return false;
+    bool ok;
+    if (g_initialized) {
+        // Reconfigure in place: timers and buffers stay, output keeps running
+        ok = g_backend.reconfigure(frequency, initial_phase);
+    } else {
+        ok = g_backend.init(frequency, initial_phase);
+        g_initialized = ok;
     }
-    
-    g_initialized = true;
-    return true;
+    unlock();
+    return ok;
 }
 
-void levitation_set_phase(float phase_shift) {
-    g_phase_shift = fmodf(phase_shift, 360.0f);
-    if (g_phase_shift < 0) g_phase_shift += 360.0f;
+static void set_phase_locked(phase_t phase_shift) {
+    g_phase_shift = phase_shift;
     
     if (g_initialized) {
-        phase_shifted_dac_set_phase(g_phase_shift);
+        g_backend.set_phase(g_phase_shift);
     }
 }
 
-float levitation_get_phase() {
+void levitation_set_phase(phase_t phase_shift) {
+    lock();
+    set_phase_locked(phase_shift);
+    unlock();
+}
+
+phase_t levitation_get_phase() {
     return g_phase_shift;
 }
 
 void levitation_set_frequency(float frequency) {
+    lock();
     g_frequency = frequency;
     
     if (g_initialized) {
-        // Update hardware cosine generator frequency
-        const float rtc_freq = RTC_FAST_CLK_FREQ_APPROX;
-        uint16_t freq_step = (uint16_t)((frequency * 65536.0f) / rtc_freq);
-        if (freq_step < 1) freq_step = 1;
-        if (freq_step > 65535) freq_step = 65535;
-        SET_PERI_REG_BITS(SENS_SAR_DAC_CTRL1_REG, SENS_SW_FSTEP, freq_step, SENS_SW_FSTEP_S);
-        
-        // Update phase-shifted DAC frequency
-        phase_shifted_dac_set_frequency(frequency);
+        g_backend.set_frequency(frequency);
     }
+    unlock();
 }
 
 float levitation_get_frequency() {
     return g_frequency;
 }
 
-void levitation_start() {
+bool levitation_is_running() {
+    return g_running;
+}
+
+const char* levitation_get_backend_name() {
+    return levitation_backend_t::name();
+}
+
+uint32_t levitation_get_phase_steps() {
+    return levitation_backend_t::phase_steps();
+}
+
+bool levitation_set_sample_rate(uint32_t sample_rate, uint32_t* applied_rate) {
+    *applied_rate = 0;
+    lock();
+    bool ok = g_initialized && g_backend.set_sample_rate(sample_rate, applied_rate);
+    unlock();
+    return ok;
+}
+
+bool levitation_trim_carrier(int32_t rate_ppb, phase_t sync_offset) {
+    lock();
+    bool ok = g_initialized && g_backend.trim_carrier(rate_ppb, sync_offset);
+    unlock();
+    return ok;
+}
+
+bool levitation_read_carrier(phase_t* carrier, int64_t* time_us) {
+    // No lock: the backend pairs the phase and the timestamp itself
+    return g_initialized && g_backend.read_carrier(carrier, time_us);
+}
+
+uint32_t levitation_get_sample_rate() {
+    uint32_t sample_rate, isr_cycles;
+    g_backend.sample_clock(&sample_rate, &isr_cycles);
+    return sample_rate;
+}
+
+uint32_t levitation_get_isr_cycles() {
+    uint32_t sample_rate, isr_cycles;
+    g_backend.sample_clock(&sample_rate, &isr_cycles);
+    return isr_cycles;
+}
+
+float levitation_get_isr_load() {
+    uint32_t sample_rate, isr_cycles;
+    g_backend.sample_clock(&sample_rate, &isr_cycles);
+    if (sample_rate == 0) return 0.0f;
+    float cycles = (float)(isr_cycles + PHASE_SHIFTED_DAC_ISR_OVERHEAD_CYCLES);
+    return 100.0f * cycles * sample_rate / (getCpuFrequencyMhz() * 1000000.0f);
+}
+
+void levitation_get_stats(levitation_stats_t* stats) {
+    stats->commands = g_commands;
+    stats->contended = g_contended;
+    g_backend.isr_stats(&stats->isr_samples, &stats->isr_deadline_misses);
+}
+
+void levitation_get_scope_snapshot(scope_snapshot_t* snapshot) {
+    // Ideal model first: edges at the phase the backend can actually hit
+    uint32_t steps = levitation_backend_t::phase_steps();
+    uint32_t step = phase_to_steps(g_phase_shift, steps);
+    snapshot->waveform = SCOPE_WAVEFORM_SQUARE;
+    snapshot->sample_rate = (uint32_t)(g_frequency * SCOPE_MODEL_SAMPLES_PER_PERIOD);
+    snapshot->accumulator = 0;
+    snapshot->increment = phase_increment(g_frequency, snapshot->sample_rate);
+    snapshot->offset = (uint32_t)(((uint64_t)step << 32) / steps);
+    snapshot->lut = nullptr;
+    snapshot->ch1_increment = 0;
+    
     if (g_initialized) {
-        phase_shifted_dac_start();
+        g_backend.scope_snapshot(snapshot);
     }
 }
 
-void levitation_stop() {
+void levitation_start() {
+    lock();
     if (g_initialized) {
-        phase_shifted_dac_stop();
+        g_backend.start();
+        g_running = true;
     }
+    unlock();
 }
 
-void levitation_move(float direction, float step_size) {
+void levitation_stop() {
+    lock();
     if (g_initialized) {
-        float new_phase = g_phase_shift + (direction * step_size);
-        levitation_set_phase(new_phase);
+        g_backend.stop();
+        g_running = false;
     }
+    unlock();
 }
 
+void levitation_move(int direction, phase_t step_size) {
+    // Read-modify-write under one lock so concurrent moves don't lose steps
+    lock();
+    if (g_initialized && direction != 0) {
+        phase_t new_phase = (direction > 0) ? phase_add(g_phase_shift, step_size)
+                                            : phase_sub(g_phase_shift, step_size);
+        set_phase_locked(new_phase);
+    }
+    unlock();
+}
@@ -2,32 +2,44 @@
 #define LEVITATION_CONTROL_H
 
 #include <Arduino.h>
+#include "phase_units.h"
+#include "scope_frame.h"
+
+/**
+ * All levitation_* calls are thread-safe once levitation_init() has run
+ * (they serialize on a mutex), but must not be called from an ISR.
+ */
 
 /**
  * Initialize acoustic levitation system
- * Sets up both DAC channels:
- * - Channel 1 (GPIO25): Hardware cosine generator (reference)
- * - Channel 2 (GPIO26): Phase-shifted sine wave (controlled)
+ * Sets up both output channels using the backend selected at build time
+ * (see levitation_backend.h):
+ * - Channel 1 (GPIO25): Reference
+ * - Channel 2 (GPIO26): Phase-shifted (controlled)
+ * Outputs stay idle until levitation_start()
+ * Calling it again reconfigures frequency and phase in place: nothing is
+ * torn down and running outputs keep running (sample clock changes take
+ * effect at a carrier period boundary)
  * 
  * @param frequency Ultrasonic frequency in Hz (typically 40000)
- * @param initial_phase Initial phase shift in degrees (0-360)
+ * @param initial_phase Initial phase shift
  * @return true if successful, false otherwise
  */
-bool levitation_init(float frequency, float initial_phase = 0.0f);
+bool levitation_init(float frequency, phase_t initial_phase = PHASE_ZERO);
 
 /**
  * Set phase shift between the two channels
  * This controls the position of pressure nodes in the standing wave
  * 
- * @param phase_shift Phase shift in degrees (0-360)
+ * @param phase_shift Phase shift (wraps naturally at 360°)
  */
-void levitation_set_phase(float phase_shift);
+void levitation_set_phase(phase_t phase_shift);
 
 /**
  * Get current phase shift
- * @return Current phase shift in degrees
+ * @return Current phase shift
  */
-float levitation_get_phase();
+phase_t levitation_get_phase();
 
 /**
  * Set frequency (both channels will use this frequency)
@@ -41,6 +53,91 @@ void levitation_set_frequency(float frequency);
  */
 float levitation_get_frequency();
 
+/**
+ * Get name of the waveform backend compiled into this build
+ * @return Backend name, e.g. "ledc"
+ */
+const char* levitation_get_backend_name();
+
+/**
+ * Get phase resolution of the active backend
+ * @return Distinct phase positions per period
+ */
+uint32_t levitation_get_phase_steps();
+
+/**
+ * Get the software sample rate (0 for backends that generate in hardware)
+ * With the dac_isr backend this is picked at init by measuring the ISR
+ * cost and taking the highest rate within PHASE_SHIFTED_DAC_CPU_BUDGET_PCT
+ * @return Sample rate in Hz
+ */
+uint32_t levitation_get_sample_rate();
+
+/**
+ * Change the software sample rate without stopping the output
+ * The sample ISR switches at the next carrier period boundary, so until
+ * then levitation_get_sample_rate() still returns the old rate
+ * @param sample_rate Sample rate in Hz, 0 to auto-select for the current frequency
+ * @param applied_rate Set to the rate the output switches to: the selected
+ *                     one, rounded to the sample timer; 0 on failure
+ * @return false if the backend generates in hardware or is not initialized
+ */
+bool levitation_set_sample_rate(uint32_t sample_rate, uint32_t* applied_rate);
+
+/**
+ * Discipline the carrier to a sync master (see rig_sync.h)
+ * Only the dac_isr backend has a carrier fine enough to trim, and only
+ * on channel 2; the others keep their free-running timers
+ * @param rate_ppb Rate correction in parts per billion
+ * @param sync_offset Carrier phase correction, absolute
+ * @return false if the backend cannot be trimmed or is not initialized
+ */
+bool levitation_trim_carrier(int32_t rate_ppb, phase_t sync_offset);
+
+/**
+ * Read the free-running carrier phase (without the phase shift) and the
+ * esp_timer_get_time() it was read at
+ * @param carrier Carrier phase
+ * @param time_us Time of the read
+ * @return false if the backend cannot read its carrier or is not initialized
+ */
+bool levitation_read_carrier(phase_t* carrier, int64_t* time_us);
+
+/**
+ * Get worst-case CPU cycles per sample ISR (measured with CCOUNT)
+ * @return Cycles, 0 if the backend has no sample ISR
+ */
+uint32_t levitation_get_isr_cycles();
+
+/**
+ * Get the share of one core spent in the sample ISR, including an
+ * estimate of interrupt entry/exit
+ * @return Load in percent
+ */
+float levitation_get_isr_load();
+
+typedef struct {
+    uint32_t commands;              // Control calls served since boot
+    uint32_t contended;             // Calls that had to wait for another caller
+    uint32_t isr_samples;           // Samples written by the sample ISR (0 if none)
+    uint32_t isr_deadline_misses;   // Late or skipped ISR samples
+} levitation_stats_t;
+
+/**
+ * Read control-plane and ISR counters
+ * @param stats Filled with the current counters
+ */
+void levitation_get_stats(levitation_stats_t* stats);
+
+/**
+ * Snapshot what the outputs are emitting, for the virtual scope
+ * Lock-free and read-only: never delays the control path. Backends
+ * without a software sample clock are modelled at
+ * SCOPE_MODEL_SAMPLES_PER_PERIOD, with the phase quantized to their steps.
+ * @param snapshot Filled in; see scope_frame.h
+ */
+void levitation_get_scope_snapshot(scope_snapshot_t* snapshot);
+
 /**
  * Start levitation system
  */
@@ -51,12 +148,18 @@ void levitation_start();
  */
 void levitation_stop();
 
+/**
+ * Check whether the outputs are running
+ * @return true between levitation_start() and levitation_stop()
+ */
+bool levitation_is_running();
+
 /**
  * Move the levitated object up or down by adjusting phase
  * @param direction Positive = up, negative = down
- * @param step_size Phase change per step in degrees
+ * @param step_size Phase change per step
  */
-void levitation_move(float direction, float step_size = 1.0f);
+void levitation_move(int direction, phase_t step_size = PHASE_ONE_DEGREE);
 
 #endif // LEVITATION_CONTROL_H
 
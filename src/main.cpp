@@ -1,23 +1,24 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
-#include "driver/ledc.h"
 #include "FS.h"
 #include "SPIFFS.h"
+#include "phase_units.h"
+#include "levitation_control.h"
+#include "persistence.h"
+#include "position_map.h"
+#include "input_recorder.h"
+#include "state_stream.h"
+#include "udp_control.h"
+#include "position_loop.h"
+#include "scope_stream.h"
+#include "event_log.h"
+#include "rig_sync.h"
+#include "setpoint.h"
+#include "esp_system.h"
 
 // ===== CONFIG =====
 #define FREQUENCY_HZ            40000UL    // 40 kHz exactly
-#define GPIO_CH1                25          // Channel 1 (GPIO 25)
-#define GPIO_CH2                26          // Channel 2 (GPIO 26)
-
-// LEDC PWM Configuration
-#define LEDC_TIMER              LEDC_TIMER_0
-#define LEDC_MODE               LEDC_HIGH_SPEED_MODE
-#define LEDC_CHANNEL_CH1        LEDC_CHANNEL_0
-#define LEDC_CHANNEL_CH2        LEDC_CHANNEL_1
-#define LEDC_DUTY_RES           LEDC_TIMER_10_BIT  // 10-bit for 40 kHz (1024 steps)
-#define LEDC_DUTY_50_PERCENT    512         // 50% duty (1024/2)
-#define LEDC_MAX_STEPS          1024        // For phase calculation
 
 // Wi-Fi AP credentials
 const char *AP_SSID = "ONDA";
@@ -26,29 +27,6 @@ const char *AP_PASSWORD = "levitate123";
 // ===== GLOBALS =====
 WebServer server(80);
 
-// ===== PHASE CONTROL =====
-void setPhaseDegrees(float degrees) {
-  // Normalize to 0-360
-  while (degrees < 0) degrees += 360.0f;
-  while (degrees >= 360.0f) degrees -= 360.0f;
-  
-  // Convert phase to hpoint: 360° = 1024 steps (full period)
-  uint32_t hpoint = (uint32_t)((degrees / 360.0f) * (float)LEDC_MAX_STEPS + 0.5f);
-  
-  // Reconfigure Channel 2 with new phase
-  ledc_channel_config_t cfg;
-  cfg.gpio_num = GPIO_CH2;
-  cfg.speed_mode = LEDC_MODE;
-  cfg.channel = LEDC_CHANNEL_CH2;
-  cfg.timer_sel = LEDC_TIMER;
-  cfg.duty = LEDC_DUTY_50_PERCENT;
-  cfg.hpoint = hpoint;
-  cfg.intr_type = LEDC_INTR_DISABLE;
-  ledc_channel_config(&cfg);
-  
-  Serial.printf("Phase: %.1f°\n", degrees);
-}
-
 // ===== HTTP HANDLERS =====
 void handleRoot() {
   File file = SPIFFS.open("/index.html", "r");
@@ -66,10 +44,171 @@ void handleSetPhase() {
     return;
   }
 
+  // Float degrees only live at the HTTP boundary
+  float deg = server.arg("deg").toFloat();
+  setpoint_apply_phase(phase_from_degrees(deg), INPUT_SOURCE_HTTP);
+
+  char json[48];
+  snprintf(json, sizeof(json), "{\"success\":true,\"phase\":%.1f}", deg);
+  server.send(200, "application/json", json);
+}
+
+void handleSetPosition() {
+  if (!server.hasArg("mm")) {
+    server.send(400, "application/json", "{\"error\":\"missing mm param\"}");
+    return;
+  }
+
+  // Calibrated trap height -> phase from the standing-wave model table
+  float mm = server.arg("mm").toFloat();
+  phase_t phase = position_map_phase_for_mm(mm);
+  setpoint_apply_phase(phase, INPUT_SOURCE_HTTP);
+
+  char json[64];
+  snprintf(json, sizeof(json), "{\"success\":true,\"mm\":%.2f,\"phase\":%.1f}",
+           mm, phase_to_degrees(phase));
+  server.send(200, "application/json", json);
+}
+
+void handleSyncMove() {
+  if (!server.hasArg("deg")) {
+    server.send(400, "application/json", "{\"error\":\"missing deg param\"}");
+    return;
+  }
+
+  // Lead must cover a few follower polls so every rig hears of the move
   float deg = server.arg("deg").toFloat();
-  setPhaseDegrees(deg);
+  uint32_t lead_ms = server.hasArg("lead_ms") ? server.arg("lead_ms").toInt() : 250;
+  if (!rig_sync_schedule_move(phase_from_degrees(deg), lead_ms)) {
+    server.send(409, "application/json", "{\"error\":\"not the sync master\"}");
+    return;
+  }
+
+  char json[64];
+  snprintf(json, sizeof(json), "{\"success\":true,\"phase\":%.1f,\"lead_ms\":%lu}",
+           deg, (unsigned long)lead_ms);
+  server.send(200, "application/json", json);
+}
 
-  String json = "{\"success\":true,\"phase\":" + String(deg, 1) + "}";
+void handlePositionMap() {
+  // Range plus the raw table (degrees) so clients can map UI positions to mm
+  // (on the loop task stack, not in static DRAM)
+  char json[1024];
+  int len = snprintf(json, sizeof(json),
+                     "{\"frequency\":%.0f,\"min_mm\":%.4f,\"max_mm\":%.4f,\"phase\":[",
+                     position_map_frequency(), position_map_min_mm(), position_map_max_mm());
+  for (uint32_t i = 0; i < position_map_entries() && len < (int)sizeof(json) - 16; i++) {
+    len += snprintf(json + len, sizeof(json) - len, "%s%.2f", i ? "," : "",
+                    phase_to_degrees(position_map_entry(i)));
+  }
+  snprintf(json + len, sizeof(json) - len, "]}");
+  server.send(200, "application/json", json);
+}
+
+void handleLoop() {
+  if (server.hasArg("enable")) {
+    position_loop_enable(server.arg("enable").toInt() != 0);
+  }
+
+  position_loop_stats_t loop;
+  position_loop_get_stats(&loop);
+  char json[160];
+  snprintf(json, sizeof(json),
+           "{\"sensor\":\"%s\",\"enabled\":%s,\"target_mm\":%.3f,"
+           "\"measured_mm\":%.3f,\"correction\":%.2f}",
+           position_loop_get_sensor_name(), position_loop_is_enabled() ? "true" : "false",
+           position_loop_get_target(), loop.measured_mm, loop.correction_deg);
+  server.send(200, "application/json", json);
+}
+
+void handleRecord() {
+  // Binary export: input_export_header_t followed by the records, oldest first
+  input_export_header_t header;
+  input_recorder_get_header(&header);
+
+  server.setContentLength(sizeof(header) + header.count * sizeof(input_record_t));
+  server.sendHeader("Content-Disposition", "attachment; filename=\"record.bin\"");
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char*)&header, sizeof(header));
+
+  input_record_t chunk[32];
+  uint32_t seq = header.total - header.count;
+  uint32_t remaining = header.count;
+  while (remaining > 0) {
+    uint32_t n = input_recorder_read(seq, chunk, remaining < 32 ? remaining : 32);
+    if (n == 0) {
+      // Overwritten while streaming; pad so the length stays consistent.
+      // Zeroed records would read as BOOT/RESET and split the session.
+      n = remaining < 32 ? remaining : 32;
+      memset(chunk, 0, sizeof(chunk));
+      for (uint32_t i = 0; i < n; i++) {
+        chunk[i].kind = INPUT_KIND_PAD;
+      }
+    }
+    server.sendContent((const char*)chunk, n * sizeof(input_record_t));
+    seq += n;
+    remaining -= n;
+  }
+}
+
+void handleStats() {
+  levitation_stats_t stats;
+  levitation_get_stats(&stats);
+  state_stream_stats_t stream;
+  state_stream_get_stats(&stream);
+  udp_control_stats_t udp;
+  udp_control_get_stats(&udp);
+  position_loop_stats_t loop;
+  position_loop_get_stats(&loop);
+  scope_stream_stats_t scope;
+  scope_stream_get_stats(&scope);
+  event_log_stats_t log;
+  event_log_get_stats(&log);
+  rig_sync_stats_t sync;
+  rig_sync_get_stats(&sync);
+
+  char json[1280];
+  snprintf(json, sizeof(json),
+           "{\"commands\":%lu,\"contended\":%lu,\"isr_samples\":%lu,"
+           "\"isr_deadline_misses\":%lu,\"persist_saves\":%lu,\"persist_writes\":%lu,"
+           "\"stream_clients\":%lu,\"stream_frames\":%lu,\"stream_coalesced\":%lu,"
+           "\"stream_dropped\":%lu,\"sample_rate\":%lu,\"isr_cycles\":%lu,"
+           "\"udp_received\":%lu,\"udp_applied\":%lu,\"udp_stale\":%lu,\"udp_superseded\":%lu,"
+           "\"udp_malformed\":%lu,\"udp_sessions\":%lu,"
+           "\"loop_rate\":%lu,\"loop_iterations\":%lu,\"loop_sensor_failures\":%lu,"
+           "\"loop_overruns\":%lu,\"loop_jitter_us\":%lu,\"loop_latency_us\":%lu,"
+           "\"scope_viewers\":%lu,\"scope_frames\":%lu,"
+           "\"log_dropped\":%lu,\"log_max_depth\":%lu,"
+           "\"sync_role\":%u,\"sync_locked\":%s,\"sync_carrier_trimmed\":%s,\"sync_carrier_aligned\":%s,"
+           "\"sync_offset_us\":%lld,\"sync_rate_ppb\":%ld,\"sync_error_us\":%lu,"
+           "\"sync_carrier_correction\":%.2f,\"sync_requests\":%lu,\"sync_exchanges\":%lu,"
+           "\"sync_rejected\":%lu,\"sync_steps\":%lu,\"sync_moves_scheduled\":%lu,"
+           "\"sync_moves_applied\":%lu,\"sync_moves_late\":%lu,\"sync_last_move_late_us\":%ld}",
+           (unsigned long)stats.commands, (unsigned long)stats.contended,
+           (unsigned long)stats.isr_samples, (unsigned long)stats.isr_deadline_misses,
+           (unsigned long)persistence_get_save_count(),
+           (unsigned long)persistence_get_write_count(),
+           (unsigned long)stream.clients, (unsigned long)stream.frames,
+           (unsigned long)stream.coalesced, (unsigned long)stream.dropped,
+           (unsigned long)levitation_get_sample_rate(),
+           (unsigned long)levitation_get_isr_cycles(),
+           (unsigned long)udp.received, (unsigned long)udp.applied,
+           (unsigned long)udp.stale, (unsigned long)udp.superseded,
+           (unsigned long)udp.malformed,
+           (unsigned long)udp.sessions,
+           (unsigned long)loop.rate_hz, (unsigned long)loop.iterations,
+           (unsigned long)loop.sensor_failures, (unsigned long)loop.overruns,
+           (unsigned long)loop.jitter_max_us, (unsigned long)loop.latency_max_us,
+           (unsigned long)scope.viewers, (unsigned long)scope.frames,
+           (unsigned long)log.dropped, (unsigned long)log.max_depth,
+           (unsigned)sync.role, sync.locked ? "true" : "false",
+           sync.carrier_trimmed ? "true" : "false", sync.carrier_aligned ? "true" : "false",
+           (long long)sync.offset_us, (long)sync.rate_ppb, (unsigned long)sync.error_us,
+           sync.carrier_correction * (360.0 / 4294967296.0),
+           (unsigned long)sync.requests, (unsigned long)sync.exchanges,
+           (unsigned long)sync.rejected, (unsigned long)sync.steps,
+           (unsigned long)sync.moves_scheduled, (unsigned long)sync.moves_applied,
+           (unsigned long)sync.moves_late, (long)sync.last_move_late_us);
   server.send(200, "application/json", json);
 }
 
@@ -77,46 +216,51 @@ void handleSetPhase() {
 void setup() {
   Serial.begin(115200);
   delay(500);
-  Serial.println("\n=== 40 kHz PWM Square Wave Generator ===");
-
-  // Configure shared timer for both channels (ensures synchronization)
-  ledc_timer_config_t timer_cfg;
-  timer_cfg.speed_mode = LEDC_MODE;
-  timer_cfg.timer_num = LEDC_TIMER;
-  timer_cfg.duty_resolution = LEDC_DUTY_RES;
-  timer_cfg.freq_hz = FREQUENCY_HZ;
-  timer_cfg.clk_cfg = LEDC_AUTO_CLK;
-  ledc_timer_config(&timer_cfg);
-  
-  // Verify frequency
-  uint32_t actual_freq = ledc_get_freq(LEDC_MODE, LEDC_TIMER);
-  Serial.printf("Frequency: %lu Hz (requested %lu Hz)\n", actual_freq, FREQUENCY_HZ);
-
-  // Channel 1: Reference (GPIO 25)
-  ledc_channel_config_t ch1_cfg;
-  ch1_cfg.gpio_num = GPIO_CH1;
-  ch1_cfg.speed_mode = LEDC_MODE;
-  ch1_cfg.channel = LEDC_CHANNEL_CH1;
-  ch1_cfg.timer_sel = LEDC_TIMER;
-  ch1_cfg.duty = LEDC_DUTY_50_PERCENT;
-  ch1_cfg.hpoint = 0;
-  ch1_cfg.intr_type = LEDC_INTR_DISABLE;
-  ledc_channel_config(&ch1_cfg);
-  Serial.printf("Channel 1 (GPIO %d): Active\n", GPIO_CH1);
-
-  // Channel 2: Phase-shiftable (GPIO 26)
-  ledc_channel_config_t ch2_cfg;
-  ch2_cfg.gpio_num = GPIO_CH2;
-  ch2_cfg.speed_mode = LEDC_MODE;
-  ch2_cfg.channel = LEDC_CHANNEL_CH2;
-  ch2_cfg.timer_sel = LEDC_TIMER;
-  ch2_cfg.duty = LEDC_DUTY_50_PERCENT;
-  ch2_cfg.hpoint = 0;
-  ch2_cfg.intr_type = LEDC_INTR_DISABLE;
-  ledc_channel_config(&ch2_cfg);
-  Serial.printf("Channel 2 (GPIO %d): Active\n", GPIO_CH2);
-
-  Serial.println("40 kHz square waves active!");
+  Serial.println("\n=== 40 kHz Levitation Waveform Generator ===");
+  if (!event_log_begin()) {
+    Serial.println("Event log task failed to start");
+  }
+
+  // Keeps the input history of the previous boot unless this was a power-on
+  input_recorder_init(esp_reset_reason());
+
+  // Restore the last calibrated position, fall back to defaults
+  levitation_state_t state;
+  state.frequency_hz = FREQUENCY_HZ;
+  state.phase = PHASE_ZERO;
+  if (!persistence_init()) {
+    Serial.println("NVS unavailable, state will not be persisted");
+  } else if (persistence_load(&state)) {
+    Serial.printf("Restored state: %lu Hz, %.1f°\n",
+                  (unsigned long)state.frequency_hz, phase_to_degrees(state.phase));
+  }
+
+  // Both channels come from the backend selected by the PlatformIO env
+  if (!levitation_init(state.frequency_hz, state.phase)) {
+    Serial.printf("Backend '%s' failed to initialize\n", levitation_get_backend_name());
+  } else {
+    levitation_start();
+    input_recorder_record(INPUT_SOURCE_BOOT, INPUT_KIND_SAMPLE_RATE, levitation_get_sample_rate());
+    input_recorder_record(INPUT_SOURCE_BOOT, INPUT_KIND_FREQUENCY, state.frequency_hz);
+    input_recorder_record(INPUT_SOURCE_BOOT, INPUT_KIND_PHASE, state.phase.turns);
+    input_recorder_record(INPUT_SOURCE_BOOT, INPUT_KIND_START, 0);
+    Serial.printf("Backend: %s (%lu phase steps)\n",
+                  levitation_get_backend_name(), (unsigned long)levitation_get_phase_steps());
+    Serial.printf("Frequency: %lu Hz\n", (unsigned long)state.frequency_hz);
+    if (levitation_get_sample_rate()) {
+      Serial.printf("Sample rate: %lu Hz (ISR %lu cycles, %.1f%% CPU)\n",
+                    (unsigned long)levitation_get_sample_rate(),
+                    (unsigned long)levitation_get_isr_cycles(), levitation_get_isr_load());
+    }
+    Serial.println("Outputs active on GPIO 25 / GPIO 26!");
+
+    // Closed-loop height control, only if a sensor is compiled in and answers
+    if (position_loop_begin()) {
+      Serial.printf("Position loop: %s sensor at %lu Hz, holding %.2f mm\n",
+                    position_loop_get_sensor_name(), (unsigned long)POSITION_LOOP_RATE_HZ,
+                    position_loop_get_target());
+    }
+  }
 
   // --- SPIFFS (for web interface) ---
   if (!SPIFFS.begin(true)) {
@@ -125,16 +269,57 @@ void setup() {
     Serial.println("SPIFFS mounted successfully.");
     
     // --- Wi-Fi AP ---
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(AP_SSID, AP_PASSWORD);
-    Serial.printf("Wi-Fi started. SSID: %s, IP: %s\n",
-                  AP_SSID, WiFi.softAPIP().toString().c_str());
+    if (rig_sync_get_role() == RIG_SYNC_ROLE_FOLLOWER) {
+      // Own AP on its own subnet for the UI, station on the master's AP for sync
+      char ssid[32];
+      snprintf(ssid, sizeof(ssid), "%s-%d", AP_SSID, RIG_SYNC_RIG_ID);
+      IPAddress ip(192, 168, 4 + RIG_SYNC_RIG_ID, 1);
+      WiFi.mode(WIFI_AP_STA);
+      WiFi.softAPConfig(ip, ip, IPAddress(255, 255, 255, 0));
+      WiFi.softAP(ssid, AP_PASSWORD);
+      WiFi.begin(AP_SSID, AP_PASSWORD);
+      Serial.printf("Wi-Fi started. SSID: %s, IP: %s, joining %s for sync\n",
+                    ssid, WiFi.softAPIP().toString().c_str(), AP_SSID);
+    } else {
+      WiFi.mode(WIFI_AP);
+      WiFi.softAP(AP_SSID, AP_PASSWORD);
+      Serial.printf("Wi-Fi started. SSID: %s, IP: %s\n",
+                    AP_SSID, WiFi.softAPIP().toString().c_str());
+    }
 
     // --- HTTP server ---
     server.on("/", handleRoot);
     server.on("/set_phase", handleSetPhase);
+    server.on("/set_position", handleSetPosition);
+    server.on("/position_map", handlePositionMap);
+    server.on("/loop", handleLoop);
+    server.on("/record", handleRecord);
+    server.on("/stats", handleStats);
+    server.on("/sync_move", handleSyncMove);
     server.begin();
     Serial.println("HTTP server started on port 80.");
+
+    // --- State stream (Server-Sent Events) ---
+    if (state_stream_begin(81)) {
+      Serial.println("State stream started on port 81.");
+    }
+
+    // --- Virtual oscilloscope (chunked binary frames) ---
+    if (scope_stream_begin(82)) {
+      Serial.println("Scope stream started on port 82.");
+    }
+
+    // --- UDP control port ---
+    if (udp_control_begin(UDP_CONTROL_PORT)) {
+      Serial.printf("UDP control port %d open.\n", UDP_CONTROL_PORT);
+    }
+
+    // --- Multi-rig sync (role set at build time) ---
+    if (rig_sync_begin(RIG_SYNC_PORT)) {
+      Serial.printf("Rig sync: %s on UDP port %d.\n",
+                    rig_sync_get_role() == RIG_SYNC_ROLE_MASTER ? "master" : "follower",
+                    RIG_SYNC_PORT);
+    }
   }
 }
 
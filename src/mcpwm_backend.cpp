@@ -0,0 +1,109 @@
+#include "mcpwm_backend.h"
+#include <Arduino.h>
+#include "driver/mcpwm.h"
+#include "soc/mcpwm_struct.h"
+
+#define GPIO_CH1_A              25          // Transducer 1, high side
+#define GPIO_CH1_B              33          // Transducer 1, low side
+#define GPIO_CH2_A              26          // Transducer 2, high side
+#define GPIO_CH2_B              27          // Transducer 2, low side
+
+// Dead-time between complementary edges; override with -DMCPWM_DEADTIME_NS=...
+#ifndef MCPWM_DEADTIME_NS
+#define MCPWM_DEADTIME_NS       200
+#endif
+
+#define MCPWM_UNIT              MCPWM_UNIT_0
+#define MCPWM_TIMER_CH1         MCPWM_TIMER_0
+#define MCPWM_TIMER_CH2         MCPWM_TIMER_1
+
+static_assert(McpwmBackend::PHASE_STEPS == MCPWM_RESOLUTION_HZ / 40000, "phase steps assume 40 kHz");
+
+bool McpwmBackend::init_impl(float frequency, phase_t phase) {
+    mcpwm_timing_t timing = mcpwm_compute_timing(frequency, MCPWM_DEADTIME_NS);
+    m_period_ticks = timing.period_ticks;
+    m_phase = phase;
+    
+    mcpwm_gpio_init(MCPWM_UNIT, MCPWM0A, GPIO_CH1_A);
+    mcpwm_gpio_init(MCPWM_UNIT, MCPWM0B, GPIO_CH1_B);
+    mcpwm_gpio_init(MCPWM_UNIT, MCPWM1A, GPIO_CH2_A);
+    mcpwm_gpio_init(MCPWM_UNIT, MCPWM1B, GPIO_CH2_B);
+    
+    // Run group and timers at full resolution (default 1 MHz gives only 25 ticks at 40 kHz)
+    if (mcpwm_group_set_resolution(MCPWM_UNIT, MCPWM_RESOLUTION_HZ) != ESP_OK) {
+        return false;
+    }
+    mcpwm_timer_set_resolution(MCPWM_UNIT, MCPWM_TIMER_CH1, MCPWM_RESOLUTION_HZ);
+    mcpwm_timer_set_resolution(MCPWM_UNIT, MCPWM_TIMER_CH2, MCPWM_RESOLUTION_HZ);
+    
+    // 50% duty on A; B is generated from A by the dead-time module
+    mcpwm_config_t cfg;
+    cfg.frequency = (uint32_t)frequency;
+    cfg.cmpr_a = 50.0f;
+    cfg.cmpr_b = 50.0f;
+    cfg.duty_mode = MCPWM_DUTY_MODE_0;
+    cfg.counter_mode = MCPWM_UP_COUNTER;
+    if (mcpwm_init(MCPWM_UNIT, MCPWM_TIMER_CH1, &cfg) != ESP_OK ||
+        mcpwm_init(MCPWM_UNIT, MCPWM_TIMER_CH2, &cfg) != ESP_OK) {
+        return false;
+    }
+    
+    // Complementary outputs: B = !A, both edges delayed by the dead-time
+    mcpwm_deadtime_enable(MCPWM_UNIT, MCPWM_TIMER_CH1, MCPWM_ACTIVE_HIGH_COMPLIMENT_MODE,
+                          timing.deadtime_ticks, timing.deadtime_ticks);
+    mcpwm_deadtime_enable(MCPWM_UNIT, MCPWM_TIMER_CH2, MCPWM_ACTIVE_HIGH_COMPLIMENT_MODE,
+                          timing.deadtime_ticks, timing.deadtime_ticks);
+    
+    // Timer 0 is master: sync out at every period start, timer 1 follows it
+    mcpwm_set_timer_sync_output(MCPWM_UNIT, MCPWM_TIMER_CH1, MCPWM_SWSYNC_SOURCE_TEZ);
+    mcpwm_sync_config_t sync_cfg;
+    sync_cfg.sync_sig = MCPWM_SELECT_TIMER0_SYNC;
+    sync_cfg.timer_val = 0;
+    sync_cfg.count_direction = MCPWM_TIMER_DIRECTION_UP;
+    mcpwm_sync_configure(MCPWM_UNIT, MCPWM_TIMER_CH2, &sync_cfg);
+    
+    set_phase_impl(phase);
+    
+    // Outputs stay idle until start()
+    stop_impl();
+    return true;
+}
+
+void McpwmBackend::set_phase_impl(phase_t phase) {
+    m_phase = phase;
+    // The driver only takes per-mille phase; write the counter value directly
+    // for full tick resolution. It is loaded on the next master TEZ sync.
+    MCPWM0.timer[MCPWM_TIMER_CH2].sync.timer_phase = mcpwm_phase_ticks(phase, m_period_ticks);
+}
+
+void McpwmBackend::set_frequency_impl(float frequency) {
+    m_period_ticks = mcpwm_compute_timing(frequency, MCPWM_DEADTIME_NS).period_ticks;
+    mcpwm_set_frequency(MCPWM_UNIT, MCPWM_TIMER_CH1, (uint32_t)frequency);
+    mcpwm_set_frequency(MCPWM_UNIT, MCPWM_TIMER_CH2, (uint32_t)frequency);
+    // Same phase is a different tick count at the new period
+    set_phase_impl(m_phase);
+}
+
+void McpwmBackend::start_impl() {
+    // Release the idle levels stop_impl() forced
+    mcpwm_set_duty_type(MCPWM_UNIT, MCPWM_TIMER_CH1, MCPWM_GEN_A, MCPWM_DUTY_MODE_0);
+    mcpwm_set_duty_type(MCPWM_UNIT, MCPWM_TIMER_CH1, MCPWM_GEN_B, MCPWM_DUTY_MODE_0);
+    mcpwm_set_duty_type(MCPWM_UNIT, MCPWM_TIMER_CH2, MCPWM_GEN_A, MCPWM_DUTY_MODE_0);
+    mcpwm_set_duty_type(MCPWM_UNIT, MCPWM_TIMER_CH2, MCPWM_GEN_B, MCPWM_DUTY_MODE_0);
+    // Slave first, so the first master TEZ aligns it
+    mcpwm_start(MCPWM_UNIT, MCPWM_TIMER_CH2);
+    mcpwm_start(MCPWM_UNIT, MCPWM_TIMER_CH1);
+}
+
+void McpwmBackend::stop_impl() {
+    // mcpwm_stop() alone freezes each pair at whatever level it had, which
+    // can leave one bridge high and the other low: DC across the
+    // transducers. With A forced low the dead-time complement holds every
+    // high side off and every low side on, so all outputs sit at ground.
+    mcpwm_set_signal_low(MCPWM_UNIT, MCPWM_TIMER_CH1, MCPWM_GEN_A);
+    mcpwm_set_signal_low(MCPWM_UNIT, MCPWM_TIMER_CH1, MCPWM_GEN_B);
+    mcpwm_set_signal_low(MCPWM_UNIT, MCPWM_TIMER_CH2, MCPWM_GEN_A);
+    mcpwm_set_signal_low(MCPWM_UNIT, MCPWM_TIMER_CH2, MCPWM_GEN_B);
+    mcpwm_stop(MCPWM_UNIT, MCPWM_TIMER_CH1);
+    mcpwm_stop(MCPWM_UNIT, MCPWM_TIMER_CH2);
+}
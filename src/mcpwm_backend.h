@@ -0,0 +1,68 @@
+#ifndef MCPWM_BACKEND_H
+#define MCPWM_BACKEND_H
+
+#include "waveform_backend.h"
+
+/**
+ * MCPWM complementary drive backend for H-bridge transducer drivers
+ * Each transducer gets a complementary A/B pair with dead-time inserted
+ * by the MCPWM dead-time generator:
+ * - Transducer 1: MCPWM0A (GPIO25) / MCPWM0B (GPIO33), timer 0 (master)
+ * - Transducer 2: MCPWM1A (GPIO26) / MCPWM1B (GPIO27), timer 1
+ * Timer 0 emits a sync pulse at every period start (TEZ); timer 1 reloads
+ * its counter from the phase register on that pulse, so phase updates
+ * take effect exactly at a period boundary without glitches.
+ */
+class McpwmBackend : public WaveformBackend<McpwmBackend> {
+public:
+    static constexpr const char* NAME = "mcpwm";
+    // Timer ticks per period at 40 kHz (resolution / frequency)
+    static constexpr uint32_t PHASE_STEPS = 2000;
+
+    bool init_impl(float frequency, phase_t phase);
+    void set_phase_impl(phase_t phase);
+    void set_frequency_impl(float frequency);
+    void start_impl();
+    void stop_impl();
+
+private:
+    uint32_t m_period_ticks = 0;
+    phase_t m_phase = PHASE_ZERO;
+};
+
+/**
+ * Register values derived from the requested drive settings
+ * Kept free of driver calls so the programming can be checked off-target.
+ */
+typedef struct {
+    uint32_t period_ticks;      // Timer counts per output period
+    uint32_t deadtime_ticks;    // Rising/falling edge delay in group clock counts
+} mcpwm_timing_t;
+
+// Group and timer clock (160 MHz source / 2)
+#define MCPWM_RESOLUTION_HZ     80000000UL
+
+/**
+ * The period is what mcpwm_set_frequency() programs: it takes an integer
+ * frequency and truncates resolution / frequency. Rounding here instead
+ * would put the sync phase one tick past the period at half the
+ * frequencies between 39 and 41 kHz.
+ */
+static inline mcpwm_timing_t mcpwm_compute_timing(float frequency, uint32_t deadtime_ns) {
+    mcpwm_timing_t timing;
+    timing.period_ticks = MCPWM_RESOLUTION_HZ / (uint32_t)frequency;
+    timing.deadtime_ticks = (uint32_t)(((uint64_t)deadtime_ns * MCPWM_RESOLUTION_HZ + 500000000ULL) / 1000000000ULL);
+    return timing;
+}
+
+/**
+ * Counter value loaded into timer 1 on sync for a given phase
+ * Channel 2 lags channel 1 (same convention as the LEDC hpoint), so the
+ * slave restarts period - phase ticks into its cycle.
+ */
+static inline uint32_t mcpwm_phase_ticks(phase_t phase, uint32_t period_ticks) {
+    uint32_t lag = phase_to_steps(phase, period_ticks);
+    return lag == 0 ? 0 : period_ticks - lag;
+}
+
+#endif // MCPWM_BACKEND_H
@@ -0,0 +1,141 @@
+#include "persistence.h"
+#include <Preferences.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define PERSISTENCE_NAMESPACE   "levitator"
+#define PERSISTENCE_KEY         "state"
+#define PERSISTENCE_VERSION     1
+#define WRITER_STACK_SIZE       3072
+#define WRITER_PRIORITY         (tskIDLE_PRIORITY + 1)
+
+typedef struct {
+    uint16_t version;
+    uint16_t size;
+    levitation_state_t state;
+} persisted_record_t;
+
+static Preferences g_prefs;
+static TaskHandle_t g_writer_task = nullptr;
+static uint32_t g_debounce_ms = 2000;
+
+// Shared between persistence_save() callers and the writer task
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static levitation_state_t g_pending;
+static levitation_state_t g_committed;
+static bool g_dirty = false;
+static uint32_t g_last_change_ms = 0;
+
+static uint32_t g_save_count = 0;
+static volatile uint32_t g_write_count = 0;
+
+static void commit(const levitation_state_t* state) {
+    persisted_record_t record;
+    record.version = PERSISTENCE_VERSION;
+    record.size = sizeof(levitation_state_t);
+    record.state = *state;
+    if (g_prefs.putBytes(PERSISTENCE_KEY, &record, sizeof(record)) == sizeof(record)) {
+        g_committed = *state;
+        g_write_count++;
+    }
+}
+
+static void writer_task(void* arg) {
+    (void)arg;
+    
+    while (true) {
+        // Sleep until the first change after the last commit
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        // Wait until the state stops changing for a full debounce interval
+        while (true) {
+            vTaskDelay(pdMS_TO_TICKS(g_debounce_ms));
+            
+            levitation_state_t snapshot;
+            bool dirty;
+            bool settled;
+            portENTER_CRITICAL(&g_mux);
+            dirty = g_dirty;
+            settled = dirty && (millis() - g_last_change_ms >= g_debounce_ms);
+            snapshot = g_pending;
+            if (settled) g_dirty = false;
+            portEXIT_CRITICAL(&g_mux);
+            
+            // Stale notification: already committed by an earlier pass
+            if (!dirty) {
+                break;
+            }
+            
+            if (settled) {
+                // Skip the write when a drag ended where it started
+                if (memcmp(&snapshot, &g_committed, sizeof(snapshot)) != 0) {
+                    commit(&snapshot);
+                }
+                break;
+            }
+        }
+    }
+}
+
+bool persistence_init(uint32_t debounce_ms) {
+    g_debounce_ms = debounce_ms;
+    
+    if (!g_prefs.begin(PERSISTENCE_NAMESPACE, false)) {
+        return false;
+    }
+    
+    if (!g_writer_task) {
+        if (xTaskCreate(writer_task, "persist", WRITER_STACK_SIZE, nullptr,
+                        WRITER_PRIORITY, &g_writer_task) != pdPASS) {
+            g_writer_task = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool persistence_load(levitation_state_t* state) {
+    persisted_record_t record;
+    size_t len = g_prefs.getBytes(PERSISTENCE_KEY, &record, sizeof(record));
+    if (len < offsetof(persisted_record_t, state)) {
+        return false;
+    }
+    // Older firmware wrote a prefix of the current record; newer firmware's
+    // fields would be lost on the next commit, so leave those records alone
+    if (record.version > PERSISTENCE_VERSION || record.size > sizeof(levitation_state_t) ||
+        len != offsetof(persisted_record_t, state) + record.size) {
+        return false;
+    }
+    
+    // Fields the record predates keep the caller's defaults
+    memcpy(state, &record.state, record.size);
+    g_pending = *state;
+    // Only a current-size record counts as committed, so an upgraded one is
+    // rewritten in the new layout at the next change
+    if (record.version == PERSISTENCE_VERSION && record.size == sizeof(levitation_state_t)) {
+        g_committed = *state;
+    }
+    return true;
+}
+
+void persistence_save(const levitation_state_t* state) {
+    portENTER_CRITICAL(&g_mux);
+    g_pending = *state;
+    g_dirty = true;
+    g_last_change_ms = millis();
+    g_save_count++;
+    portEXIT_CRITICAL(&g_mux);
+    
+    if (g_writer_task) {
+        xTaskNotifyGive(g_writer_task);
+    }
+}
+
+uint32_t persistence_get_save_count() {
+    return g_save_count;
+}
+
+uint32_t persistence_get_write_count() {
+    return g_write_count;
+}
@@ -0,0 +1,60 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <Arduino.h>
+#include "phase_units.h"
+
+/**
+ * Debounced persistence of the levitation state in NVS
+ *
+ * persistence_save() only copies the state into RAM and is safe to call on
+ * every setpoint change. A low-priority writer task commits the latest
+ * state once it has been stable for the debounce interval, so a drag in
+ * the UI produces a single flash write instead of hundreds. NVS itself is
+ * log-structured and wear-levelled: each commit appends a new entry and
+ * old pages are recycled by the NVS garbage collector.
+ */
+
+/**
+ * Persisted state record
+ * Append new fields at the end and bump PERSISTENCE_VERSION.
+ */
+typedef struct {
+    uint32_t frequency_hz;
+    phase_t phase;
+} levitation_state_t;
+
+/**
+ * Open the NVS namespace and start the writer task
+ * @param debounce_ms Time the state must be unchanged before it is written
+ * @return true if successful, false otherwise
+ */
+bool persistence_init(uint32_t debounce_ms = 2000);
+
+/**
+ * Restore the last committed state (single NVS read)
+ * A record from an older version fills only the fields it has; the rest
+ * keep the values passed in, so pre-fill the state with defaults.
+ * @param state Defaults in; overwritten by the record on success
+ * @return true if a valid record was found
+ */
+bool persistence_load(levitation_state_t* state);
+
+/**
+ * Record a new state; never touches flash
+ * @param state State to persist once it settles
+ */
+void persistence_save(const levitation_state_t* state);
+
+/**
+ * Number of persistence_save() calls since boot
+ */
+uint32_t persistence_get_save_count();
+
+/**
+ * Number of NVS commits since boot; save_count / write_count is the
+ * write reduction achieved by debouncing
+ */
+uint32_t persistence_get_write_count();
+
+#endif // PERSISTENCE_H
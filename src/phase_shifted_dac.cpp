@@ -1,6 +1,10 @@
 #include "phase_shifted_dac.h"
 #include "driver/dac.h"
 #include "soc/sens_reg.h"
+#include "soc/rtc_io_reg.h"
+#include "dac_synth.h"
+#include "hal/cpu_hal.h"
+#include "driver/timer.h"
 #include <math.h>
 
 // Timer configuration for sample output
@@ -9,29 +13,169 @@
 // In Arduino ESP32 framework, APB frequency is 80 MHz
 #define APB_FREQ 80000000
 #define TIMER_SCALE (APB_FREQ / TIMER_DIVIDER)
+// Arduino timer 0 is hardware timer 0 of group 0
+#define TIMER_NUM 0
+#define TIMER_HW_GROUP TIMER_GROUP_0
+#define TIMER_HW_INDEX TIMER_0
 
 static float g_frequency = 40000.0f;
-static float g_phase_shift = 0.0f;
 static uint32_t g_sample_rate = 80000;
 static bool g_initialized = false;
-static bool g_running = false;
+static volatile bool g_running = false;            // Read by the ISR on the other core
 static hw_timer_t* g_timer = nullptr;
 
 // Use fixed-point arithmetic for ISR (avoid floating point in ISR)
-static volatile uint32_t g_phase_accumulator = 0;  // Fixed point: 0-65535 represents 0-2π
-static volatile uint32_t g_phase_increment = 0;    // Fixed point phase increment
-static uint8_t* g_sine_lut = nullptr;              // Sine lookup table
-static const uint16_t LUT_SIZE = 256;              // Lookup table size
+// Accumulator, increment and offset are all phase_t turn units (2^32 = 2π)
+static volatile uint32_t g_phase_accumulator = 0;  // Free-running carrier phase
+static volatile uint32_t g_phase_increment = 0;    // Carrier phase advance per sample
+static volatile uint32_t g_phase_offset = 0;       // Added on output: user shift + sync offset
+static volatile uint32_t g_user_offset = 0;        // Phase shift relative to the reference
+static volatile uint32_t g_sync_offset = 0;        // Carrier alignment to a sync master
+static volatile int32_t g_trim_ppb = 0;            // Carrier rate trim to a sync master
+static uint8_t* volatile g_sine_lut = nullptr;     // Sine lookup table
+static const uint16_t LUT_SIZE = DAC_SYNTH_LUT_SIZE;  // Lookup table size
+
+// ISR deadline tracking: a sample interval longer than 1.5 periods means
+// at least one sample was late or skipped
+static volatile uint32_t g_isr_samples = 0;
+static volatile uint32_t g_isr_deadline_misses = 0;
+static uint32_t g_isr_last_ccount = 0;
+static uint32_t g_isr_late_cycles = 0;
+static bool g_isr_primed = false;
+
+// ISR cost in CPU cycles (CCOUNT), excluding interrupt entry/exit
+static volatile uint32_t g_isr_cycles_max = 0;
+static uint32_t g_isr_cycles_calibrated = 0;
+// Takes the DAC code and alarm value in place of the registers while
+// calibrating, so the stores still happen but nothing reaches the pad or timer
+static volatile uint32_t g_calibration_sink = 0;
+
+// Sample clock change staged by phase_shifted_dac_reconfigure() and applied
+// by the ISR at the next carrier period boundary, so the timer and LUT stay
+// allocated and the output never stops
+static portMUX_TYPE g_reconfig_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool g_reconfig_pending = false;
+static uint32_t g_staged_increment = 0;
+static uint32_t g_staged_sample_rate = 0;
+static uint32_t g_staged_timer_period = 0;
+static uint32_t g_staged_late_cycles = 0;
+static int64_t g_reconfig_requested_us = 0;
+static bool g_reconfig_measure_gap = false;
+static volatile uint32_t g_reconfigurations = 0;
+static volatile uint32_t g_reconfig_latency_us = 0;
+static volatile uint32_t g_reconfig_gap_cycles = 0;
+
+// Sample rates tried by the startup calibration, highest first; each is a
+// whole number of timer counts, so the timer runs at exactly that rate
+static const uint32_t CANDIDATE_RATES[] = {200000, 156250, 125000, 100000};
+#define CALIBRATION_RUNS 64
+
+/**
+ * Accumulator increment with the sync rate trim applied
+ * About 1 ppb per LSB at 40 kHz / 200 kS/s
+ */
+static uint32_t trimmed_increment(float frequency, uint32_t sample_rate) {
+    uint32_t base = phase_increment(frequency, sample_rate);
+    return base + (uint32_t)(int32_t)(((int64_t)base * g_trim_ppb) / 1000000000LL);
+}
+
+/**
+ * Rate the sample timer actually runs at for a requested rate
+ * The alarm is a whole number of timer counts; the increment must be
+ * computed for this rate, not the requested one, or the carrier is off
+ * by the rounding (0.8% for 160 kS/s, 31 counts instead of 31.25)
+ */
+static uint32_t timer_sample_rate(uint32_t sample_rate) {
+    uint32_t counts = (TIMER_SCALE + sample_rate / 2) / sample_rate;
+    if (counts < 1) counts = 1;
+    return TIMER_SCALE / counts;
+}
 
 /**
- * Generate sine lookup table (0-255 for 0-2π)
+ * Output one sample and advance the carrier
+ * Writes the DAC2 pad register directly instead of going through dacWrite()
+ * @param live false for the startup calibration: the code goes to
+ *             g_calibration_sink and the pad keeps its level
+ * @return true at the end of a carrier period
  */
-void generate_sine_lut(uint8_t* lut, uint16_t size) {
-    for (uint16_t i = 0; i < size; i++) {
-        float angle = 2.0f * M_PI * i / size;
-        float value = sinf(angle);
-        // Convert from [-1, 1] to [0, 255] for 8-bit DAC
-        lut[i] = (uint8_t)((value + 1.0f) * 127.5f);
+static inline bool IRAM_ATTR output_sample(bool live) {
+    // Get sample from lookup table using fixed-point phase
+    uint8_t dac_value = dac_synth_sample(g_sine_lut, g_phase_accumulator, g_phase_offset);
+    
+    // Output to DAC channel 2 (GPIO26)
+    if (live) {
+        SET_PERI_REG_BITS(RTC_IO_PAD_DAC2_REG, RTC_IO_PDAC2_DAC, dac_value, RTC_IO_PDAC2_DAC_S);
+    } else {
+        g_calibration_sink = dac_value;
+    }
+    
+    // Update phase accumulator (fixed point), wraps at 2^32 (2π)
+    uint32_t accumulator = g_phase_accumulator;
+    bool wrapped = dac_synth_advance(&accumulator, g_phase_increment);
+    g_phase_accumulator = accumulator;
+    return wrapped;
+}
+
+/**
+ * Switch to the staged sample clock; caller holds g_reconfig_mux
+ */
+static inline void IRAM_ATTR apply_staged_clock() {
+    g_phase_increment = g_staged_increment;
+    g_sample_rate = g_staged_sample_rate;
+    g_isr_late_cycles = g_staged_late_cycles;
+    g_reconfig_pending = false;
+    g_reconfigurations++;
+}
+
+/**
+ * One sample: deadline tracking, output, and at a carrier period boundary
+ * the staged clock change
+ * @param live true in timer_isr(); false for the startup calibration, which
+ *             runs in task context: no pad or alarm register writes, and
+ *             the task form of the critical section
+ */
+static inline void IRAM_ATTR run_sample(bool live) {
+    uint32_t now = cpu_hal_get_cycle_count();
+    if (g_isr_primed && (now - g_isr_last_ccount) > g_isr_late_cycles) {
+        g_isr_deadline_misses++;
+    }
+    if (g_reconfig_measure_gap) {
+        // First sample on the new clock: interval since the last old-clock sample
+        g_reconfig_gap_cycles = now - g_isr_last_ccount;
+        g_reconfig_measure_gap = false;
+    }
+    g_isr_last_ccount = now;
+    g_isr_primed = true;
+    g_isr_samples++;
+    
+    if (output_sample(live) && g_reconfig_pending) {
+        if (live) {
+            portENTER_CRITICAL_ISR(&g_reconfig_mux);
+        } else {
+            portENTER_CRITICAL(&g_reconfig_mux);
+        }
+        if (g_reconfig_pending) {
+            // Auto-reload already restarted the count, so the new alarm
+            // sets the very next sample interval
+            if (live) {
+                timer_group_set_alarm_value_in_isr(TIMER_HW_GROUP, TIMER_HW_INDEX, g_staged_timer_period);
+            } else {
+                g_calibration_sink = g_staged_timer_period;
+            }
+            apply_staged_clock();
+            g_reconfig_latency_us = (uint32_t)(esp_timer_get_time() - g_reconfig_requested_us);
+            g_reconfig_measure_gap = true;
+        }
+        if (live) {
+            portEXIT_CRITICAL_ISR(&g_reconfig_mux);
+        } else {
+            portEXIT_CRITICAL(&g_reconfig_mux);
+        }
+    }
+    
+    uint32_t cycles = cpu_hal_get_cycle_count() - now;
+    if (cycles > g_isr_cycles_max) {
+        g_isr_cycles_max = cycles;
     }
 }
 
@@ -41,34 +185,86 @@ void generate_sine_lut(uint8_t* lut, uint16_t size) {
  */
 void IRAM_ATTR timer_isr() {
     if (!g_running || !g_sine_lut) return;
+    run_sample(true);
+}
+
+/**
+ * Worst-case cycles of one sample over a burst of synchronous runs
+ * Every run takes the slowest path: deadline check, a carrier period
+ * boundary with a staged clock change (esp_timer read), the gap
+ * measurement the change arms for the next sample, and the max tracking.
+ * Runs before start() in task context, so it uses run_sample(false): the
+ * DAC code and alarm value are stored to RAM instead of the pad and timer
+ * registers, which keeps the output at its idle level. All sample state is
+ * reset afterwards.
+ */
+static uint32_t measure_isr_cycles() {
+    uint32_t worst = 0;
+    g_isr_primed = true;
+    g_isr_late_cycles = UINT32_MAX;
+    for (int i = 0; i < CALIBRATION_RUNS; i++) {
+        // The next sample wraps the carrier and applies a staged change
+        g_phase_accumulator = UINT32_MAX;
+        g_phase_increment = 1;
+        g_staged_increment = 1;
+        g_staged_sample_rate = g_sample_rate;
+        g_staged_timer_period = TIMER_SCALE / g_sample_rate;
+        g_staged_late_cycles = UINT32_MAX;
+        g_reconfig_pending = true;
+        
+        uint32_t start = cpu_hal_get_cycle_count();
+        run_sample(false);
+        uint32_t cycles = cpu_hal_get_cycle_count() - start;
+        if (cycles > worst) worst = cycles;
+    }
     
-    // Get sample from lookup table using fixed-point phase
-    uint8_t lut_index = (g_phase_accumulator >> 8) & 0xFF;  // Use upper 8 bits for LUT index
-    uint8_t dac_value = g_sine_lut[lut_index];
-    
-    // Output to DAC channel 2 (GPIO26)
-    dacWrite(26, dac_value);
+    g_phase_accumulator = 0;
+    g_reconfig_pending = false;
+    g_reconfig_measure_gap = false;
+    g_isr_primed = false;
+    g_isr_samples = 0;
+    g_isr_deadline_misses = 0;
+    g_isr_cycles_max = 0;
+    g_reconfigurations = 0;
+    g_reconfig_latency_us = 0;
+    return worst;
+}
+
+/**
+ * Highest candidate rate whose ISR load fits the CPU budget
+ * Falls back to the lowest rate that still satisfies Nyquist.
+ */
+static uint32_t select_sample_rate(float frequency, uint32_t isr_cycles) {
+    const uint64_t cpu_hz = (uint64_t)getCpuFrequencyMhz() * 1000000ULL;
+    const uint64_t cost = isr_cycles + PHASE_SHIFTED_DAC_ISR_OVERHEAD_CYCLES;
+    uint32_t fallback = 0;
     
-    // Update phase accumulator (fixed point)
-    g_phase_accumulator += g_phase_increment;
-    // Phase accumulator wraps at 65536 (2π in fixed point)
+    for (size_t i = 0; i < sizeof(CANDIDATE_RATES) / sizeof(CANDIDATE_RATES[0]); i++) {
+        uint32_t rate = CANDIDATE_RATES[i];
+        if (rate < 2.0f * frequency) continue;  // Nyquist
+        fallback = rate;
+        if (cost * rate * 100 <= cpu_hz * PHASE_SHIFTED_DAC_CPU_BUDGET_PCT) {
+            return rate;
+        }
+    }
+    return fallback ? fallback : CANDIDATE_RATES[0];
 }
 
-bool phase_shifted_dac_init(float frequency, uint32_t sample_rate, float phase_shift) {
+bool phase_shifted_dac_init(float frequency, uint32_t sample_rate, phase_t phase_shift) {
     if (g_initialized) {
-        phase_shifted_dac_deinit();
+        // Keep the timer, LUT and running output; only the clock changes
+        phase_shifted_dac_set_phase(phase_shift);
+        return phase_shifted_dac_reconfigure(frequency, sample_rate, nullptr);
     }
     
     g_frequency = frequency;
-    g_phase_shift = phase_shift;
-    g_sample_rate = sample_rate;
     
-    // Allocate and generate sine lookup table
+    // Allocate and fill the sine lookup table (predistorted if configured)
     g_sine_lut = (uint8_t*)malloc(LUT_SIZE);
     if (!g_sine_lut) {
         return false;
     }
-    generate_sine_lut(g_sine_lut, LUT_SIZE);
+    dac_synth_build_lut(g_sine_lut);
     
     // Disable hardware cosine generator on channel 2 (we'll use timer interrupt instead)
     CLEAR_PERI_REG_MASK(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_CW_EN2_M);
@@ -76,25 +272,37 @@ bool phase_shifted_dac_init(float frequency, uint32_t sample_rate, float phase_s
     // Enable DAC channel 2
     dac_output_enable(DAC_CHANNEL_2);
     
-    // Initialize phase accumulator with phase shift (fixed point: 65536 = 2π)
-    const uint32_t fixed_two_pi = 65536;
-    g_phase_accumulator = (uint32_t)((phase_shift / 360.0f) * fixed_two_pi) % fixed_two_pi;
+    // Start the carrier at 0 and apply the phase shift as an output offset
+    g_phase_accumulator = 0;
+    g_user_offset = phase_to_accumulator(phase_shift);
+    g_phase_offset = g_user_offset + g_sync_offset;
     
-    // Calculate phase increment (fixed point)
-    // phase_increment = (2π * frequency / sample_rate) * (65536 / 2π) = frequency * 65536 / sample_rate
-    g_phase_increment = (uint32_t)((frequency * 65536.0f) / sample_rate);
-    
-    // Configure timer for sample output
-    g_timer = timerBegin(0, TIMER_DIVIDER, true);
+    // Configure timer for sample output; the calibration below programs its alarm
+    g_timer = timerBegin(TIMER_NUM, TIMER_DIVIDER, true);
     if (!g_timer) {
         free(g_sine_lut);
         g_sine_lut = nullptr;
         return false;
     }
     
+    // Measure what one sample costs on this chip/clock, then pick the rate
+    g_isr_cycles_calibrated = measure_isr_cycles();
+    if (sample_rate == PHASE_SHIFTED_DAC_AUTO_RATE) {
+        sample_rate = select_sample_rate(frequency, g_isr_cycles_calibrated);
+    }
+    sample_rate = timer_sample_rate(sample_rate);
+    g_sample_rate = sample_rate;
+    
+    // Calculate phase increment (fixed point)
+    // phase_increment = (2π * frequency / sample_rate) * (2^32 / 2π) = frequency * 2^32 / sample_rate
+    g_phase_increment = trimmed_increment(frequency, sample_rate);
+    
+
     // Calculate timer period (in timer counts)
     // Timer runs at TIMER_SCALE Hz, we need sample_rate interrupts per second
     uint64_t timer_period = TIMER_SCALE / sample_rate;
+    uint32_t period_cycles = getCpuFrequencyMhz() * 1000000UL / sample_rate;
+    g_isr_late_cycles = period_cycles + period_cycles / 2;
     timerAlarmWrite(g_timer, timer_period, true);  // true = auto-reload
     timerAttachInterrupt(g_timer, &timer_isr, true);  // true = edge trigger
     timerWrite(g_timer, 0);
@@ -103,28 +311,84 @@ bool phase_shifted_dac_init(float frequency, uint32_t sample_rate, float phase_s
     return true;
 }
 
-void phase_shifted_dac_set_phase(float phase_shift) {
-    g_phase_shift = fmodf(phase_shift, 360.0f);
-    if (g_phase_shift < 0) g_phase_shift += 360.0f;
-    
-    if (g_initialized) {
-        // Update phase accumulator with new phase shift (fixed point: 65536 = 2π)
-        const uint32_t fixed_two_pi = 65536;
-        g_phase_accumulator = (uint32_t)((g_phase_shift / 360.0f) * fixed_two_pi) % fixed_two_pi;
-    }
+void IRAM_ATTR phase_shifted_dac_set_phase(phase_t phase_shift) {
+    // Offset is applied on output, so the carrier keeps running continuously
+    g_user_offset = phase_to_accumulator(phase_shift);
+    g_phase_offset = g_user_offset + g_sync_offset;
 }
 
 void phase_shifted_dac_set_frequency(float frequency) {
+    if (!g_initialized) {
+        g_frequency = frequency;
+        return;
+    }
+    
+    // Same sample rate (or the one already staged), new increment
+    portENTER_CRITICAL(&g_reconfig_mux);
+    uint32_t sample_rate = g_reconfig_pending ? g_staged_sample_rate : g_sample_rate;
+    portEXIT_CRITICAL(&g_reconfig_mux);
+    phase_shifted_dac_reconfigure(frequency, sample_rate, nullptr);
+}
+
+bool phase_shifted_dac_reconfigure(float frequency, uint32_t sample_rate, uint32_t* staged_rate) {
+    if (!g_initialized) {
+        return false;
+    }
+    if (sample_rate == PHASE_SHIFTED_DAC_AUTO_RATE) {
+        sample_rate = select_sample_rate(frequency, g_isr_cycles_calibrated);
+    }
+    sample_rate = timer_sample_rate(sample_rate);
+    uint32_t period_cycles = getCpuFrequencyMhz() * 1000000UL / sample_rate;
+    if (staged_rate) *staged_rate = sample_rate;
+    
+    portENTER_CRITICAL(&g_reconfig_mux);
     g_frequency = frequency;
+    g_staged_increment = trimmed_increment(frequency, sample_rate);
+    g_staged_sample_rate = sample_rate;
+    g_staged_timer_period = TIMER_SCALE / sample_rate;
+    g_staged_late_cycles = period_cycles + period_cycles / 2;
+    g_reconfig_requested_us = esp_timer_get_time();
     
+    bool defer = g_running;
+    if (!defer) {
+        // Timer is idle: nothing to line up with
+        timerAlarmWrite(g_timer, g_staged_timer_period, true);
+        apply_staged_clock();
+        g_reconfig_latency_us = 0;
+    } else {
+        g_reconfig_pending = true;
+    }
+    portEXIT_CRITICAL(&g_reconfig_mux);
+    return true;
+}
+
+void phase_shifted_dac_trim(int32_t rate_ppb, phase_t sync_offset) {
+    portENTER_CRITICAL(&g_reconfig_mux);
+    g_trim_ppb = rate_ppb;
     if (g_initialized) {
-        // Recalculate phase increment (fixed point)
-        g_phase_increment = (uint32_t)((frequency * 65536.0f) / g_sample_rate);
+        // A staged clock change carries the trim; otherwise a tiny rate
+        // change needs no period boundary and takes effect right away
+        if (g_reconfig_pending) {
+            g_staged_increment = trimmed_increment(g_frequency, g_staged_sample_rate);
+        } else {
+            g_phase_increment = trimmed_increment(g_frequency, g_sample_rate);
+        }
     }
+    g_sync_offset = phase_to_accumulator(sync_offset);
+    g_phase_offset = g_user_offset + g_sync_offset;
+    portEXIT_CRITICAL(&g_reconfig_mux);
+}
+
+void phase_shifted_dac_read_carrier(phase_t* carrier, int64_t* time_us) {
+    portENTER_CRITICAL(&g_reconfig_mux);
+    *carrier = phase_from_turns(g_phase_accumulator + g_sync_offset);
+    *time_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&g_reconfig_mux);
 }
 
 void phase_shifted_dac_start() {
     if (g_initialized && g_timer && !g_running) {
+        g_isr_primed = false;
         g_running = true;
         timerAlarmEnable(g_timer);
     }
@@ -134,6 +398,15 @@ void phase_shifted_dac_stop() {
     if (g_timer && g_running) {
         g_running = false;
         timerAlarmDisable(g_timer);
+        
+        // No period boundary will come; apply a staged change now
+        portENTER_CRITICAL(&g_reconfig_mux);
+        if (g_reconfig_pending) {
+            timerAlarmWrite(g_timer, g_staged_timer_period, true);
+            apply_staged_clock();
+            g_reconfig_latency_us = (uint32_t)(esp_timer_get_time() - g_reconfig_requested_us);
+        }
+        portEXIT_CRITICAL(&g_reconfig_mux);
     }
 }
 
@@ -147,11 +420,41 @@ void phase_shifted_dac_deinit() {
     }
     
     if (g_sine_lut) {
-        free(g_sine_lut);
+        // Unpublish before freeing so a late ISR never reads freed memory
+        uint8_t* lut = g_sine_lut;
         g_sine_lut = nullptr;
+        free(lut);
     }
     
     g_initialized = false;
     g_running = false;
+    g_reconfig_pending = false;
 }
 
+void phase_shifted_dac_get_stats(phase_shifted_dac_stats_t* stats) {
+    stats->samples = g_isr_samples;
+    stats->deadline_misses = g_isr_deadline_misses;
+    stats->isr_cycles_calibrated = g_isr_cycles_calibrated;
+    stats->isr_cycles_max = g_isr_cycles_max;
+    stats->reconfigurations = g_reconfigurations;
+    stats->reconfig_latency_us = g_reconfig_latency_us;
+    stats->reconfig_gap_cycles = g_reconfig_gap_cycles;
+}
+
+void phase_shifted_dac_snapshot(scope_snapshot_t* snapshot) {
+    snapshot->waveform = SCOPE_WAVEFORM_SINE_LUT;
+    snapshot->sample_rate = g_sample_rate;
+    snapshot->accumulator = g_phase_accumulator;
+    snapshot->increment = g_phase_increment;
+    snapshot->offset = g_phase_offset;
+    snapshot->lut = g_sine_lut;
+    snapshot->ch1_increment = 0;
+}
+
+float phase_shifted_dac_get_frequency() {
+    return g_frequency;
+}
+
+uint32_t phase_shifted_dac_get_sample_rate() {
+    return g_initialized ? g_sample_rate : 0;
+}
@@ -4,6 +4,23 @@
 #include <Arduino.h>
 #include "driver/dac.h"
 #include <stdint.h>
+#include "phase_units.h"
+#include "scope_frame.h"
+
+// Share of one core the sample ISR may use when the rate is auto-selected
+#ifndef PHASE_SHIFTED_DAC_CPU_BUDGET_PCT
+#define PHASE_SHIFTED_DAC_CPU_BUDGET_PCT 25
+#endif
+
+// Interrupt entry/exit and timer driver dispatch, not visible to CCOUNT in the
+// ISR, plus the peripheral-bus cost of the DAC and alarm register writes,
+// which the calibration makes to RAM
+#ifndef PHASE_SHIFTED_DAC_ISR_OVERHEAD_CYCLES
+#define PHASE_SHIFTED_DAC_ISR_OVERHEAD_CYCLES 300
+#endif
+
+// Pass as sample_rate to let init calibrate and pick the rate
+#define PHASE_SHIFTED_DAC_AUTO_RATE 0
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,26 +29,66 @@ extern "C" {
 /**
  * Initialize DMA-based phase-shifted sine wave generator on DAC channel 2
  * Channel 1 should use hardware cosine generator as reference
+ * If already initialized, the timer and LUT are kept and this is
+ * equivalent to set_phase() followed by reconfigure()
  * 
  * @param frequency Frequency in Hz (typically 40000 for ultrasonic)
- * @param sample_rate Sample rate for DMA (typically 80000 or higher)
- * @param phase_shift Phase shift in degrees (0-360)
+ * @param sample_rate Sample rate in Hz, or PHASE_SHIFTED_DAC_AUTO_RATE to measure
+ *                    the ISR cost and use the highest rate within
+ *                    PHASE_SHIFTED_DAC_CPU_BUDGET_PCT
+ * @param phase_shift Phase shift relative to the reference channel
  * @return true if successful, false otherwise
  */
-bool phase_shifted_dac_init(float frequency, uint32_t sample_rate, float phase_shift);
+bool phase_shifted_dac_init(float frequency, uint32_t sample_rate, phase_t phase_shift);
 
 /**
  * Update the phase shift of the DMA-generated sine wave
- * @param phase_shift Phase shift in degrees (0-360)
+ * Single-word store, safe to call from ISR context
+ * @param phase_shift Phase shift relative to the reference channel
  */
-void phase_shifted_dac_set_phase(float phase_shift);
+void phase_shifted_dac_set_phase(phase_t phase_shift);
 
 /**
  * Update the frequency of the DMA-generated sine wave
+ * Keeps the current sample rate; applied like reconfigure()
  * @param frequency Frequency in Hz
  */
 void phase_shifted_dac_set_frequency(float frequency);
 
+/**
+ * Change frequency, sample rate and timer period in place
+ * While running, the change is staged and the ISR switches to it at the
+ * next carrier period boundary (accumulator wrap), so the output never
+ * stops and no period is cut short; when stopped it applies immediately.
+ * @param frequency Frequency in Hz
+ * @param sample_rate Sample rate in Hz, or PHASE_SHIFTED_DAC_AUTO_RATE to
+ *                    re-select from the calibration done at init
+ * @param staged_rate Set to the rate the timer will run at: the selected
+ *                    one, rounded to whole timer counts; may be nullptr
+ * @return true if successful, false if not initialized
+ */
+bool phase_shifted_dac_reconfigure(float frequency, uint32_t sample_rate, uint32_t* staged_rate);
+
+/**
+ * Discipline the carrier to a sync master (see rig_sync.h)
+ * Scales the accumulator increment by 1 + rate_ppb / 1e9 and adds
+ * sync_offset to the output on top of the phase shift. Only channel 2 is
+ * trimmed: the CW generator on channel 1 has no fine frequency control.
+ * @param rate_ppb Rate correction in parts per billion
+ * @param sync_offset Carrier phase correction (absolute, replaces the last one)
+ */
+void phase_shifted_dac_trim(int32_t rate_ppb, phase_t sync_offset);
+
+/**
+ * Read the carrier phase together with the time it was read
+ * Accumulator plus sync offset, without the phase shift: what a sync
+ * master publishes and a follower compares against. Uncertain by one
+ * sample period, since the ISR may run on the other core.
+ * @param carrier Carrier phase
+ * @param time_us esp_timer_get_time() at the read
+ */
+void phase_shifted_dac_read_carrier(phase_t* carrier, int64_t* time_us);
+
 /**
  * Start the DMA-based sine wave output
  */
@@ -47,6 +104,42 @@ void phase_shifted_dac_stop();
  */
 void phase_shifted_dac_deinit();
 
+typedef struct {
+    uint32_t samples;           // Samples written by the ISR since boot
+    uint32_t deadline_misses;   // ISR intervals longer than 1.5 sample periods
+    uint32_t isr_cycles_calibrated; // Worst-case cycles of the whole ISR body, measured at init
+    uint32_t isr_cycles_max;    // Worst-case cycles per sample seen by the running ISR
+    uint32_t reconfigurations;  // Sample clock changes applied
+    uint32_t reconfig_latency_us; // Last change: request to switch (≤ one carrier period)
+    uint32_t reconfig_gap_cycles; // Last change: sample interval across the switch
+} phase_shifted_dac_stats_t;
+
+/**
+ * Read the ISR counters
+ * @param stats Filled with the current counters
+ */
+void phase_shifted_dac_get_stats(phase_shifted_dac_stats_t* stats);
+
+/**
+ * Capture the generator state for the virtual scope
+ * Plain word reads, no lock and nothing copied from the LUT: the carrier
+ * may advance between reads, which only moves the starting sample.
+ * @param snapshot Filled with a SINE_LUT snapshot pointing at the live LUT
+ */
+void phase_shifted_dac_snapshot(scope_snapshot_t* snapshot);
+
+/**
+ * Frequency most recently requested
+ * @return Frequency in Hz
+ */
+float phase_shifted_dac_get_frequency();
+
+/**
+ * Sample rate in use (after auto-selection and rounding to whole timer counts)
+ * @return Sample rate in Hz, 0 if not initialized
+ */
+uint32_t phase_shifted_dac_get_sample_rate();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,99 @@
+#ifndef PHASE_UNITS_H
+#define PHASE_UNITS_H
+
+#include <stdint.h>
+
+/**
+ * Fixed-point phase used by every layer of the control API
+ *
+ * A phase is an unsigned 32-bit fraction of one full turn: 0 = 0°,
+ * 2^32 = 360°. Wrap-around is free (unsigned overflow), so adding or
+ * subtracting phases never needs fmodf() and the value can be handed to
+ * an ISR as a single word. Float degrees only appear at the UI boundary
+ * (HTTP handlers, serial prompts) via phase_from_degrees()/phase_to_degrees().
+ */
+typedef struct {
+    uint32_t turns;
+} phase_t;
+
+#define PHASE_TURNS_PER_DEGREE (4294967296.0 / 360.0)
+
+/**
+ * Build a phase from a raw turn fraction (2^32 = 360°)
+ */
+static constexpr phase_t phase_from_turns(uint32_t turns) {
+    return phase_t{turns};
+}
+
+/**
+ * Build a phase from degrees; any real value is accepted and wrapped
+ * Intended for constants and the UI boundary, not for hot paths
+ */
+static constexpr phase_t phase_from_degrees(double degrees) {
+    return phase_t{(uint32_t)(int64_t)(degrees * PHASE_TURNS_PER_DEGREE + (degrees < 0 ? -0.5 : 0.5))};
+}
+
+/**
+ * Convert a phase back to degrees in [0, 360)
+ */
+static inline float phase_to_degrees(phase_t phase) {
+    return (float)(phase.turns * (360.0 / 4294967296.0));
+}
+
+static constexpr phase_t phase_add(phase_t a, phase_t b) {
+    return phase_t{a.turns + b.turns};
+}
+
+static constexpr phase_t phase_sub(phase_t a, phase_t b) {
+    return phase_t{a.turns - b.turns};
+}
+
+static constexpr bool phase_equal(phase_t a, phase_t b) {
+    return a.turns == b.turns;
+}
+
+/**
+ * Convert to a step count in [0, STEPS) with round-to-nearest
+ * e.g. phase_to_steps<1024>() gives the LEDC hpoint for a 10-bit timer
+ */
+template <uint32_t STEPS>
+static constexpr uint32_t phase_to_steps(phase_t phase) {
+    return (uint32_t)((((uint64_t)phase.turns * STEPS) + 0x80000000ULL) >> 32) % STEPS;
+}
+
+/**
+ * Runtime variant of phase_to_steps() for step counts only known at runtime
+ * (e.g. a timer period that depends on the configured frequency)
+ */
+static inline uint32_t phase_to_steps(phase_t phase, uint32_t steps) {
+    return (uint32_t)((((uint64_t)phase.turns * steps) + 0x80000000ULL) >> 32) % steps;
+}
+
+/**
+ * Truncate to the top BITS bits, e.g. the index into a 2^BITS entry LUT
+ */
+template <unsigned BITS>
+static constexpr uint32_t phase_to_index(phase_t phase) {
+    static_assert(BITS > 0 && BITS <= 32, "index width must be 1..32 bits");
+    return phase.turns >> (32 - BITS);
+}
+
+/**
+ * Phase accumulator units: a phase is already a 32-bit accumulator value
+ */
+static constexpr uint32_t phase_to_accumulator(phase_t phase) {
+    return phase.turns;
+}
+
+/**
+ * Accumulator increment per sample for a given output/sample rate ratio
+ * (2^32 * frequency / sample_rate)
+ */
+static inline uint32_t phase_increment(float frequency, uint32_t sample_rate) {
+    return (uint32_t)((double)frequency * 4294967296.0 / sample_rate);
+}
+
+static constexpr phase_t PHASE_ZERO = {0};
+static constexpr phase_t PHASE_ONE_DEGREE = phase_from_degrees(1.0);
+
+#endif // PHASE_UNITS_H
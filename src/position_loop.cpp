@@ -0,0 +1,145 @@
+#include "position_loop.h"
+#include "position_sensor_backend.h"
+#include "position_pid.h"
+#include "position_map.h"
+#include "levitation_control.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define POSITION_LOOP_TASK_STACK_SIZE   3072
+// Above the UDP and HTTP handlers: a late step is a disturbance
+#define POSITION_LOOP_TASK_PRIORITY     (tskIDLE_PRIORITY + 5)
+// Away from the loop()/HTTP core
+#define POSITION_LOOP_TASK_CORE         0
+
+static position_sensor_t g_sensor;
+static position_pid_t g_pid;
+static TaskHandle_t g_task = nullptr;
+static esp_timer_handle_t g_timer = nullptr;
+static uint32_t g_period_us = 0;
+
+static volatile float g_target_mm = 0.0f;
+static volatile bool g_enabled = false;
+static volatile bool g_reset_pending = false;
+static int64_t g_tick_us = 0;               // Written by the timer, read by the task
+static position_loop_stats_t g_stats;
+
+static void on_tick(void* arg) {
+    (void)arg;
+    g_tick_us = esp_timer_get_time();
+    xTaskNotifyGive(g_task);
+}
+
+static void loop_task(void* arg) {
+    (void)arg;
+    int64_t last_start_us = 0;
+    
+    while (true) {
+        // More than one pending notification means ticks were missed
+        uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t start_us = esp_timer_get_time();
+        if (ticks > 1) {
+            g_stats.overruns += ticks - 1;
+        }
+        
+        if (last_start_us) {
+            int64_t interval = start_us - last_start_us;
+            uint32_t jitter = (uint32_t)(interval > g_period_us ? interval - g_period_us
+                                                                : g_period_us - interval);
+            if (jitter > g_stats.jitter_max_us) g_stats.jitter_max_us = jitter;
+        }
+        float dt_s = last_start_us ? (start_us - last_start_us) * 1e-6f : g_period_us * 1e-6f;
+        last_start_us = start_us;
+        g_stats.iterations++;
+        
+        float measured;
+        if (!g_sensor.read(&measured)) {
+            g_stats.sensor_failures++;
+            continue;
+        }
+        g_stats.measured_mm = measured;
+        
+        if (!g_enabled) continue;
+        if (g_reset_pending) {
+            position_pid_reset(&g_pid);
+            g_reset_pending = false;
+        }
+        
+        phase_t phase = position_pid_update(&g_pid, g_target_mm, measured, dt_s);
+        levitation_set_phase(phase);
+        g_stats.correction_deg = g_pid.correction_deg;
+        
+        uint32_t latency = (uint32_t)(esp_timer_get_time() - g_tick_us);
+        if (latency > g_stats.latency_max_us) g_stats.latency_max_us = latency;
+    }
+}
+
+bool position_loop_begin(uint32_t rate_hz) {
+    if (g_task) return true;
+    if (rate_hz == 0 || !g_sensor.begin()) {
+        return false;
+    }
+    
+    position_pid_gains_t gains;
+    gains.kp = POSITION_LOOP_KP;
+    gains.ki = POSITION_LOOP_KI;
+    gains.kd = POSITION_LOOP_KD;
+    gains.d_cutoff_hz = POSITION_LOOP_D_CUTOFF_HZ;
+    gains.max_correction_deg = POSITION_LOOP_MAX_CORRECTION_DEG;
+    position_pid_init(&g_pid, &gains);
+    
+    // Hold wherever the open-loop phase put the trap
+    g_target_mm = position_map_mm_for_phase(levitation_get_phase());
+    g_period_us = 1000000UL / rate_hz;
+    g_stats.rate_hz = rate_hz;
+    
+    if (xTaskCreatePinnedToCore(loop_task, "pos_loop", POSITION_LOOP_TASK_STACK_SIZE, nullptr,
+                                POSITION_LOOP_TASK_PRIORITY, &g_task,
+                                POSITION_LOOP_TASK_CORE) != pdPASS) {
+        g_task = nullptr;
+        return false;
+    }
+    
+    esp_timer_create_args_t args = {};
+    args.callback = on_tick;
+    args.name = "pos_loop";
+    if (esp_timer_create(&args, &g_timer) != ESP_OK ||
+        esp_timer_start_periodic(g_timer, g_period_us) != ESP_OK) {
+        vTaskDelete(g_task);
+        g_task = nullptr;
+        return false;
+    }
+    
+    g_enabled = true;
+    return true;
+}
+
+void position_loop_set_target(float mm) {
+    if (mm < position_map_min_mm()) mm = position_map_min_mm();
+    if (mm > position_map_max_mm()) mm = position_map_max_mm();
+    g_target_mm = mm;
+}
+
+float position_loop_get_target() {
+    return g_target_mm;
+}
+
+void position_loop_enable(bool enable) {
+    if (enable && !g_enabled) {
+        g_reset_pending = true;  // Don't resume with a stale integrator
+    }
+    g_enabled = enable && g_task;
+}
+
+bool position_loop_is_enabled() {
+    return g_enabled;
+}
+
+const char* position_loop_get_sensor_name() {
+    return position_sensor_t::name();
+}
+
+void position_loop_get_stats(position_loop_stats_t* stats) {
+    *stats = g_stats;
+}
@@ -0,0 +1,88 @@
+#ifndef POSITION_LOOP_H
+#define POSITION_LOOP_H
+
+#include <Arduino.h>
+
+/**
+ * Closed-loop bead height stabilization
+ *
+ * A fixed-rate task reads the bead height from the sensor selected in
+ * position_sensor_backend.h, runs position_pid_update() (feed-forward from
+ * the position map plus PID) and drives levitation_set_phase(). Without a
+ * sensor position_loop_begin() fails and the phase stays open loop.
+ */
+
+#ifndef POSITION_LOOP_RATE_HZ
+#define POSITION_LOOP_RATE_HZ 1000
+#endif
+
+// Default gains, tuned against tools/position_loop_sim.cpp
+#ifndef POSITION_LOOP_KP
+#define POSITION_LOOP_KP 20.0f          // deg/mm
+#endif
+#ifndef POSITION_LOOP_KI
+#define POSITION_LOOP_KI 3000.0f        // deg/(mm·s)
+#endif
+#ifndef POSITION_LOOP_KD
+#define POSITION_LOOP_KD 1.5f           // deg/(mm/s)
+#endif
+#ifndef POSITION_LOOP_D_CUTOFF_HZ
+#define POSITION_LOOP_D_CUTOFF_HZ 150.0f
+#endif
+#ifndef POSITION_LOOP_MAX_CORRECTION_DEG
+#define POSITION_LOOP_MAX_CORRECTION_DEG 60.0f
+#endif
+
+typedef struct {
+    uint32_t rate_hz;
+    uint32_t iterations;
+    uint32_t sensor_failures;   // Steps skipped for lack of a valid reading
+    uint32_t overruns;          // Ticks missed because a step ran late
+    uint32_t jitter_max_us;     // Worst deviation of a step start from its nominal period
+    uint32_t latency_max_us;    // Worst tick -> phase applied
+    float measured_mm;          // Last reading
+    float correction_deg;       // Last PID term on top of the feed-forward
+} position_loop_stats_t;
+
+/**
+ * Bring up the sensor and start the control task (enabled, holding the
+ * current height)
+ * @param rate_hz Loop rate
+ * @return true if running, false if there is no sensor or the task failed
+ */
+bool position_loop_begin(uint32_t rate_hz = POSITION_LOOP_RATE_HZ);
+
+/**
+ * Set the commanded bead height
+ * @param mm Height in mm from transducer 1, clamped to the position map
+ */
+void position_loop_set_target(float mm);
+
+/**
+ * Get the commanded bead height
+ */
+float position_loop_get_target();
+
+/**
+ * Close or open the loop; while open the task only measures
+ * @param enable true to drive the phase
+ */
+void position_loop_enable(bool enable);
+
+/**
+ * Check whether the loop is driving the phase
+ */
+bool position_loop_is_enabled();
+
+/**
+ * Name of the sensor compiled into this build
+ */
+const char* position_loop_get_sensor_name();
+
+/**
+ * Read loop timing and state
+ * @param stats Filled with the current values
+ */
+void position_loop_get_stats(position_loop_stats_t* stats);
+
+#endif // POSITION_LOOP_H
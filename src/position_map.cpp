@@ -0,0 +1,57 @@
+#include "position_map.h"
+#include "position_map_table.h"
+
+static const float STEP_MM = (POSITION_MAP_MAX_MM - POSITION_MAP_MIN_MM) / (POSITION_MAP_ENTRIES - 1);
+
+phase_t position_map_phase_for_mm(float mm) {
+    if (mm <= POSITION_MAP_MIN_MM) return phase_from_turns(POSITION_MAP_PHASE[0]);
+    if (mm >= POSITION_MAP_MAX_MM) return phase_from_turns(POSITION_MAP_PHASE[POSITION_MAP_ENTRIES - 1]);
+    
+    float pos = (mm - POSITION_MAP_MIN_MM) / STEP_MM;
+    uint32_t i = (uint32_t)pos;
+    if (i >= POSITION_MAP_ENTRIES - 1) i = POSITION_MAP_ENTRIES - 2;
+    float t = pos - i;
+    
+    // Interpolate on the wrapped difference so a segment crossing 360° works
+    phase_t a = phase_from_turns(POSITION_MAP_PHASE[i]);
+    phase_t b = phase_from_turns(POSITION_MAP_PHASE[i + 1]);
+    uint32_t span = phase_sub(b, a).turns;
+    return phase_add(a, phase_from_turns((uint32_t)(span * t)));
+}
+
+float position_map_mm_for_phase(phase_t phase) {
+    // Table phases increase monotonically from entry 0, so compare offsets from it
+    uint32_t target = phase_sub(phase, phase_from_turns(POSITION_MAP_PHASE[0])).turns;
+    uint64_t offset = 0;
+    
+    for (uint32_t i = 0; i < POSITION_MAP_ENTRIES - 1; i++) {
+        uint32_t span = POSITION_MAP_PHASE[i + 1] - POSITION_MAP_PHASE[i];
+        if (target < offset + span) {
+            float t = span ? (float)(target - offset) / (float)span : 0.0f;
+            return POSITION_MAP_MIN_MM + (i + t) * STEP_MM;
+        }
+        offset += span;
+    }
+    return POSITION_MAP_MAX_MM;
+}
+
+float position_map_min_mm() {
+    return POSITION_MAP_MIN_MM;
+}
+
+float position_map_max_mm() {
+    return POSITION_MAP_MAX_MM;
+}
+
+float position_map_frequency() {
+    return POSITION_MAP_FREQUENCY_HZ;
+}
+
+uint32_t position_map_entries() {
+    return POSITION_MAP_ENTRIES;
+}
+
+phase_t position_map_entry(uint32_t index) {
+    if (index >= POSITION_MAP_ENTRIES) index = POSITION_MAP_ENTRIES - 1;
+    return phase_from_turns(POSITION_MAP_PHASE[index]);
+}
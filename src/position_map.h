@@ -0,0 +1,50 @@
+#ifndef POSITION_MAP_H
+#define POSITION_MAP_H
+
+#include <stdint.h>
+#include "phase_units.h"
+
+/**
+ * Calibrated trap position <-> phase map
+ * Backed by the table in position_map_table.h, generated offline from a
+ * standing-wave (Gor'kov potential) model of the chamber by
+ * tools/position_map_gen.cpp. Positions are millimetres from transducer 1
+ * along the axis; the table is valid at POSITION_MAP_FREQUENCY_HZ.
+ */
+
+/**
+ * Phase that puts the trap at a given height
+ * @param mm Trap position in mm, clamped to the table range
+ * @return Phase shift for levitation_set_phase()
+ */
+phase_t position_map_phase_for_mm(float mm);
+
+/**
+ * Trap height produced by a given phase (inverse of the above)
+ * @param phase Phase shift
+ * @return Trap position in mm
+ */
+float position_map_mm_for_phase(phase_t phase);
+
+/**
+ * Lowest reachable trap position in mm
+ */
+float position_map_min_mm();
+
+/**
+ * Highest reachable trap position in mm
+ */
+float position_map_max_mm();
+
+/**
+ * Frequency the table was generated for
+ */
+float position_map_frequency();
+
+/**
+ * Number of table entries and raw access, for serving the table to clients
+ */
+uint32_t position_map_entries();
+phase_t position_map_entry(uint32_t index);
+
+#endif // POSITION_MAP_H
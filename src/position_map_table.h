@@ -0,0 +1,29 @@
+#ifndef POSITION_MAP_TABLE_H
+#define POSITION_MAP_TABLE_H
+
+// Generated by tools/position_map_gen.cpp, do not edit
+// --frequency 40000 --spacing-mm 50.00 --aperture-mm 8.00 --entries 64
+
+#include <stdint.h>
+
+#define POSITION_MAP_FREQUENCY_HZ   40000
+#define POSITION_MAP_ENTRIES        64
+#define POSITION_MAP_MIN_MM         27.1489f
+#define POSITION_MAP_MAX_MM         31.4476f
+
+// Phase (turns, 2^32 = 360°) for evenly spaced trap positions MIN..MAX
+static const uint32_t POSITION_MAP_PHASE[POSITION_MAP_ENTRIES] = {
+    0x00000000, 0x04104e20, 0x0820ab20, 0x0c313960, 0x104174e0, 0x1451d960,
+    0x186247e0, 0x1c729b80, 0x208306c0, 0x24937940, 0x28a3d2c0, 0x2cb42d00,
+    0x30c47a40, 0x34d4ea80, 0x38e55680, 0x3cf59e80, 0x41060380, 0x45162b00,
+    0x4926a080, 0x4d370d80, 0x51475d00, 0x5557c000, 0x5967f100, 0x5d783600,
+    0x6188a300, 0x6598f100, 0x69a93600, 0x6db98a80, 0x71c9d680, 0x75da2280,
+    0x79ea5b00, 0x7dfab500, 0x820af800, 0x861b5500, 0x8a2b7400, 0x8e3bbf00,
+    0x924bfc00, 0x965c3b00, 0x9a6c7a00, 0x9e7c8b00, 0xa28cf100, 0xa69d4200,
+    0xaaad7100, 0xaebd9e00, 0xb2cdcf00, 0xb6ddd100, 0xbaee2900, 0xbefe5000,
+    0xc30e7d00, 0xc71e9100, 0xcb2eb800, 0xcf3efb00, 0xd34f2100, 0xd75f7700,
+    0xdb6f5500, 0xdf7f5500, 0xe38f7600, 0xe79f9400, 0xebafa700, 0xefbfd300,
+    0xf3cfe200, 0xf7dff900, 0xfbeff500, 0x00000000
+};
+
+#endif // POSITION_MAP_TABLE_H
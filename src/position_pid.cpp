@@ -0,0 +1,46 @@
+#include "position_pid.h"
+#include "position_map.h"
+#include <math.h>
+
+void position_pid_init(position_pid_t* pid, const position_pid_gains_t* gains) {
+    pid->gains = *gains;
+    position_pid_reset(pid);
+}
+
+void position_pid_reset(position_pid_t* pid) {
+    pid->integral = 0.0f;
+    pid->derivative = 0.0f;
+    pid->prev_measured_mm = 0.0f;
+    pid->correction_deg = 0.0f;
+    pid->primed = false;
+}
+
+static float clamp(float value, float limit) {
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+phase_t position_pid_update(position_pid_t* pid, float setpoint_mm, float measured_mm, float dt_s) {
+    const position_pid_gains_t* g = &pid->gains;
+    float error = setpoint_mm - measured_mm;
+    
+    if (pid->primed && dt_s > 0.0f) {
+        // First-order low-pass on the measured velocity
+        float velocity = (measured_mm - pid->prev_measured_mm) / dt_s;
+        float rc = 1.0f / (2.0f * (float)M_PI * g->d_cutoff_hz);
+        pid->derivative += (velocity - pid->derivative) * (dt_s / (rc + dt_s));
+    }
+    pid->prev_measured_mm = measured_mm;
+    pid->primed = true;
+    
+    // Clamped integrator: no windup while the output is saturated
+    pid->integral = clamp(pid->integral + g->ki * error * dt_s, g->max_correction_deg);
+    
+    float correction = g->kp * error + pid->integral - g->kd * pid->derivative;
+    pid->correction_deg = clamp(correction, g->max_correction_deg);
+    
+    // Higher phase moves the trap up, so a positive correction raises the bead
+    phase_t feed_forward = position_map_phase_for_mm(setpoint_mm);
+    return phase_add(feed_forward, phase_from_degrees(pid->correction_deg));
+}
@@ -0,0 +1,57 @@
+#ifndef POSITION_PID_H
+#define POSITION_PID_H
+
+#include <stdint.h>
+#include "phase_units.h"
+
+/**
+ * Bead height controller: feed-forward from the position map plus PID
+ *
+ * The commanded setpoint goes through position_map_phase_for_mm() to get
+ * the open-loop phase; the PID only adds a correction for what the model
+ * misses (air currents, transducer heating shifting the standing wave).
+ * Derivative acts on the measurement, not the error, so setpoint steps do
+ * not kick the output. Shared with tools/position_loop_sim.cpp; keep this
+ * header free of Arduino dependencies.
+ */
+
+typedef struct {
+    float kp;                   // Degrees of phase per mm of error
+    float ki;                   // Degrees per mm·s
+    float kd;                   // Degrees per mm/s
+    float d_cutoff_hz;          // Low-pass on the derivative (sensor noise)
+    float max_correction_deg;   // Clamp on the PID term; also bounds the integrator
+} position_pid_gains_t;
+
+typedef struct {
+    position_pid_gains_t gains;
+    float integral;             // Degrees
+    float derivative;           // Filtered d(measured)/dt, mm/s
+    float prev_measured_mm;
+    float correction_deg;       // Last PID term, for telemetry
+    bool primed;
+} position_pid_t;
+
+/**
+ * Initialize controller state
+ * @param pid Controller
+ * @param gains Gains, copied
+ */
+void position_pid_init(position_pid_t* pid, const position_pid_gains_t* gains);
+
+/**
+ * Clear integrator and derivative history (e.g. when re-enabling the loop)
+ */
+void position_pid_reset(position_pid_t* pid);
+
+/**
+ * Run one control step
+ * @param pid Controller
+ * @param setpoint_mm Commanded bead height
+ * @param measured_mm Sensor reading
+ * @param dt_s Time since the previous step in seconds
+ * @return Phase for levitation_set_phase()
+ */
+phase_t position_pid_update(position_pid_t* pid, float setpoint_mm, float measured_mm, float dt_s);
+
+#endif // POSITION_PID_H
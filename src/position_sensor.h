@@ -0,0 +1,46 @@
+#ifndef POSITION_SENSOR_H
+#define POSITION_SENSOR_H
+
+/**
+ * Common interface for bead height sensors
+ *
+ * Same CRTP scheme as WaveformBackend: sensors derive from
+ * PositionSensor<Self>, provide begin_impl()/read_impl() and a NAME, and
+ * the one in use is picked at build time (position_sensor_backend.h).
+ * Kept free of Arduino dependencies so the host simulator can plug in
+ * its own stand-in (tools/position_loop_sim.cpp).
+ */
+template <typename Sensor>
+class PositionSensor {
+public:
+    /**
+     * Bring up the sensor
+     * @return false if there is no sensor, which leaves the loop open
+     */
+    bool begin() {
+        return sensor().begin_impl();
+    }
+
+    /**
+     * Take one reading; must complete well within one loop period
+     * @param mm Bead height in mm from transducer 1
+     * @return false if no valid reading was available
+     */
+    bool read(float* mm) {
+        return sensor().read_impl(mm);
+    }
+
+    static constexpr const char* name() {
+        return Sensor::NAME;
+    }
+
+protected:
+    PositionSensor() {}
+
+private:
+    Sensor& sensor() {
+        return *static_cast<Sensor*>(this);
+    }
+};
+
+#endif // POSITION_SENSOR_H
@@ -0,0 +1,17 @@
+#ifndef POSITION_SENSOR_BACKEND_H
+#define POSITION_SENSOR_BACKEND_H
+
+/**
+ * Compile-time selection of the bead height sensor
+ * Add a POSITION_SENSOR_* flag to an env's build_flags to close the loop;
+ * without one the position loop never starts and phase stays open loop.
+ */
+#include "adc_position_sensor.h"
+
+#if defined(POSITION_SENSOR_ADC)
+typedef AdcPositionSensor position_sensor_t;
+#else
+typedef NoPositionSensor position_sensor_t;
+#endif
+
+#endif // POSITION_SENSOR_BACKEND_H
@@ -0,0 +1,266 @@
+#include "rig_sync.h"
+#include <Arduino.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "levitation_control.h"
+#include "setpoint.h"
+#include "event_log.h"
+
+#define RIG_SYNC_TASK_STACK_SIZE    3072
+// Same as the UDP control port: timestamps taken late are timestamps taken wrong
+#define RIG_SYNC_TASK_PRIORITY      (tskIDLE_PRIORITY + 3)
+
+#if defined(RIG_SYNC_MASTER)
+static const rig_sync_role_t g_role = RIG_SYNC_ROLE_MASTER;
+#elif defined(RIG_SYNC_FOLLOWER)
+static const rig_sync_role_t g_role = RIG_SYNC_ROLE_FOLLOWER;
+#else
+static const rig_sync_role_t g_role = RIG_SYNC_ROLE_OFF;
+#endif
+
+static int g_socket = -1;
+static TaskHandle_t g_task = nullptr;
+static uint16_t g_port = RIG_SYNC_PORT;
+static rig_sync_stats_t g_stats;
+
+// Guards the published move and the armed move
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Master: the move every response carries
+static uint32_t g_move_id = 0;
+static int64_t g_move_at_us = 0;
+static phase_t g_move_phase = PHASE_ZERO;
+
+// Both roles: the move waiting on the local timer
+static esp_timer_handle_t g_move_timer = nullptr;
+static phase_t g_armed_phase = PHASE_ZERO;
+static int64_t g_armed_local_us = 0;
+
+// Follower task only
+static rig_sync_servo_t g_servo;
+static phase_t g_sync_offset = PHASE_ZERO;
+static uint32_t g_last_move_id = 0;
+
+/**
+ * esp_timer callback: the levitation mutex is only ever held for a few
+ * register writes, so applying here costs the timer task microseconds
+ */
+static void on_move_due(void* arg) {
+    (void)arg;
+    portENTER_CRITICAL(&g_mux);
+    phase_t phase = g_armed_phase;
+    int64_t due = g_armed_local_us;
+    portEXIT_CRITICAL(&g_mux);
+
+    int32_t late = (int32_t)(esp_timer_get_time() - due);
+    setpoint_apply_phase(phase, INPUT_SOURCE_SYNC);
+    g_stats.moves_applied++;
+    g_stats.last_move_late_us = late;
+    event_log(EVENT_SYNC_MOVE, phase.turns, (uint32_t)late);
+}
+
+/**
+ * Arm the move timer; replaces a move that is not due yet
+ * @param local_us Local esp_timer time to apply it at
+ */
+static void arm_move(phase_t phase, int64_t local_us) {
+    esp_timer_stop(g_move_timer);  // Fails harmlessly if not running
+    portENTER_CRITICAL(&g_mux);
+    g_armed_phase = phase;
+    g_armed_local_us = local_us;
+    portEXIT_CRITICAL(&g_mux);
+
+    int64_t wait = local_us - esp_timer_get_time();
+    if (wait < 1) {
+        // Locked after the move was due: catch up now rather than never
+        wait = 1;
+        g_stats.moves_late++;
+    }
+    esp_timer_start_once(g_move_timer, (uint64_t)wait);
+    g_stats.moves_scheduled++;
+}
+
+static void master_task(void* arg) {
+    (void)arg;
+    rig_sync_msg_t msg;
+    struct sockaddr_in from;
+
+    while (true) {
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(g_socket, &msg, sizeof(msg), 0, (struct sockaddr*)&from, &from_len);
+        int64_t t2 = esp_timer_get_time();
+        if (!rig_sync_msg_valid(&msg, len, RIG_SYNC_MSG_REQUEST)) {
+            continue;
+        }
+
+        rig_sync_msg_t resp;
+        rig_sync_msg_init(&resp, RIG_SYNC_MSG_RESPONSE, 0, msg.seq);
+        resp.t1_us = msg.t1_us;
+        resp.t2_us = t2;
+
+        // Carrier anchor, if this backend can read its carrier
+        phase_t carrier;
+        int64_t carrier_us;
+        if (levitation_read_carrier(&carrier, &carrier_us)) {
+            resp.anchor_us = carrier_us;
+            resp.anchor_turns = carrier.turns;
+            resp.frequency_mhz = (uint32_t)(levitation_get_frequency() * 1000.0f);
+        }
+
+        portENTER_CRITICAL(&g_mux);
+        resp.move_id = g_move_id;
+        resp.move_at_us = g_move_at_us;
+        resp.move_phase = g_move_phase.turns;
+        portEXIT_CRITICAL(&g_mux);
+
+        resp.t3_us = esp_timer_get_time();
+        sendto(g_socket, &resp, sizeof(resp), 0, (struct sockaddr*)&from, from_len);
+        g_stats.requests++;
+    }
+}
+
+/**
+ * Feed one response to the servo, discipline the carrier, pick up moves
+ */
+static void follower_handle(const rig_sync_msg_t* resp, int64_t t4) {
+    bool was_locked = g_servo.locked;
+    rig_sync_servo_update(&g_servo, resp->t1_us, resp->t2_us, resp->t3_us, t4);
+    if (!g_servo.valid) return;
+
+    if (g_servo.locked != was_locked) {
+        if (g_servo.locked) {
+            event_log(EVENT_SYNC_LOCKED, (uint32_t)(int32_t)g_servo.rate_ppb, (uint32_t)g_servo.error_us);
+        } else {
+            event_log(EVENT_SYNC_LOST);
+        }
+    }
+
+    // Rate always; phase only against a carrier at the same frequency
+    int32_t correction = 0;
+    bool aligned = false;
+    phase_t carrier;
+    int64_t carrier_us;
+    if (resp->frequency_mhz == (uint32_t)(levitation_get_frequency() * 1000.0f) &&
+        levitation_read_carrier(&carrier, &carrier_us)) {
+        correction = rig_sync_carrier_correction(&g_servo, resp, carrier_us, carrier.turns);
+        g_sync_offset.turns += (uint32_t)correction;
+        aligned = resp->anchor_us != 0 && rig_sync_carrier_aligned(&g_servo, resp->frequency_mhz);
+    }
+    g_stats.carrier_trimmed = levitation_trim_carrier((int32_t)g_servo.rate_ppb, g_sync_offset);
+    g_stats.carrier_aligned = g_stats.carrier_trimmed && aligned;
+    g_stats.carrier_correction = correction;
+
+    if (resp->move_id != 0 && resp->move_id != g_last_move_id && g_servo.locked) {
+        g_last_move_id = resp->move_id;
+        arm_move(phase_from_turns(resp->move_phase), rig_sync_to_local(&g_servo, resp->move_at_us));
+    }
+}
+
+static void follower_task(void* arg) {
+    (void)arg;
+    struct sockaddr_in master;
+    memset(&master, 0, sizeof(master));
+    master.sin_family = AF_INET;
+    master.sin_port = htons(g_port);
+    master.sin_addr.s_addr = inet_addr(RIG_SYNC_MASTER_IP);
+
+    uint32_t seq = 0;
+    TickType_t wake = xTaskGetTickCount();
+
+    while (true) {
+        rig_sync_msg_t req;
+        rig_sync_msg_init(&req, RIG_SYNC_MSG_REQUEST, RIG_SYNC_RIG_ID, ++seq);
+        req.t1_us = esp_timer_get_time();
+        sendto(g_socket, &req, sizeof(req), 0, (struct sockaddr*)&master, sizeof(master));
+        g_stats.requests++;
+
+        // Receive timeout is one interval; responses to older requests are skipped
+        rig_sync_msg_t resp;
+        int len;
+        while ((len = recv(g_socket, &resp, sizeof(resp), 0)) >= 0) {
+            int64_t t4 = esp_timer_get_time();
+            if (rig_sync_msg_valid(&resp, len, RIG_SYNC_MSG_RESPONSE) && resp.seq == seq) {
+                follower_handle(&resp, t4);
+                break;
+            }
+        }
+
+        g_stats.locked = g_servo.locked;
+        g_stats.offset_us = (int64_t)g_servo.offset_us;
+        g_stats.rate_ppb = (int32_t)g_servo.rate_ppb;
+        g_stats.error_us = (uint32_t)g_servo.error_us;
+        g_stats.exchanges = g_servo.exchanges;
+        g_stats.rejected = g_servo.rejected;
+        g_stats.steps = g_servo.steps;
+
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(RIG_SYNC_INTERVAL_MS));
+    }
+}
+
+rig_sync_role_t rig_sync_get_role() {
+    return g_role;
+}
+
+bool rig_sync_begin(uint16_t port) {
+    if (g_role == RIG_SYNC_ROLE_OFF) return false;
+    if (g_task) return true;
+    g_port = port;
+    rig_sync_servo_init(&g_servo);
+
+    esp_timer_create_args_t args = {};
+    args.callback = on_move_due;
+    args.name = "rig_sync";
+    if (!g_move_timer && esp_timer_create(&args, &g_move_timer) != ESP_OK) {
+        return false;
+    }
+
+    g_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (g_socket < 0) {
+        return false;
+    }
+
+    // Followers send from the same port they would listen on; the master answers to it
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = RIG_SYNC_INTERVAL_MS * 1000;
+    setsockopt(g_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    TaskFunction_t task = g_role == RIG_SYNC_ROLE_MASTER ? master_task : follower_task;
+    if (bind(g_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        xTaskCreate(task, "rig_sync", RIG_SYNC_TASK_STACK_SIZE, nullptr,
+                    RIG_SYNC_TASK_PRIORITY, &g_task) != pdPASS) {
+        closesocket(g_socket);
+        g_socket = -1;
+        g_task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool rig_sync_schedule_move(phase_t phase, uint32_t lead_ms) {
+    if (g_role != RIG_SYNC_ROLE_MASTER || !g_move_timer) return false;
+
+    // The master clock is this rig's clock
+    int64_t at = esp_timer_get_time() + (int64_t)lead_ms * 1000;
+    portENTER_CRITICAL(&g_mux);
+    g_move_id++;
+    g_move_at_us = at;
+    g_move_phase = phase;
+    portEXIT_CRITICAL(&g_mux);
+
+    arm_move(phase, at);
+    return true;
+}
+
+void rig_sync_get_stats(rig_sync_stats_t* stats) {
+    *stats = g_stats;
+    stats->role = g_role;
+}
@@ -0,0 +1,96 @@
+#ifndef RIG_SYNC_H
+#define RIG_SYNC_H
+
+#include <stdint.h>
+#include "phase_units.h"
+#include "rig_sync_core.h"
+
+/**
+ * Time and carrier sync between rigs running side by side
+ *
+ * One rig is the master (its Wi-Fi AP is the network, 192.168.4.1); the
+ * others join it as stations and poll it every RIG_SYNC_INTERVAL_MS with
+ * the two-way exchange described in rig_sync_core.h. Followers:
+ *   - estimate the master clock (offset and rate) from the exchanges
+ *   - trim their carrier tuning word by the fitted rate, so carriers stop
+ *     beating, and nudge the carrier phase onto the master's once the
+ *     clock estimate is fine enough (dac_isr backend only, channel 2).
+ *     That takes about 2 us at 40 kHz, which software timestamps over
+ *     Wi-Fi are not shown to reach; until then (carrier_aligned false)
+ *     the carriers share the master's rate with an arbitrary phase offset
+ *   - apply the master's coordinated moves at the shared master timestamp
+ *     through a local esp_timer one-shot
+ *
+ * The role is chosen at build time: -DRIG_SYNC_MASTER, or
+ * -DRIG_SYNC_FOLLOWER -DRIG_SYNC_RIG_ID=n with n = 1, 2, ... unique per
+ * rig. Without either flag the rig runs standalone.
+ */
+
+#ifndef RIG_SYNC_RIG_ID
+#define RIG_SYNC_RIG_ID         1
+#endif
+
+#ifndef RIG_SYNC_MASTER_IP
+#define RIG_SYNC_MASTER_IP      "192.168.4.1"   // Default soft-AP address
+#endif
+
+#ifndef RIG_SYNC_INTERVAL_MS
+#define RIG_SYNC_INTERVAL_MS    125
+#endif
+
+typedef enum {
+    RIG_SYNC_ROLE_OFF = 0,
+    RIG_SYNC_ROLE_MASTER = 1,
+    RIG_SYNC_ROLE_FOLLOWER = 2,
+} rig_sync_role_t;
+
+typedef struct {
+    uint8_t role;                   // rig_sync_role_t
+    bool locked;                    // Follower: clock estimate trusted, moves are scheduled
+    bool carrier_trimmed;           // Follower: the backend accepted the carrier trim
+    bool carrier_aligned;           // Follower: clock fine enough that carrier phase is corrected
+    int64_t offset_us;              // Follower: master - local clock
+    int32_t rate_ppb;               // Follower: master clock rate relative to local
+    uint32_t error_us;              // Follower: expected clock error
+    int32_t carrier_correction;     // Follower: last carrier phase nudge (phase_t turns)
+    uint32_t requests;              // Master: answered, follower: sent
+    uint32_t exchanges;             // Follower: accepted by the delay filter
+    uint32_t rejected;              // Follower: delay too far above the fastest recent one
+    uint32_t steps;                 // Follower: clock estimate restarted
+    uint32_t moves_scheduled;
+    uint32_t moves_applied;
+    uint32_t moves_late;            // Already due when scheduled (follower locked late)
+    int32_t last_move_late_us;      // Applied this long after its time
+} rig_sync_stats_t;
+
+/**
+ * Role compiled into this build
+ */
+rig_sync_role_t rig_sync_get_role();
+
+/**
+ * Open the sync port and start the master or follower task
+ * Call once the network is up; does nothing without a role
+ * @param port UDP port (the master listens on it, followers send to it)
+ * @return true if a task was started
+ */
+bool rig_sync_begin(uint16_t port = RIG_SYNC_PORT);
+
+/**
+ * Schedule a coordinated move on every rig (master only)
+ * Applied here and on every locked follower when the master clock reaches
+ * now + lead_ms; the lead must cover a few poll intervals so every
+ * follower hears of the move in time. A new move replaces one not yet due.
+ * @param phase Phase shift to apply
+ * @param lead_ms Delay before the move, in ms
+ * @return false if this rig is not the master
+ */
+bool rig_sync_schedule_move(phase_t phase, uint32_t lead_ms);
+
+/**
+ * Read the sync state and counters
+ * @param stats Filled with the current values
+ */
+void rig_sync_get_stats(rig_sync_stats_t* stats);
+
+#endif // RIG_SYNC_H
@@ -0,0 +1,173 @@
+#include "rig_sync_core.h"
+#include <math.h>
+#include <string.h>
+
+void rig_sync_msg_init(rig_sync_msg_t* msg, rig_sync_msg_type_t type, uint16_t rig_id, uint32_t seq) {
+    memset(msg, 0, sizeof(*msg));
+    msg->magic = RIG_SYNC_MAGIC;
+    msg->version = RIG_SYNC_VERSION;
+    msg->type = (uint8_t)type;
+    msg->rig_id = rig_id;
+    msg->seq = seq;
+}
+
+bool rig_sync_msg_valid(const rig_sync_msg_t* msg, int len, rig_sync_msg_type_t type) {
+    return len == (int)sizeof(*msg) && msg->magic == RIG_SYNC_MAGIC &&
+           msg->version == RIG_SYNC_VERSION && msg->type == type;
+}
+
+void rig_sync_servo_init(rig_sync_servo_t* servo) {
+    memset(servo, 0, sizeof(*servo));
+}
+
+static double predicted_offset(const rig_sync_servo_t* servo, int64_t local_us) {
+    return servo->offset_us + (double)(local_us - servo->ref_local_us) * servo->rate_ppb * 1e-9;
+}
+
+/**
+ * Slot of the i-th oldest bin in the window. The window is the count
+ * slots before next: after a step it restarts mid-ring, and the slots
+ * behind it still hold exchanges from before the step.
+ */
+static uint32_t window_slot(const rig_sync_servo_t* servo, uint32_t i) {
+    return (servo->next + RIG_SYNC_WINDOW - servo->count + i) % RIG_SYNC_WINDOW;
+}
+
+/**
+ * Least-squares line through the window: offset at the newest exchange,
+ * slope as rate, residual RMS / sqrt(n) as the expected offset error
+ */
+static void fit(rig_sync_servo_t* servo) {
+    uint32_t n = servo->count;
+    uint32_t newest = window_slot(servo, n - 1);
+    int64_t ref = servo->window_local_us[newest];
+    double base = servo->window_offset_us[newest];
+
+    // Seconds and microseconds relative to the newest sample keep the sums small
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t slot = window_slot(servo, i);
+        double x = (double)(servo->window_local_us[slot] - ref) * 1e-6;
+        double y = servo->window_offset_us[slot] - base;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double mx = sx / n, my = sy / n;
+    double vxx = sxx - n * mx * mx;
+    double slope = vxx > 1e-6 ? (sxy - n * mx * my) / vxx : servo->rate_ppb * 1e-3;  // us per s
+
+    double rate_ppb = slope * 1e3;
+    if (rate_ppb > RIG_SYNC_MAX_RATE_PPB) rate_ppb = RIG_SYNC_MAX_RATE_PPB;
+    if (rate_ppb < -RIG_SYNC_MAX_RATE_PPB) rate_ppb = -RIG_SYNC_MAX_RATE_PPB;
+    double intercept = my - slope * mx;
+
+    double sse = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t slot = window_slot(servo, i);
+        double x = (double)(servo->window_local_us[slot] - ref) * 1e-6;
+        double r = servo->window_offset_us[slot] - base - (intercept + slope * x);
+        sse += r * r;
+    }
+
+    servo->ref_local_us = ref;
+    servo->offset_us = base + intercept;
+    servo->rate_ppb = rate_ppb;
+    // Two points always fit exactly; assume the step threshold until there is a residual
+    servo->error_us = n > 2 ? sqrt(sse / (n - 2)) / sqrt((double)n) : RIG_SYNC_STEP_US;
+    servo->locked = n >= RIG_SYNC_LOCK_COUNT && servo->error_us < RIG_SYNC_LOCK_US;
+}
+
+bool rig_sync_servo_update(rig_sync_servo_t* servo, int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    int64_t delay = ((t4 - t1) - (t3 - t2)) / 2;
+    servo->last_delay_us = delay;
+    if (delay < 0) {
+        // Timestamps out of order: nothing to learn from this exchange
+        servo->rejected++;
+        return false;
+    }
+
+    // Lucky-packet filter: only exchanges close to the fastest recent path
+    // are symmetric enough to trust; the rest waited in a queue somewhere.
+    // A recent minimum rather than an all-time one follows a path that
+    // got slower for good (AP channel change, rig moved further away).
+    servo->delay_history_us[servo->delay_next] = delay;
+    servo->delay_next = (servo->delay_next + 1) % RIG_SYNC_DELAY_HISTORY;
+    if (servo->delay_count < RIG_SYNC_DELAY_HISTORY) servo->delay_count++;
+    servo->min_delay_us = delay;
+    for (uint32_t i = 0; i < servo->delay_count; i++) {
+        if (servo->delay_history_us[i] < servo->min_delay_us) servo->min_delay_us = servo->delay_history_us[i];
+    }
+    if (delay > servo->min_delay_us + RIG_SYNC_DELAY_SLACK_US) {
+        servo->rejected++;
+        return false;
+    }
+    servo->exchanges++;
+
+    double measured = ((double)(t2 - t1) + (double)(t3 - t4)) / 2.0;
+    int64_t mid = t1 + (t4 - t1) / 2;
+
+    if (servo->valid) {
+        double error = measured - predicted_offset(servo, mid);
+        servo->last_error_us = (int64_t)error;
+        if (fabs(error) > RIG_SYNC_STEP_US) {
+            // Master restarted or a long outage: old exchanges no longer apply
+            servo->count = 0;
+            servo->steps++;
+        }
+    } else {
+        servo->steps++;
+    }
+
+    // Same bin as the newest entry: keep whichever exchange was faster
+    uint32_t newest = (servo->next + RIG_SYNC_WINDOW - 1) % RIG_SYNC_WINDOW;
+    uint32_t slot = servo->next;
+    if (servo->count > 0 && mid - servo->window_local_us[newest] < RIG_SYNC_BIN_MS * 1000LL) {
+        if (delay >= servo->window_delay_us[newest]) return true;
+        slot = newest;
+    } else {
+        servo->next = (servo->next + 1) % RIG_SYNC_WINDOW;
+        if (servo->count < RIG_SYNC_WINDOW) servo->count++;
+    }
+    servo->window_local_us[slot] = mid;
+    servo->window_offset_us[slot] = measured;
+    servo->window_delay_us[slot] = delay;
+    servo->valid = true;
+    fit(servo);
+    return true;
+}
+
+int64_t rig_sync_to_master(const rig_sync_servo_t* servo, int64_t local_us) {
+    return local_us + (int64_t)llround(predicted_offset(servo, local_us));
+}
+
+int64_t rig_sync_to_local(const rig_sync_servo_t* servo, int64_t master_us) {
+    // offset barely changes over the lead time of a move: one fixed-point step
+    int64_t local = master_us - (int64_t)llround(servo->offset_us);
+    return master_us - (int64_t)llround(predicted_offset(servo, local));
+}
+
+uint32_t rig_sync_carrier_at(int64_t anchor_us, uint32_t anchor_turns, uint32_t frequency_mhz,
+                             int64_t master_us) {
+    // Whole cycles drop out; only the fractional part moves the phase
+    double cycles = (double)frequency_mhz * 1e-3 * (double)(master_us - anchor_us) * 1e-6;
+    double fraction = cycles - floor(cycles);
+    return anchor_turns + (uint32_t)(int64_t)(fraction * 4294967296.0);
+}
+
+bool rig_sync_carrier_aligned(const rig_sync_servo_t* servo, uint32_t frequency_mhz) {
+    double error_deg = servo->error_us * 1e-6 * (frequency_mhz * 1e-3) * 360.0;
+    return servo->locked && error_deg < RIG_SYNC_CARRIER_MAX_DEG;
+}
+
+int32_t rig_sync_carrier_correction(const rig_sync_servo_t* servo, const rig_sync_msg_t* msg,
+                                    int64_t local_us, uint32_t local_turns) {
+    if (msg->anchor_us == 0 || !rig_sync_carrier_aligned(servo, msg->frequency_mhz)) return 0;
+
+    uint32_t target = rig_sync_carrier_at(msg->anchor_us, msg->anchor_turns, msg->frequency_mhz,
+                                          rig_sync_to_master(servo, local_us));
+    // Serial-number distance: the short way round the circle
+    int32_t error = (int32_t)(target - local_turns);
+    return (int32_t)(error * RIG_SYNC_CARRIER_GAIN);
+}
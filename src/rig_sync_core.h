@@ -0,0 +1,161 @@
+#ifndef RIG_SYNC_CORE_H
+#define RIG_SYNC_CORE_H
+
+#include <stdint.h>
+
+/**
+ * Multi-rig time and carrier phase sync: wire format and servo
+ *
+ * PTP-style two-way exchange, initiated by the follower so it works as
+ * plain unicast to the master's access point:
+ *   t1  follower sends REQUEST          (follower clock)
+ *   t2  master receives it              (master clock)
+ *   t3  master sends RESPONSE           (master clock)
+ *   t4  follower receives the response  (follower clock)
+ *   offset = ((t2 - t1) + (t3 - t4)) / 2      master - follower
+ *   delay  = ((t4 - t1) - (t3 - t2)) / 2      one way, assumed symmetric
+ *
+ * The follower servo turns exchanges into a master clock estimate: it
+ * drops exchanges that queued behind other traffic, keeps the fastest
+ * exchange of every RIG_SYNC_BIN_MS and fits offset and rate by least
+ * squares over the last RIG_SYNC_WINDOW bins, a baseline of half a minute. The
+ * rate is what disciplines the carrier tuning word, so rigs stop beating
+ * against each other. Carrier *phase* is only corrected once the expected
+ * clock error is a small fraction of a carrier period (RIG_SYNC_CARRIER_MAX_DEG);
+ * at 40 kHz one period is 25 us, which Wi-Fi software timestamps only
+ * reach on a quiet channel.
+ *
+ * Every response also carries a carrier anchor (master carrier phase at a
+ * master timestamp) and the current coordinated move (a setpoint to apply
+ * at a shared master timestamp), so one datagram pair per interval is the
+ * whole protocol.
+ *
+ * Shared with tools/rig_sync_sim.cpp; keep this header free of Arduino
+ * dependencies.
+ */
+
+#define RIG_SYNC_PORT               4211
+#define RIG_SYNC_MAGIC              0x4E59534CUL    // "LSYN"
+#define RIG_SYNC_VERSION            1
+
+// Servo tuning (tools/rig_sync_sim.cpp)
+#define RIG_SYNC_WINDOW             32      // Bins in the fit
+#define RIG_SYNC_BIN_MS             1000    // One exchange per bin: the one with the lowest delay
+#define RIG_SYNC_STEP_US            2000    // Larger errors restart the fit (master rebooted, outage)
+#define RIG_SYNC_LOCK_COUNT         8       // Bins in the fit before it is trusted
+#define RIG_SYNC_LOCK_US            50      // ... and its expected offset error is below this
+#define RIG_SYNC_DELAY_SLACK_US     300     // Accept delays up to min + slack
+#define RIG_SYNC_DELAY_HISTORY      32      // Exchanges the min delay is taken over
+#define RIG_SYNC_MAX_RATE_PPB       500000  // ±500 ppm, far beyond any crystal
+#define RIG_SYNC_CARRIER_GAIN       0.5     // Share of the carrier phase error corrected per exchange
+#ifndef RIG_SYNC_CARRIER_MAX_DEG
+#define RIG_SYNC_CARRIER_MAX_DEG    30      // Expected clock error, in carrier degrees, to correct phase
+#endif
+
+typedef enum {
+    RIG_SYNC_MSG_REQUEST = 1,       // Follower -> master
+    RIG_SYNC_MSG_RESPONSE = 2,      // Master -> follower
+} rig_sync_msg_type_t;
+
+/**
+ * Request / response datagram, little-endian, 68 bytes
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t type;                   // rig_sync_msg_type_t
+    uint16_t rig_id;                // Sender
+    uint32_t seq;                   // Echoed by the response
+    int64_t t1_us;                  // Follower clock, request sent
+    int64_t t2_us;                  // Master clock, request received
+    int64_t t3_us;                  // Master clock, response sent
+    int64_t anchor_us;              // Master clock of anchor_turns; 0 = no carrier
+    uint32_t anchor_turns;          // Master carrier phase (phase_t turns)
+    uint32_t frequency_mhz;         // Master carrier frequency in mHz
+    uint32_t move_id;               // 0 = no move scheduled yet
+    int64_t move_at_us;             // Master clock at which to apply the move
+    uint32_t move_phase;            // phase_t turns
+} rig_sync_msg_t;
+
+/**
+ * Follower's estimate of the master clock
+ */
+typedef struct {
+    bool valid;                     // Set by the first accepted exchange
+    bool locked;                    // Enough exchanges and a small expected error
+    int64_t ref_local_us;           // Local time of the newest exchange in the fit
+    double offset_us;               // Fitted master - local at ref_local_us
+    double rate_ppb;                // Fitted master clock rate relative to local, minus 1
+    double error_us;                // Expected offset error: fit residual RMS / sqrt(n)
+    int64_t min_delay_us;           // Lowest delay of the recent exchanges
+    int64_t delay_history_us[RIG_SYNC_DELAY_HISTORY];
+    uint32_t delay_count;           // Entries in delay_history_us
+    uint32_t delay_next;
+    int64_t last_error_us;          // Measured - predicted offset, last exchange
+    int64_t last_delay_us;
+    uint32_t count;                 // Bins in the window
+    uint32_t next;                  // Next window slot
+    int64_t window_local_us[RIG_SYNC_WINDOW];
+    double window_offset_us[RIG_SYNC_WINDOW];
+    int64_t window_delay_us[RIG_SYNC_WINDOW];
+    uint32_t exchanges;             // Accepted
+    uint32_t rejected;              // Delay above min + slack, or negative
+    uint32_t steps;                 // Fit restarted
+} rig_sync_servo_t;
+
+/**
+ * Fill the common header of a datagram
+ */
+void rig_sync_msg_init(rig_sync_msg_t* msg, rig_sync_msg_type_t type, uint16_t rig_id, uint32_t seq);
+
+/**
+ * Validate a received datagram
+ * @param len Bytes received
+ * @param type Expected type
+ */
+bool rig_sync_msg_valid(const rig_sync_msg_t* msg, int len, rig_sync_msg_type_t type);
+
+void rig_sync_servo_init(rig_sync_servo_t* servo);
+
+/**
+ * Feed one completed exchange
+ * @return true if it was accepted and the estimate updated
+ */
+bool rig_sync_servo_update(rig_sync_servo_t* servo, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+/**
+ * Master clock at a local time (requires servo->valid)
+ */
+int64_t rig_sync_to_master(const rig_sync_servo_t* servo, int64_t local_us);
+
+/**
+ * Local time at which the master clock reads master_us
+ */
+int64_t rig_sync_to_local(const rig_sync_servo_t* servo, int64_t master_us);
+
+/**
+ * Carrier phase the master emits at a master time, from an anchor
+ */
+uint32_t rig_sync_carrier_at(int64_t anchor_us, uint32_t anchor_turns, uint32_t frequency_mhz,
+                             int64_t master_us);
+
+/**
+ * Phase correction for the local carrier: RIG_SYNC_CARRIER_GAIN times the
+ * signed distance from the local carrier to the master's at the same
+ * instant, or 0 while the clock estimate is too coarse to tell (see
+ * rig_sync_carrier_aligned())
+ * @param msg Response carrying the anchor
+ * @param local_us Local time at which local_turns was read
+ * @param local_turns Local carrier phase (phase_t turns)
+ * @return Turns to add to the local carrier offset
+ */
+int32_t rig_sync_carrier_correction(const rig_sync_servo_t* servo, const rig_sync_msg_t* msg,
+                                    int64_t local_us, uint32_t local_turns);
+
+/**
+ * Whether the clock estimate is good enough to correct carrier phase
+ * @param frequency_mhz Carrier frequency in mHz
+ */
+bool rig_sync_carrier_aligned(const rig_sync_servo_t* servo, uint32_t frequency_mhz);
+
+#endif // RIG_SYNC_CORE_H
@@ -0,0 +1,107 @@
+#ifndef SCOPE_FRAME_H
+#define SCOPE_FRAME_H
+
+#include <math.h>
+#include <stdint.h>
+#include "dac_synth.h"
+
+/**
+ * Virtual oscilloscope: generator snapshot and wire format
+ *
+ * A snapshot is the handful of words that fully determine what the
+ * outputs emit from a given sample on (carrier accumulator, increment,
+ * channel 2 offset, sample rate and, for the DAC ISR, the live LUT), so
+ * taking one costs the generator nothing. scope_render() expands it into
+ * the exact code sequence with the same synthesis the ISR uses.
+ *
+ * Under the DAC ISR only channel 2 is exact. Channel 1 is the CW generator,
+ * which runs from the RTC clock in fstep steps and cannot be read back, so
+ * it is rendered as an ideal sine at the generator's programmed frequency
+ * (ch1_increment), starting in phase with the carrier at the first sample.
+ * Keep this header free of Arduino dependencies.
+ */
+
+typedef enum {
+    SCOPE_WAVEFORM_SINE_LUT = 0,    // DAC ISR: samples are exact
+    SCOPE_WAVEFORM_SQUARE = 1,      // LEDC/MCPWM: ideal edges at the quantized phase
+    SCOPE_WAVEFORM_SINE = 2,        // CW generator: ideal sine
+} scope_waveform_t;
+
+typedef struct {
+    uint8_t waveform;               // scope_waveform_t
+    uint32_t sample_rate;           // Samples per second of the rendered sequence
+    uint32_t accumulator;           // Carrier phase at the first sample
+    uint32_t increment;             // Carrier advance per sample
+    uint32_t offset;                // Channel 2 phase offset (phase_t turns)
+    const uint8_t* lut;             // SINE_LUT only: the table the ISR reads
+    uint32_t ch1_increment;         // Channel 1 model advance per sample when it runs
+                                    // on its own clock, 0 = on the carrier like channel 2
+} scope_snapshot_t;
+
+// Square/sine backends have no sample clock; render this many samples per period
+#define SCOPE_MODEL_SAMPLES_PER_PERIOD 32
+
+#define SCOPE_FRAME_MAGIC   0x5043534CUL    // "LSCP"
+#define SCOPE_FRAME_VERSION 2
+
+/**
+ * Frame header, little-endian, followed by `count` (ch1, ch2) byte pairs
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t waveform;               // scope_waveform_t
+    uint16_t count;                 // Sample pairs that follow
+    uint32_t seq;                   // Frame counter
+    uint32_t sample_rate;
+    uint32_t frequency_hz;
+    uint32_t phase;                 // Channel 2 offset, phase_t turns
+    uint32_t ch1_frequency_mhz;     // Channel 1 model frequency in mHz, 0 = same carrier
+} scope_frame_header_t;
+
+/**
+ * Ideal sine DAC code, for the backends that are only modelled
+ */
+static inline uint8_t scope_model_sine(uint32_t phase) {
+    return (uint8_t)((sinf(phase * (float)(2.0 * M_PI / 4294967296.0)) + 1.0f) * 127.5f);
+}
+
+static inline uint8_t scope_sample(const scope_snapshot_t* snap, uint32_t accumulator, uint32_t offset) {
+    uint32_t phase = accumulator + offset;
+    switch (snap->waveform) {
+        case SCOPE_WAVEFORM_SINE_LUT:
+            return dac_synth_sample(snap->lut, accumulator, offset);
+        case SCOPE_WAVEFORM_SQUARE:
+            return phase < 0x80000000UL ? 255 : 0;
+        default:
+            return scope_model_sine(phase);
+    }
+}
+
+/**
+ * Expand a snapshot into interleaved channel 1 / channel 2 DAC codes
+ * @param snap Snapshot
+ * @param out 2 * count bytes
+ * @param count Sample pairs
+ */
+static inline void scope_render(const scope_snapshot_t* snap, uint8_t* out, uint16_t count) {
+    uint32_t accumulator = snap->accumulator;
+    uint32_t ch1_accumulator = snap->accumulator;
+    for (uint16_t i = 0; i < count; i++) {
+        out[2 * i] = snap->ch1_increment ? scope_model_sine(ch1_accumulator)
+                                         : scope_sample(snap, accumulator, 0);
+        out[2 * i + 1] = scope_sample(snap, accumulator, snap->offset);
+        accumulator += snap->increment;
+        ch1_accumulator += snap->ch1_increment;
+    }
+}
+
+/**
+ * Channel 1 model frequency of a snapshot
+ * @return mHz, 0 if channel 1 is on the same carrier as channel 2
+ */
+static inline uint32_t scope_ch1_frequency_mhz(const scope_snapshot_t* snap) {
+    return (uint32_t)(((uint64_t)snap->ch1_increment * snap->sample_rate * 1000) >> 32);
+}
+
+#endif // SCOPE_FRAME_H
@@ -0,0 +1,149 @@
+#include "scope_stream.h"
+#include "scope_frame.h"
+#include "levitation_control.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Frame buffer lives on this stack, not in static DRAM
+#define SCOPE_TASK_STACK_SIZE   (3072 + SCOPE_STREAM_SAMPLES * 2)
+// Lowest application priority: only runs when nothing else wants the CPU
+#define SCOPE_TASK_PRIORITY     (tskIDLE_PRIORITY + 1)
+#define SCOPE_SEND_TIMEOUT_MS   500
+#define SCOPE_REQUEST_TIMEOUT_MS 2000
+
+static const char SCOPE_HEADERS[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "\r\n";
+
+static int g_listen = -1;
+static TaskHandle_t g_task = nullptr;
+static scope_stream_stats_t g_stats;
+
+static bool send_all(int fd, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0) {
+        ssize_t sent = send(fd, p, len, 0);
+        if (sent <= 0) return false;
+        p += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+/**
+ * Discard the request up to the blank line; there is a single resource
+ */
+static bool read_request(int fd) {
+    static const char END[] = "\r\n\r\n";
+    int match = 0;
+    char c;
+    while (match < 4) {
+        if (recv(fd, &c, 1, 0) != 1) return false;
+        match = (c == END[match]) ? match + 1 : (c == '\r' ? 1 : 0);
+    }
+    return true;
+}
+
+static void set_timeout(int fd, int option, uint32_t ms) {
+    struct timeval tv;
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, option, &tv, sizeof(tv));
+}
+
+static void serve(int fd) {
+    struct {
+        scope_frame_header_t header;
+        uint8_t samples[SCOPE_STREAM_SAMPLES * 2];
+    } frame;
+    
+    TickType_t last_wake = xTaskGetTickCount();
+    const TickType_t period = pdMS_TO_TICKS(1000 / SCOPE_STREAM_FPS);
+    
+    while (true) {
+        scope_snapshot_t snap;
+        levitation_get_scope_snapshot(&snap);
+        if (snap.waveform == SCOPE_WAVEFORM_SINE_LUT && !snap.lut) {
+            vTaskDelayUntil(&last_wake, period);
+            continue;  // Generator not up yet
+        }
+        
+        frame.header.magic = SCOPE_FRAME_MAGIC;
+        frame.header.version = SCOPE_FRAME_VERSION;
+        frame.header.waveform = snap.waveform;
+        frame.header.count = SCOPE_STREAM_SAMPLES;
+        frame.header.seq = g_stats.frames;
+        frame.header.sample_rate = snap.sample_rate;
+        frame.header.frequency_hz = (uint32_t)levitation_get_frequency();
+        frame.header.phase = snap.offset;
+        frame.header.ch1_frequency_mhz = scope_ch1_frequency_mhz(&snap);
+        if (levitation_is_running()) {
+            scope_render(&snap, frame.samples, SCOPE_STREAM_SAMPLES);
+        } else {
+            memset(frame.samples, 0, sizeof(frame.samples));
+        }
+        
+        char chunk_header[12];
+        int chunk_len = snprintf(chunk_header, sizeof(chunk_header), "%X\r\n", (unsigned)sizeof(frame));
+        if (!send_all(fd, chunk_header, chunk_len) ||
+            !send_all(fd, &frame, sizeof(frame)) ||
+            !send_all(fd, "\r\n", 2)) {
+            g_stats.send_failures++;
+            return;
+        }
+        g_stats.frames++;
+        
+        vTaskDelayUntil(&last_wake, period);
+    }
+}
+
+static void scope_task(void* arg) {
+    (void)arg;
+    while (true) {
+        int fd = accept(g_listen, nullptr, nullptr);
+        if (fd < 0) continue;
+        
+        set_timeout(fd, SO_RCVTIMEO, SCOPE_REQUEST_TIMEOUT_MS);
+        set_timeout(fd, SO_SNDTIMEO, SCOPE_SEND_TIMEOUT_MS);
+        if (read_request(fd) && send_all(fd, SCOPE_HEADERS, sizeof(SCOPE_HEADERS) - 1)) {
+            g_stats.viewers++;
+            serve(fd);
+        }
+        closesocket(fd);
+    }
+}
+
+bool scope_stream_begin(uint16_t port) {
+    if (g_task) return true;
+    
+    g_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (g_listen < 0) {
+        return false;
+    }
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    
+    if (bind(g_listen, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(g_listen, 2) < 0 ||
+        xTaskCreate(scope_task, "scope", SCOPE_TASK_STACK_SIZE, nullptr,
+                    SCOPE_TASK_PRIORITY, &g_task) != pdPASS) {
+        closesocket(g_listen);
+        g_listen = -1;
+        g_task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void scope_stream_get_stats(scope_stream_stats_t* stats) {
+    *stats = g_stats;
+}
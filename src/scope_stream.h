@@ -0,0 +1,47 @@
+#ifndef SCOPE_STREAM_H
+#define SCOPE_STREAM_H
+
+#include <Arduino.h>
+
+/**
+ * Virtual oscilloscope stream
+ *
+ * Serves a chunked HTTP response of binary frames (scope_frame.h) with the
+ * sample sequence both channels are emitting, for the time-domain and
+ * X-Y views in the UI. Each frame starts from a lock-free snapshot of the
+ * generator (levitation_get_scope_snapshot()) and is rendered from the
+ * live LUT, so capturing never touches the ISR or the output.
+ *
+ * Runs in its own lowest-priority task on its own port with blocking
+ * sends, paced to SCOPE_STREAM_FPS, so a slow viewer only slows its own
+ * stream. One viewer at a time; the next one waits in the backlog.
+ */
+
+#ifndef SCOPE_STREAM_FPS
+#define SCOPE_STREAM_FPS 10
+#endif
+
+#ifndef SCOPE_STREAM_SAMPLES
+#define SCOPE_STREAM_SAMPLES 512    // Sample pairs per frame
+#endif
+
+typedef struct {
+    uint32_t viewers;           // Connections served since boot
+    uint32_t frames;            // Frames sent
+    uint32_t send_failures;     // Viewers dropped on a failed or timed-out send
+} scope_stream_stats_t;
+
+/**
+ * Open the port and start the stream task
+ * @param port TCP port (UI expects 82)
+ * @return true if successful, false otherwise
+ */
+bool scope_stream_begin(uint16_t port = 82);
+
+/**
+ * Read stream counters
+ * @param stats Filled with the current counters
+ */
+void scope_stream_get_stats(scope_stream_stats_t* stats);
+
+#endif // SCOPE_STREAM_H
@@ -0,0 +1,24 @@
+#include "setpoint.h"
+#include "levitation_control.h"
+#include "persistence.h"
+#include "position_loop.h"
+#include "position_map.h"
+#include "event_log.h"
+
+void setpoint_apply_phase(phase_t phase, input_source_t source) {
+    levitation_set_phase(phase);
+    // With the loop closed the phase is only the feed-forward; hold its height
+    if (position_loop_is_enabled()) {
+        position_loop_set_target(position_map_mm_for_phase(phase));
+    }
+    input_recorder_record(source, INPUT_KIND_PHASE, phase.turns);
+    
+    // RAM copy only; the persistence task commits it once the drag settles
+    levitation_state_t state;
+    state.frequency_hz = (uint32_t)levitation_get_frequency();
+    state.phase = phase;
+    persistence_save(&state);
+    
+    // Formatted later by the log task, not on the caller's time
+    event_log(EVENT_PHASE, phase.turns);
+}
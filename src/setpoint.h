@@ -0,0 +1,27 @@
+#ifndef SETPOINT_H
+#define SETPOINT_H
+
+#include "phase_units.h"
+#include "input_recorder.h"
+
+/**
+ * Single entry point for trap setpoints
+ *
+ * HTTP, the UDP control port and rig sync moves all change the trap
+ * through setpoint_apply_phase(), so each of them gets every side effect
+ * of a setpoint: the output, the closed loop's target height, the input
+ * record for replay, the debounced NVS save and the deferred log.
+ * Control paths that are not user setpoints (the position loop's own
+ * output, test mode on the serial port) call levitation_set_phase()
+ * directly.
+ */
+
+/**
+ * Apply a new phase setpoint
+ * Safe from any task, not from an ISR
+ * @param phase Phase shift between the channels
+ * @param source Control input it came from, for the input record
+ */
+void setpoint_apply_phase(phase_t phase, input_source_t source);
+
+#endif // SETPOINT_H
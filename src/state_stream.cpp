@@ -0,0 +1,305 @@
+#include "state_stream.h"
+#include <errno.h>
+#include <fcntl.h>
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "levitation_control.h"
+#include "position_map.h"
+
+#define STREAM_TASK_STACK_SIZE  3072
+// Same as the scope stream: only runs when nothing else wants the CPU
+#define STREAM_TASK_PRIORITY    (tskIDLE_PRIORITY + 1)
+#define PENDING_SIZE            160         // Largest frame, including a full state
+#define HANDSHAKE_TIMEOUT_MS    2000
+#define KEEPALIVE_MS            15000
+// A peer that is alive but never reads holds its window at zero, and lwIP's
+// persist timer keeps such a connection open forever: drop it instead
+#define STALL_TIMEOUT_MS        (3 * KEEPALIVE_MS)
+
+typedef struct {
+    phase_t phase;
+    uint32_t frequency_hz;
+    bool running;
+} stream_state_t;
+
+typedef enum {
+    SUB_FREE = 0,
+    SUB_HANDSHAKE,              // Reading the HTTP request
+    SUB_STREAMING,
+} sub_status_t;
+
+typedef struct {
+    int fd;
+    sub_status_t status;
+    uint8_t header_match;       // Progress through "\r\n\r\n"
+    bool has_sent;              // last_sent holds a state the client knows
+    stream_state_t last_sent;
+    uint32_t last_send_ms;
+    uint32_t since_ms;          // Handshake start
+    uint32_t drained_ms;        // Last time pending was empty
+    char pending[PENDING_SIZE]; // Unsent tail of a partially written frame
+    uint16_t pending_len;
+} subscriber_t;
+
+static const char SSE_HEADERS[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "\r\n";
+
+static int g_listen = -1;
+static TaskHandle_t g_task = nullptr;
+static subscriber_t g_subs[STATE_STREAM_MAX_SUBSCRIBERS];
+static uint32_t g_min_interval_ms = 50;
+static state_stream_stats_t g_stats;
+static stream_state_t g_prev_state;
+
+static void drop(subscriber_t* sub) {
+    closesocket(sub->fd);
+    sub->fd = -1;
+    sub->status = SUB_FREE;
+    g_stats.dropped++;
+    g_stats.clients--;
+}
+
+/**
+ * Non-blocking write; keeps whatever the socket did not take in `pending`
+ * @return false if the connection is dead
+ */
+static bool write_frame(subscriber_t* sub, const char* data, size_t len) {
+    if (sub->pending_len + len > PENDING_SIZE) {
+        return false;
+    }
+    memcpy(sub->pending + sub->pending_len, data, len);
+    sub->pending_len += len;
+    
+    ssize_t sent = send(sub->fd, sub->pending, sub->pending_len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    memmove(sub->pending, sub->pending + sent, sub->pending_len - sent);
+    sub->pending_len -= sent;
+    return true;
+}
+
+static bool flush_pending(subscriber_t* sub) {
+    if (sub->pending_len == 0) return true;
+    return write_frame(sub, "", 0);
+}
+
+/**
+ * Encode the fields of `now` that differ from `prev` (all fields if prev is null)
+ */
+static int encode_delta(char* buf, size_t size, const stream_state_t* now, const stream_state_t* prev) {
+    int len = snprintf(buf, size, "data: {");
+    const char* sep = "";
+    
+    if (!prev || !phase_equal(prev->phase, now->phase)) {
+        len += snprintf(buf + len, size - len, "%s\"phase\":%.2f,\"mm\":%.3f", sep,
+                        phase_to_degrees(now->phase), position_map_mm_for_phase(now->phase));
+        sep = ",";
+    }
+    if (!prev || prev->frequency_hz != now->frequency_hz) {
+        len += snprintf(buf + len, size - len, "%s\"frequency\":%lu", sep, (unsigned long)now->frequency_hz);
+        sep = ",";
+    }
+    if (!prev || prev->running != now->running) {
+        len += snprintf(buf + len, size - len, "%s\"running\":%s", sep, now->running ? "true" : "false");
+    }
+    len += snprintf(buf + len, size - len, "}\n\n");
+    return len;
+}
+
+static bool state_equal(const stream_state_t* a, const stream_state_t* b) {
+    return phase_equal(a->phase, b->phase) && a->frequency_hz == b->frequency_hz && a->running == b->running;
+}
+
+/**
+ * Drain the receive side: subscribers never send after the request
+ * @return false once the peer has closed or reset the connection
+ */
+static bool peer_open(subscriber_t* sub) {
+    char buf[32];
+    while (true) {
+        ssize_t n = recv(sub->fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0) continue;
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+static void accept_subscribers(uint32_t now_ms) {
+    while (true) {
+        int fd = accept(g_listen, nullptr, nullptr);
+        if (fd < 0) return;
+        
+        subscriber_t* sub = nullptr;
+        for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS; i++) {
+            if (g_subs[i].status == SUB_FREE) {
+                sub = &g_subs[i];
+                break;
+            }
+        }
+        if (!sub) {
+            // Table full: refuse rather than evict someone who is keeping up;
+            // subscribers that stopped reading free their slot after STALL_TIMEOUT_MS
+            closesocket(fd);
+            g_stats.dropped++;
+            continue;
+        }
+        
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        sub->fd = fd;
+        sub->status = SUB_HANDSHAKE;
+        sub->header_match = 0;
+        sub->has_sent = false;
+        sub->pending_len = 0;
+        sub->since_ms = now_ms;
+        sub->drained_ms = now_ms;
+        g_stats.clients++;
+    }
+}
+
+static void handshake(subscriber_t* sub, uint32_t now_ms) {
+    // Discard the request; the stream has a single resource
+    static const char END[] = "\r\n\r\n";
+    char c;
+    ssize_t n = 0;
+    while (sub->header_match < 4 && (n = recv(sub->fd, &c, 1, MSG_DONTWAIT)) == 1) {
+        sub->header_match = (c == END[sub->header_match]) ? sub->header_match + 1 : (c == '\r' ? 1 : 0);
+    }
+    bool closed = n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+    
+    if (sub->header_match == 4) {
+        sub->status = SUB_STREAMING;
+        if (!write_frame(sub, SSE_HEADERS, sizeof(SSE_HEADERS) - 1)) {
+            drop(sub);
+        }
+    } else if (now_ms - sub->since_ms > HANDSHAKE_TIMEOUT_MS || closed) {
+        drop(sub);
+    }
+}
+
+/**
+ * One round: accept, read the state once, serve every subscriber
+ */
+static void poll_subscribers() {
+    uint32_t now_ms = millis();
+    accept_subscribers(now_ms);
+    
+    // One snapshot per round, shared by all subscribers
+    stream_state_t state;
+    state.phase = levitation_get_phase();
+    state.frequency_hz = (uint32_t)levitation_get_frequency();
+    state.running = levitation_is_running();
+    
+    // A change between two rounds that a subscriber cannot get right away
+    // is folded into its next frame
+    bool new_change = !state_equal(&state, &g_prev_state);
+    g_prev_state = state;
+    
+    char frame[PENDING_SIZE];
+    
+    for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS; i++) {
+        subscriber_t* sub = &g_subs[i];
+        if (sub->status == SUB_FREE) continue;
+        if (sub->status == SUB_HANDSHAKE) {
+            handshake(sub, now_ms);
+            continue;
+        }
+        if (!peer_open(sub) || !flush_pending(sub)) {
+            drop(sub);
+            continue;
+        }
+        if (sub->pending_len == 0) {
+            sub->drained_ms = now_ms;
+        } else if (now_ms - sub->drained_ms > STALL_TIMEOUT_MS) {
+            // No keepalive gets through to a full window; its slot is
+            // better spent on the next operator
+            drop(sub);
+            continue;
+        }
+        
+        bool changed = !sub->has_sent || !state_equal(&state, &sub->last_sent);
+        bool due = now_ms - sub->last_send_ms >= g_min_interval_ms;
+        bool idle = now_ms - sub->last_send_ms >= KEEPALIVE_MS;
+        
+        // Socket still busy with the previous frame: coalesce into a later one
+        if (sub->pending_len > 0 || (changed && !due)) {
+            if (new_change) g_stats.coalesced++;
+            continue;
+        }
+        
+        int len = 0;
+        if (changed) {
+            len = encode_delta(frame, sizeof(frame), &state, sub->has_sent ? &sub->last_sent : nullptr);
+        } else if (idle) {
+            // SSE comment; also how dead connections are detected
+            len = snprintf(frame, sizeof(frame), ": keepalive\n\n");
+        }
+        if (len == 0) continue;
+        
+        if (!write_frame(sub, frame, len)) {
+            drop(sub);
+            continue;
+        }
+        if (changed) {
+            sub->last_sent = state;
+            sub->has_sent = true;
+            g_stats.frames++;
+        }
+        sub->last_send_ms = now_ms;
+    }
+}
+
+static void stream_task(void* arg) {
+    (void)arg;
+    TickType_t last_wake = xTaskGetTickCount();
+    const TickType_t period = pdMS_TO_TICKS(STATE_STREAM_TICK_MS);
+    while (true) {
+        poll_subscribers();
+        vTaskDelayUntil(&last_wake, period);
+    }
+}
+
+bool state_stream_begin(uint16_t port, uint32_t min_interval_ms) {
+    g_min_interval_ms = min_interval_ms;
+    if (g_task) return true;
+    
+    for (int i = 0; i < STATE_STREAM_MAX_SUBSCRIBERS; i++) {
+        g_subs[i].fd = -1;
+        g_subs[i].status = SUB_FREE;
+    }
+    g_stats.slot_bytes = sizeof(subscriber_t);
+    
+    g_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (g_listen < 0) {
+        return false;
+    }
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    
+    if (bind(g_listen, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(g_listen, 4) < 0 ||
+        fcntl(g_listen, F_SETFL, fcntl(g_listen, F_GETFL, 0) | O_NONBLOCK) < 0 ||
+        xTaskCreate(stream_task, "state_stream", STREAM_TASK_STACK_SIZE, nullptr,
+                    STREAM_TASK_PRIORITY, &g_task) != pdPASS) {
+        closesocket(g_listen);
+        g_listen = -1;
+        g_task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void state_stream_get_stats(state_stream_stats_t* stats) {
+    *stats = g_stats;
+}
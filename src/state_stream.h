@@ -0,0 +1,54 @@
+#ifndef STATE_STREAM_H
+#define STATE_STREAM_H
+
+#include <Arduino.h>
+
+/**
+ * Server-Sent Events stream of the levitation state
+ *
+ * Every connected client receives the current phase, frequency, trap
+ * position and running status, first in full and then as deltas that
+ * only carry the fields that changed. Updates are coalesced per client:
+ * a client gets at most one frame per interval, always with the latest
+ * state, and a client whose socket buffer is full is simply skipped that
+ * round, so a slow client never delays the others or the control loop.
+ * A client that leaves a frame unsent for three keepalive intervals
+ * (45 s) is dropped, so stalled tabs cannot hold every slot.
+ *
+ * The stream runs on its own port (the synchronous WebServer closes
+ * connections after each handler), with CORS enabled for the UI on :80,
+ * and in its own low-priority task with non-blocking sockets, so neither
+ * subscribers nor a busy HTTP handler in loop() hold the other up.
+ */
+
+#ifndef STATE_STREAM_MAX_SUBSCRIBERS
+#define STATE_STREAM_MAX_SUBSCRIBERS 8  // Each also takes an lwIP socket (CONFIG_LWIP_MAX_SOCKETS)
+#endif
+
+#ifndef STATE_STREAM_TICK_MS
+#define STATE_STREAM_TICK_MS 10         // How often the task checks for changes
+#endif
+
+/**
+ * Open the port and start the stream task
+ * @param port TCP port for the event stream (UI expects 81)
+ * @param min_interval_ms Minimum time between frames to one client
+ * @return true if successful, false otherwise
+ */
+bool state_stream_begin(uint16_t port = 81, uint32_t min_interval_ms = 50);
+
+typedef struct {
+    uint32_t clients;           // Currently connected subscribers
+    uint32_t frames;            // Frames sent since boot
+    uint32_t coalesced;         // State changes folded into a later frame
+    uint32_t dropped;           // Subscribers dropped (disconnect, timeout, stalled, full table)
+    uint32_t slot_bytes;        // RAM per subscriber slot, excluding lwIP buffers
+} state_stream_stats_t;
+
+/**
+ * Read stream counters
+ * @param stats Filled with the current counters
+ */
+void state_stream_get_stats(state_stream_stats_t* stats);
+
+#endif // STATE_STREAM_H
@@ -1,58 +1,90 @@
 #include "test_mode.h"
 #include "levitation_control.h"
+#include "input_recorder.h"
+#include "phase_shifted_dac.h"
+#include "event_log.h"
+
+// One flash-resident literal per block instead of a print call per line
+static const char TEST_MODE_BANNER[] =
+    "========================================\n"
+    "OSCILLOSCOPE TEST MODE\n"
+    "========================================\n"
+    "\n"
+    "HARDWARE CONNECTIONS:\n"
+    "  Oscilloscope Channel 1 -> GPIO25 (DAC1)\n"
+    "  Oscilloscope Channel 2 -> GPIO26 (DAC2)\n"
+    "  Oscilloscope Ground -> GND on ESP32\n"
+    "\n"
+    "RECOMMENDED SCOPE SETTINGS:\n";
+
+static const char TEST_MODE_SCOPE_SETTINGS[] =
+    "  Voltage: 500mV/div or 1V/div\n"
+    "  Coupling: DC\n"
+    "  Trigger: Channel 1, Rising Edge\n"
+    "  Try X-Y mode for phase visualization!\n"
+    "\n";
+
+static const char TEST_MODE_EXPECTED[] =
+    "\n"
+    "\n"
+    "EXPECTED ON OSCILLOSCOPE:\n"
+    "  - Two sine waves at the same frequency\n"
+    "  - Phase difference matches the set phase shift\n"
+    "  - Both waves should be clean and stable\n"
+    "  - At 0°: waves should overlap perfectly\n"
+    "  - At 90°: waves should be 1/4 cycle apart\n"
+    "  - At 180°: waves should be inverted\n"
+    "\n";
+
+static const char TEST_MODE_COMMANDS[] =
+    "========================================\n"
+    "OSCILLOSCOPE TEST MODE - INTERACTIVE\n"
+    "========================================\n"
+    "\n"
+    "Commands:\n"
+    "  's' - Start waveforms\n"
+    "  'x' - Stop waveforms\n"
+    "  'p' - Set phase (will prompt for value)\n"
+    "  'f' - Set frequency (will prompt for value)\n"
+    "  'r' - Set sample rate (dac_isr only, 0 = auto)\n"
+    "  'w' - Sweep phase 0° to 360°\n"
+    "  '0' - Set phase to 0°\n"
+    "  '9' - Set phase to 90°\n"
+    "  '1' - Set phase to 180°\n"
+    "  '2' - Set phase to 270°\n"
+    "  'i' - Show current info\n"
+    "\n";
 
 static float g_test_frequency = 1000.0f;
-static float g_test_phase = 0.0f;
+static phase_t g_test_phase = PHASE_ZERO;
 static bool g_test_running = false;
 
-void test_mode_init(float test_frequency, float phase_shift) {
+void test_mode_init(float test_frequency, phase_t phase_shift) {
     g_test_frequency = test_frequency;
     g_test_phase = phase_shift;
+    event_log_begin();
     
-    Serial.println("========================================");
-    Serial.println("OSCILLOSCOPE TEST MODE");
-    Serial.println("========================================");
-    Serial.println();
-    Serial.println("HARDWARE CONNECTIONS:");
-    Serial.println("  Oscilloscope Channel 1 -> GPIO25 (DAC1)");
-    Serial.println("  Oscilloscope Channel 2 -> GPIO26 (DAC2)");
-    Serial.println("  Oscilloscope Ground -> GND on ESP32");
-    Serial.println();
-    Serial.println("RECOMMENDED SCOPE SETTINGS:");
+    Serial.print(TEST_MODE_BANNER);
     Serial.print("  Timebase: ");
     if (test_frequency <= 5000) {
         Serial.println("200us/div to 1ms/div");
     } else {
         Serial.println("5us/div to 10us/div");
     }
-    Serial.println("  Voltage: 500mV/div or 1V/div");
-    Serial.println("  Coupling: DC");
-    Serial.println("  Trigger: Channel 1, Rising Edge");
-    Serial.println("  Try X-Y mode for phase visualization!");
-    Serial.println();
+    Serial.print(TEST_MODE_SCOPE_SETTINGS);
     Serial.print("Test Frequency: ");
     Serial.print(test_frequency);
     Serial.println(" Hz");
     Serial.print("Initial Phase Shift: ");
-    Serial.print(phase_shift);
-    Serial.println("°");
-    Serial.println();
-    Serial.println("EXPECTED ON OSCILLOSCOPE:");
-    Serial.println("  - Two sine waves at the same frequency");
-    Serial.println("  - Phase difference matches the set phase shift");
-    Serial.println("  - Both waves should be clean and stable");
-    Serial.println("  - At 0°: waves should overlap perfectly");
-    Serial.println("  - At 90°: waves should be 1/4 cycle apart");
-    Serial.println("  - At 180°: waves should be inverted");
-    Serial.println();
+    Serial.print(phase_to_degrees(phase_shift));
+    Serial.print("°");
+    Serial.print(TEST_MODE_EXPECTED);
     
     // Initialize levitation system with test frequency
     if (levitation_init(test_frequency, phase_shift)) {
-        Serial.println("✓ Test mode initialized successfully!");
-        Serial.println();
+        event_log(EVENT_TEST_INIT_OK);
     } else {
-        Serial.println("✗ Failed to initialize test mode!");
-        Serial.println("Check your connections and try again.");
+        event_log(EVENT_TEST_INIT_FAILED);
     }
 }
 
@@ -61,12 +93,10 @@ void test_mode_phase_sweep(uint32_t sweep_speed_ms) {
         test_mode_start();
     }
     
-    Serial.println("Starting phase sweep test...");
-    Serial.println("Observe the phase relationship on your oscilloscope.");
-    Serial.println("Press any key to stop.");
-    Serial.println();
+    event_log(EVENT_TEST_SWEEP_STARTED);
     
-    float phase = 0.0f;
+    phase_t phase = PHASE_ZERO;
+    uint32_t degrees = 0;
     unsigned long last_update = millis();
     
     while (true) {
@@ -78,66 +108,50 @@ void test_mode_phase_sweep(uint32_t sweep_speed_ms) {
         
         // Update phase
         if (millis() - last_update >= sweep_speed_ms) {
-            phase += 1.0f;  // 1 degree per update
-            if (phase >= 360.0f) {
-                phase = 0.0f;
-            }
+            degrees = (degrees + 1) % 360;  // 1 degree per update
+            phase = phase_from_degrees(degrees);
             
             test_mode_set_phase(phase);
             last_update = millis();
             
             // Print every 45 degrees
-            if ((int)phase % 45 == 0) {
-                Serial.print("Phase: ");
-                Serial.print(phase);
-                Serial.println("°");
+            if (degrees % 45 == 0) {
+                event_log(EVENT_TEST_SWEEP_PHASE, degrees);
             }
         }
         
         delay(1);  // Small delay to allow serial processing
     }
     
-    Serial.println("Phase sweep stopped.");
+    event_log(EVENT_TEST_SWEEP_STOPPED);
 }
 
-void test_mode_set_phase(float phase_shift) {
+void test_mode_set_phase(phase_t phase_shift) {
     g_test_phase = phase_shift;
     levitation_set_phase(phase_shift);
+    input_recorder_record(INPUT_SOURCE_SERIAL, INPUT_KIND_PHASE, phase_shift.turns);
 }
 
-float test_mode_get_phase() {
+phase_t test_mode_get_phase() {
     return g_test_phase;
 }
 
 void test_mode_start() {
     levitation_start();
+    input_recorder_record(INPUT_SOURCE_SERIAL, INPUT_KIND_START, 0);
     g_test_running = true;
-    Serial.println("Test mode started - waveforms are now active");
+    event_log(EVENT_TEST_STARTED);
 }
 
 void test_mode_stop() {
     levitation_stop();
+    input_recorder_record(INPUT_SOURCE_SERIAL, INPUT_KIND_STOP, 0);
     g_test_running = false;
-    Serial.println("Test mode stopped");
+    event_log(EVENT_TEST_STOPPED);
 }
 
 void test_mode_run() {
-    Serial.println("========================================");
-    Serial.println("OSCILLOSCOPE TEST MODE - INTERACTIVE");
-    Serial.println("========================================");
-    Serial.println();
-    Serial.println("Commands:");
-    Serial.println("  's' - Start waveforms");
-    Serial.println("  'x' - Stop waveforms");
-    Serial.println("  'p' - Set phase (will prompt for value)");
-    Serial.println("  'f' - Set frequency (will prompt for value)");
-    Serial.println("  'w' - Sweep phase 0° to 360°");
-    Serial.println("  '0' - Set phase to 0°");
-    Serial.println("  '9' - Set phase to 90°");
-    Serial.println("  '1' - Set phase to 180°");
-    Serial.println("  '2' - Set phase to 270°");
-    Serial.println("  'i' - Show current info");
-    Serial.println();
+    Serial.print(TEST_MODE_COMMANDS);
     
     bool running = false;
     
@@ -165,10 +179,8 @@ void test_mode_run() {
                         while (!Serial.available()) delay(10);
                         float phase = Serial.parseFloat();
                         Serial.readStringUntil('\n');  // Clear buffer
-                        test_mode_set_phase(phase);
-                        Serial.print("Phase set to: ");
-                        Serial.print(phase);
-                        Serial.println("°");
+                        test_mode_set_phase(phase_from_degrees(phase));
+                        event_log(EVENT_TEST_PHASE_SET, phase_from_degrees(phase).turns);
                     }
                     break;
                     
@@ -180,10 +192,27 @@ void test_mode_run() {
                         float freq = Serial.parseFloat();
                         Serial.readStringUntil('\n');  // Clear buffer
                         levitation_set_frequency(freq);
+                        input_recorder_record(INPUT_SOURCE_SERIAL, INPUT_KIND_FREQUENCY, (uint32_t)freq);
                         g_test_frequency = freq;
-                        Serial.print("Frequency set to: ");
-                        Serial.print(freq);
-                        Serial.println(" Hz");
+                        event_log(EVENT_TEST_FREQUENCY_SET, event_log_float_arg(freq));
+                    }
+                    break;
+                    
+                case 'r':
+                case 'R':
+                    {
+                        Serial.println("Enter sample rate in Hz (0 = auto):");
+                        while (!Serial.available()) delay(10);
+                        uint32_t rate = (uint32_t)Serial.parseInt();
+                        Serial.readStringUntil('\n');  // Clear buffer
+                        uint32_t applied;
+                        if (levitation_set_sample_rate(rate, &applied)) {
+                            // The rate the output switches to, not the one still running
+                            input_recorder_record(INPUT_SOURCE_SERIAL, INPUT_KIND_SAMPLE_RATE, applied);
+                            event_log(EVENT_TEST_SAMPLE_RATE_SET, rate);
+                        } else {
+                            event_log(EVENT_TEST_NO_SAMPLE_CLOCK);
+                        }
                     }
                     break;
                     
@@ -193,23 +222,23 @@ void test_mode_run() {
                     break;
                     
                 case '0':
-                    test_mode_set_phase(0.0f);
-                    Serial.println("Phase set to 0°");
+                    test_mode_set_phase(PHASE_ZERO);
+                    event_log(EVENT_TEST_PHASE_SET, PHASE_ZERO.turns);
                     break;
                     
                 case '9':
-                    test_mode_set_phase(90.0f);
-                    Serial.println("Phase set to 90°");
+                    test_mode_set_phase(phase_from_degrees(90));
+                    event_log(EVENT_TEST_PHASE_SET, phase_from_degrees(90).turns);
                     break;
                     
                 case '1':
-                    test_mode_set_phase(180.0f);
-                    Serial.println("Phase set to 180°");
+                    test_mode_set_phase(phase_from_degrees(180));
+                    event_log(EVENT_TEST_PHASE_SET, phase_from_degrees(180).turns);
                     break;
                     
                 case '2':
-                    test_mode_set_phase(270.0f);
-                    Serial.println("Phase set to 270°");
+                    test_mode_set_phase(phase_from_degrees(270));
+                    event_log(EVENT_TEST_PHASE_SET, phase_from_degrees(270).turns);
                     break;
                     
                 case 'i':
@@ -219,17 +248,24 @@ void test_mode_run() {
                     Serial.print(levitation_get_frequency());
                     Serial.println(" Hz");
                     Serial.print("Phase Shift: ");
-                    Serial.print(levitation_get_phase());
+                    Serial.print(phase_to_degrees(levitation_get_phase()));
                     Serial.println("°");
                     Serial.print("Status: ");
                     Serial.println(running ? "Running" : "Stopped");
+                    if (levitation_get_sample_rate()) {
+                        phase_shifted_dac_stats_t stats;
+                        phase_shifted_dac_get_stats(&stats);
+                        Serial.printf("Sample rate: %lu Hz\n", (unsigned long)levitation_get_sample_rate());
+                        Serial.printf("Reconfigurations: %lu (last: %lu us to switch, %lu cycle sample gap)\n",
+                                      (unsigned long)stats.reconfigurations,
+                                      (unsigned long)stats.reconfig_latency_us,
+                                      (unsigned long)stats.reconfig_gap_cycles);
+                    }
                     break;
                     
                 default:
                     if (cmd != '\n' && cmd != '\r') {
-                        Serial.print("Unknown command: '");
-                        Serial.print(cmd);
-                        Serial.println("'");
+                        event_log(EVENT_TEST_UNKNOWN_COMMAND, (uint32_t)cmd);
                     }
                     break;
             }
@@ -2,6 +2,7 @@
 #define TEST_MODE_H
 
 #include <Arduino.h>
+#include "phase_units.h"
 
 /**
  * Test mode for oscilloscope verification
@@ -12,9 +13,9 @@
 /**
  * Initialize test mode with lower frequency for easier oscilloscope viewing
  * @param test_frequency Test frequency in Hz (recommended: 1000-10000 Hz for scope viewing)
- * @param phase_shift Phase shift between channels in degrees
+ * @param phase_shift Phase shift between channels
  */
-void test_mode_init(float test_frequency = 1000.0f, float phase_shift = 0.0f);
+void test_mode_init(float test_frequency = 1000.0f, phase_t phase_shift = PHASE_ZERO);
 
 /**
  * Run a phase sweep test - automatically sweeps phase from 0° to 360°
@@ -25,15 +26,15 @@ void test_mode_phase_sweep(uint32_t sweep_speed_ms = 50);
 
 /**
  * Set fixed phase for testing
- * @param phase_shift Phase in degrees (0-360)
+ * @param phase_shift Phase shift between channels
  */
-void test_mode_set_phase(float phase_shift);
+void test_mode_set_phase(phase_t phase_shift);
 
 /**
  * Get current test phase
- * @return Current phase in degrees
+ * @return Current phase
  */
-float test_mode_get_phase();
+phase_t test_mode_get_phase();
 
 /**
  * Start test mode
@@ -0,0 +1,158 @@
+#include "udp_control.h"
+#include <Arduino.h>
+#include "lwip/sockets.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "levitation_control.h"
+#include "input_recorder.h"
+#include "setpoint.h"
+
+#define UDP_TASK_STACK_SIZE     3072
+// Above loop() (priority 1) so setpoints don't wait behind HTTP handling
+#define UDP_TASK_PRIORITY       (tskIDLE_PRIORITY + 3)
+
+static int g_socket = -1;
+static TaskHandle_t g_task = nullptr;
+static udp_control_stats_t g_stats;
+
+// Receive task only
+static bool g_session_active = false;
+static uint32_t g_session_id = 0;
+static uint32_t g_last_seq = 0;
+static uint32_t g_last_packet_ms = 0;
+static wifi_ps_type_t g_saved_ps = WIFI_PS_MIN_MODEM;
+static uint32_t g_retired[UDP_RETIRED_SESSIONS];
+static uint32_t g_retired_count = 0;
+static uint32_t g_retired_next = 0;
+
+static bool session_retired(uint32_t id) {
+    for (uint32_t i = 0; i < g_retired_count; i++) {
+        if (g_retired[i] == id) return true;
+    }
+    return false;
+}
+
+static void session_begin(uint32_t id, uint32_t seq) {
+    if (!g_session_active) {
+        // Keep the radio awake while setpoints are streaming, and put back
+        // whatever mode was in force when the session ends
+        if (esp_wifi_get_ps(&g_saved_ps) != ESP_OK) {
+            g_saved_ps = WIFI_PS_MIN_MODEM;
+        }
+        esp_wifi_set_ps(WIFI_PS_NONE);
+    } else {
+        // Taken over: the old controller's late datagrams must not take it back
+        g_retired[g_retired_next] = g_session_id;
+        g_retired_next = (g_retired_next + 1) % UDP_RETIRED_SESSIONS;
+        if (g_retired_count < UDP_RETIRED_SESSIONS) g_retired_count++;
+    }
+    g_session_active = true;
+    g_session_id = id;
+    // Accept `seq` itself as the first setpoint
+    g_last_seq = seq - 1;
+    g_stats.sessions++;
+}
+
+static void session_end() {
+    g_session_active = false;
+    // Idle for a whole timeout: any controller may start afresh
+    g_retired_count = 0;
+    esp_wifi_set_ps(g_saved_ps);
+}
+
+static void apply(const udp_setpoint_t* msg) {
+    if (msg->frequency_hz != 0 && msg->frequency_hz != (uint32_t)levitation_get_frequency()) {
+        levitation_set_frequency((float)msg->frequency_hz);
+        input_recorder_record(INPUT_SOURCE_UDP, INPUT_KIND_FREQUENCY, msg->frequency_hz);
+    }
+    
+    setpoint_apply_phase(phase_from_turns(msg->phase), INPUT_SOURCE_UDP);
+}
+
+static void udp_task(void* arg) {
+    (void)arg;
+    udp_setpoint_t msg;
+    struct sockaddr_in from;
+    
+    while (true) {
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(g_socket, &msg, sizeof(msg), 0, (struct sockaddr*)&from, &from_len);
+        uint32_t now_ms = millis();
+        
+        if (g_session_active && now_ms - g_last_packet_ms > UDP_SESSION_TIMEOUT_MS) {
+            session_end();
+        }
+        if (len < 0) {
+            continue;  // Receive timeout: only used to expire the session
+        }
+        if (len != sizeof(msg) || msg.magic != UDP_MAGIC || msg.version != UDP_VERSION ||
+            msg.type != UDP_MSG_SETPOINT) {
+            g_stats.malformed++;
+            continue;
+        }
+        g_stats.received++;
+        g_last_packet_ms = now_ms;
+        
+        // Latest controller wins: a new session id restarts the sequence,
+        // unless it is one a newer session already took over from
+        bool superseded = false;
+        if (!g_session_active || msg.session != g_session_id) {
+            superseded = session_retired(msg.session);
+            if (!superseded) {
+                session_begin(msg.session, msg.seq);
+            }
+        }
+        
+        // Serial-number comparison so the sequence may wrap
+        if (superseded) {
+            g_stats.superseded++;
+            msg.type = UDP_MSG_ACK_STALE;
+        } else if ((int32_t)(msg.seq - g_last_seq) > 0) {
+            g_last_seq = msg.seq;
+            apply(&msg);
+            g_stats.applied++;
+            msg.type = UDP_MSG_ACK_APPLIED;
+        } else {
+            g_stats.stale++;
+            msg.type = UDP_MSG_ACK_STALE;
+        }
+        
+        sendto(g_socket, &msg, sizeof(msg), 0, (struct sockaddr*)&from, from_len);
+    }
+}
+
+bool udp_control_begin(uint16_t port) {
+    if (g_task) return true;
+    
+    g_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (g_socket < 0) {
+        return false;
+    }
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    
+    // Wake up periodically even without traffic to expire the session
+    struct timeval timeout;
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    setsockopt(g_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    if (bind(g_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        xTaskCreate(udp_task, "udp_ctl", UDP_TASK_STACK_SIZE, nullptr,
+                    UDP_TASK_PRIORITY, &g_task) != pdPASS) {
+        closesocket(g_socket);
+        g_socket = -1;
+        g_task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void udp_control_get_stats(udp_control_stats_t* stats) {
+    *stats = g_stats;
+}
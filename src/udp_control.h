@@ -0,0 +1,80 @@
+#ifndef UDP_CONTROL_H
+#define UDP_CONTROL_H
+
+#include <stdint.h>
+
+/**
+ * Low-latency UDP control port
+ *
+ * Carries sequence-numbered binary setpoints. Unlike HTTP over TCP, a lost
+ * datagram is never retransmitted and never holds up newer ones: each
+ * setpoint supersedes the previous, so out-of-order or stale datagrams
+ * are simply dropped. Every setpoint is answered with an ack carrying the
+ * same sequence number so clients can measure apply latency.
+ *
+ * A new session id takes the port over from the current session. The ids
+ * of the last UDP_RETIRED_SESSIONS sessions taken over this way are
+ * remembered, and their datagrams are dropped as stale, so a reordered
+ * datagram from the old controller cannot take the port back. They are
+ * forgotten once the port has been idle for UDP_SESSION_TIMEOUT_MS.
+ *
+ * While a session is active (a setpoint seen within the last
+ * UDP_SESSION_TIMEOUT_MS) Wi-Fi modem power save is disabled so the radio
+ * does not sleep between datagrams; the power save mode in force before
+ * the session is restored when it ends.
+ *
+ * Wire format shared with tools/udp_client.cpp; keep this header free of
+ * Arduino dependencies.
+ */
+
+#define UDP_CONTROL_PORT        4210
+#define UDP_MAGIC               0x4C55      // "UL"
+#define UDP_VERSION             1
+#define UDP_SESSION_TIMEOUT_MS  3000
+
+#ifndef UDP_RETIRED_SESSIONS
+#define UDP_RETIRED_SESSIONS    4
+#endif
+
+typedef enum {
+    UDP_MSG_SETPOINT = 1,       // Client -> device
+    UDP_MSG_ACK_APPLIED = 2,    // Device -> client, setpoint applied
+    UDP_MSG_ACK_STALE = 3,      // Device -> client, dropped (older than last applied or superseded)
+} udp_msg_type_t;
+
+/**
+ * Setpoint / ack datagram, little-endian, 20 bytes
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;               // udp_msg_type_t
+    uint32_t session;           // Client-chosen id; a new id starts a new sequence
+    uint32_t seq;               // Increments per setpoint within a session
+    uint32_t phase;             // phase_t turns
+    uint32_t frequency_hz;      // 0 = leave unchanged
+} udp_setpoint_t;
+
+typedef struct {
+    uint32_t received;          // Valid setpoint datagrams
+    uint32_t applied;
+    uint32_t stale;             // Dropped: sequence not newer than last applied
+    uint32_t superseded;        // Dropped: session id a newer session took over from
+    uint32_t malformed;
+    uint32_t sessions;          // Sessions started
+} udp_control_stats_t;
+
+/**
+ * Open the UDP port and start the receive task
+ * @param port UDP port to listen on
+ * @return true if successful, false otherwise
+ */
+bool udp_control_begin(uint16_t port = UDP_CONTROL_PORT);
+
+/**
+ * Read the port counters
+ * @param stats Filled with the current counters
+ */
+void udp_control_get_stats(udp_control_stats_t* stats);
+
+#endif // UDP_CONTROL_H
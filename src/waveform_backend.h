@@ -0,0 +1,176 @@
+#ifndef WAVEFORM_BACKEND_H
+#define WAVEFORM_BACKEND_H
+
+#include <stdint.h>
+#include "phase_units.h"
+#include "scope_frame.h"
+
+/**
+ * Common interface for the waveform generation backends
+ *
+ * Backends derive from WaveformBackend<Self> (CRTP) and provide the
+ * *_impl() methods plus two compile-time capabilities:
+ *   - NAME:        human readable backend name
+ *   - PHASE_STEPS: distinct phase positions per period the output can hit
+ *
+ * Dispatch is resolved at compile time, so calls through this interface
+ * inline straight into the backend and the hot path has no virtual calls.
+ * The active backend is chosen per PlatformIO env in levitation_backend.h.
+ */
+template <typename Backend>
+class WaveformBackend {
+public:
+    /**
+     * Configure the outputs; does not start them
+     * @param frequency Output frequency in Hz
+     * @param phase Initial phase of channel 2 relative to channel 1
+     * @return true if successful, false otherwise
+     */
+    bool init(float frequency, phase_t phase) {
+        return backend().init_impl(frequency, phase);
+    }
+
+    void set_phase(phase_t phase) {
+        backend().set_phase_impl(phase);
+    }
+
+    void set_frequency(float frequency) {
+        backend().set_frequency_impl(frequency);
+    }
+
+    /**
+     * Re-run init on configured outputs without tearing them down
+     * Running outputs keep running across the change
+     * @return true if successful, false otherwise
+     */
+    bool reconfigure(float frequency, phase_t phase) {
+        return backend().reconfigure_impl(frequency, phase);
+    }
+
+    /**
+     * Change the software sample clock in place
+     * @param sample_rate Samples per second, 0 to auto-select
+     * @param applied_rate Set to the rate the clock switches to, after
+     *                     auto-selection and rounding to the timer
+     * @return false if the backend has no software sample clock
+     */
+    bool set_sample_rate(uint32_t sample_rate, uint32_t* applied_rate) {
+        return backend().set_sample_rate_impl(sample_rate, applied_rate);
+    }
+
+    void start() {
+        backend().start_impl();
+    }
+
+    void stop() {
+        backend().stop_impl();
+    }
+
+    /**
+     * Sample ISR counters; backends without a sample ISR report zeros
+     * @param samples Samples produced since boot
+     * @param deadline_misses Samples that were late or skipped
+     */
+    void isr_stats(uint32_t* samples, uint32_t* deadline_misses) {
+        backend().isr_stats_impl(samples, deadline_misses);
+    }
+
+    /**
+     * Software sample clock; backends without a sample ISR report zeros
+     * @param sample_rate Samples per second
+     * @param isr_cycles Worst-case CPU cycles per sample
+     */
+    void sample_clock(uint32_t* sample_rate, uint32_t* isr_cycles) {
+        backend().sample_clock_impl(sample_rate, isr_cycles);
+    }
+
+    /**
+     * Refine a virtual-scope snapshot; called with an ideal model of the
+     * output already filled in, so backends only override what they know
+     * better (waveform shape, live generator state)
+     * @param snapshot Snapshot to update
+     */
+    void scope_snapshot(scope_snapshot_t* snapshot) {
+        backend().scope_snapshot_impl(snapshot);
+    }
+
+    /**
+     * Discipline the carrier to a sync master (see rig_sync.h)
+     * @param rate_ppb Rate correction in parts per billion
+     * @param sync_offset Carrier phase correction, absolute
+     * @return false if the backend has no fine frequency control
+     */
+    bool trim_carrier(int32_t rate_ppb, phase_t sync_offset) {
+        return backend().trim_carrier_impl(rate_ppb, sync_offset);
+    }
+
+    /**
+     * Read the free-running carrier phase, without the phase shift
+     * @param carrier Carrier phase
+     * @param time_us esp_timer_get_time() at the read
+     * @return false if the backend cannot read its carrier
+     */
+    bool read_carrier(phase_t* carrier, int64_t* time_us) {
+        return backend().read_carrier_impl(carrier, time_us);
+    }
+
+    static constexpr const char* name() {
+        return Backend::NAME;
+    }
+
+    static constexpr uint32_t phase_steps() {
+        return Backend::PHASE_STEPS;
+    }
+
+protected:
+    WaveformBackend() {}
+
+    // Frequency and phase are already updated in place by every backend
+    bool reconfigure_impl(float frequency, phase_t phase) {
+        backend().set_frequency_impl(frequency);
+        backend().set_phase_impl(phase);
+        return true;
+    }
+
+    // Square-wave model is right for the timer/PWM backends
+    void scope_snapshot_impl(scope_snapshot_t* snapshot) {
+        (void)snapshot;
+    }
+
+    // Default for backends that generate samples in hardware
+    bool set_sample_rate_impl(uint32_t sample_rate, uint32_t* applied_rate) {
+        (void)sample_rate;
+        *applied_rate = 0;
+        return false;
+    }
+
+    void isr_stats_impl(uint32_t* samples, uint32_t* deadline_misses) {
+        *samples = 0;
+        *deadline_misses = 0;
+    }
+
+    void sample_clock_impl(uint32_t* sample_rate, uint32_t* isr_cycles) {
+        *sample_rate = 0;
+        *isr_cycles = 0;
+    }
+
+    // Timer dividers are far too coarse to trim by parts per billion
+    bool trim_carrier_impl(int32_t rate_ppb, phase_t sync_offset) {
+        (void)rate_ppb;
+        (void)sync_offset;
+        return false;
+    }
+
+    bool read_carrier_impl(phase_t* carrier, int64_t* time_us) {
+        (void)carrier;
+        (void)time_us;
+        return false;
+    }
+
+private:
+    Backend& backend() {
+        return *static_cast<Backend*>(this);
+    }
+};
+
+#endif // WAVEFORM_BACKEND_H
@@ -0,0 +1,387 @@
+/**
+ * Waveform backend bench
+ *
+ * Builds every WaveformBackend<> (ledc, mcpwm, cosine, dac_isr) unchanged
+ * against the simulated peripherals in tools/host and checks each one
+ * off-target:
+ *   - init/start/stop leave the outputs in the documented state
+ *   - a sweep of set_phase() over the full turn, read back from the
+ *     programmed registers: distinct phase positions reached (against the
+ *     backend's PHASE_STEPS) and worst phase error against the request
+ *   - set_phase() cost per call on this host
+ *   - update latency: the call cost plus the hardware's wait until the
+ *     new value takes effect (next PWM period for LEDC and MCPWM, next
+ *     sample for the DAC ISR, immediate for the CW inversion)
+ *   - the frequency each channel actually produces at 39, 40 and 41 kHz
+ *   - the dac_isr scope frame: channel 2 bit-identical to the ISR's
+ *     synthesis, channel 1 modelled at the CW generator's real frequency
+ *   - dac_isr init: the ISR cost calibration leaves the DAC2 pad at its
+ *     power-on code and makes no ISR-only calls from task context
+ *   - dac_isr sample rate changes while running: the rate set_sample_rate()
+ *     reports is the timer-rounded one the output switches to
+ * and exits non-zero if any check fails.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -pthread -I tools/host -I src -o backend_bench \
+ *       tools/backend_bench.cpp src/ledc_backend.cpp src/mcpwm_backend.cpp \
+ *       src/cosine_backend.cpp src/dac_isr_backend.cpp src/cw_generator.cpp \
+ *       src/phase_shifted_dac.cpp tools/host/esp_host.cpp
+ *
+ * Usage:
+ *   backend_bench [--sweep N] [--calls N]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <set>
+#include "esp_host.h"
+#include "soc/mcpwm_struct.h"
+#include "soc/rtc.h"
+#include "soc/rtc_io_reg.h"
+#include "soc/sens_reg.h"
+#include "dac_synth.h"
+#include "phase_shifted_dac.h"
+#include "ledc_backend.h"
+#include "mcpwm_backend.h"
+#include "cosine_backend.h"
+#include "dac_isr_backend.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do {                       \
+    if (!(cond)) {                                  \
+        printf("  FAIL: " __VA_ARGS__);             \
+        printf("\n");                               \
+        g_failures++;                               \
+    }                                               \
+} while (0)
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double turns_to_degrees(double turns) {
+    return turns * 360.0;
+}
+
+/**
+ * Signed distance between two phases in turns, in [-0.5, 0.5)
+ */
+static double phase_error(phase_t achieved, phase_t requested) {
+    return (int32_t)(achieved.turns - requested.turns) / 4294967296.0;
+}
+
+static double cw_frequency() {
+    uint32_t fstep = GET_PERI_REG_BITS2(SENS_SAR_DAC_CTRL1_REG, SENS_SW_FSTEP, SENS_SW_FSTEP_S);
+    return (double)fstep * RTC_FAST_CLK_FREQ_APPROX / 65536.0;
+}
+
+// ===== Per-backend register readback =====
+//
+// Each reads the simulated peripheral, not the backend's own state:
+//   phase():     channel 2 phase relative to channel 1 once the update lands
+//   running():   both outputs driven
+//   frequency(): what channels 1 and 2 actually produce
+//   latency_us(): worst wait from the register write to the output change
+//   settle():    let a staged clock change land (only the DAC ISR stages)
+
+struct LedcProbe {
+    static phase_t phase() {
+        host_ledc_channel_t* ch1 = &host_ledc_channels[0];
+        host_ledc_channel_t* ch2 = &host_ledc_channels[1];
+        // The written hpoint only takes effect at the period boundary
+        host_ledc_period_boundary();
+        uint32_t steps = 1UL << host_ledc_timers[ch2->timer].duty_resolution;
+        uint64_t lag = (ch2->hpoint + steps - ch1->hpoint) % steps;
+        return phase_from_turns((uint32_t)((lag << 32) / steps));
+    }
+    static bool running() {
+        return host_ledc_channels[0].output_enabled && host_ledc_channels[1].output_enabled;
+    }
+    static void frequency(double* ch1, double* ch2) {
+        *ch1 = host_ledc_frequency(host_ledc_channels[0].timer);
+        *ch2 = host_ledc_frequency(host_ledc_channels[1].timer);
+    }
+    static double latency_us() {
+        return 1e6 / host_ledc_frequency(host_ledc_channels[1].timer);
+    }
+    static const char* latch() {
+        return "next PWM period";
+    }
+    static void settle() {}
+};
+
+struct McpwmProbe {
+    static phase_t phase() {
+        const host_mcpwm_timer_regs_t* regs = &MCPWM0.timer[1];
+        uint32_t period = regs->period.period;
+        uint32_t loaded = regs->sync.timer_phase;
+        CHECK(loaded < period, "timer_phase %u outside period %u", loaded, period);
+        uint64_t lag = loaded == 0 ? 0 : period - loaded;
+        return phase_from_turns((uint32_t)((lag << 32) / period));
+    }
+    static bool running() {
+        return host_mcpwm[0].timer[0].running && host_mcpwm[0].timer[1].running;
+    }
+    static void frequency(double* ch1, double* ch2) {
+        *ch1 = (double)host_mcpwm[0].timer[0].resolution_hz / MCPWM0.timer[0].period.period;
+        *ch2 = (double)host_mcpwm[0].timer[1].resolution_hz / MCPWM0.timer[1].period.period;
+    }
+    static double latency_us() {
+        // Loaded on the next master TEZ sync
+        return 1e6 * MCPWM0.timer[0].period.period / host_mcpwm[0].timer[0].resolution_hz;
+    }
+    static const char* latch() {
+        return "next master sync";
+    }
+    static void settle() {}
+};
+
+struct CosineProbe {
+    static phase_t phase() {
+        uint32_t inv = GET_PERI_REG_BITS2(SENS_SAR_DAC_CTRL2_REG, SENS_DAC_INV2, SENS_DAC_INV2_S);
+        return inv == 3 ? phase_from_degrees(180) : PHASE_ZERO;
+    }
+    static bool running() {
+        uint32_t ctrl2 = READ_PERI_REG(SENS_SAR_DAC_CTRL2_REG);
+        return (READ_PERI_REG(SENS_SAR_DAC_CTRL1_REG) & SENS_SW_TONE_EN) &&
+               (ctrl2 & SENS_DAC_CW_EN1_M) && (ctrl2 & SENS_DAC_CW_EN2_M);
+    }
+    static void frequency(double* ch1, double* ch2) {
+        *ch1 = *ch2 = cw_frequency();
+    }
+    static double latency_us() {
+        return 0;
+    }
+    static const char* latch() {
+        return "register write";
+    }
+    static void settle() {}
+};
+
+struct DacIsrProbe {
+    static phase_t phase() {
+        // The ISR indexes the LUT with the top bits of accumulator + offset;
+        // the accumulator only moves when the ISR fires, and it is 0 here
+        scope_snapshot_t snap;
+        phase_shifted_dac_snapshot(&snap);
+        CHECK(snap.accumulator == 0, "accumulator moved without the ISR");
+        uint32_t index = phase_to_index<DAC_SYNTH_LUT_BITS>(phase_from_turns(snap.offset));
+        return phase_from_turns(index << (32 - DAC_SYNTH_LUT_BITS));
+    }
+    static bool running() {
+        return host_timer(0)->alarm_enabled && host_timer(0)->isr &&
+               (READ_PERI_REG(SENS_SAR_DAC_CTRL2_REG) & SENS_DAC_CW_EN1_M);
+    }
+    static void frequency(double* ch1, double* ch2) {
+        scope_snapshot_t snap;
+        phase_shifted_dac_snapshot(&snap);
+        *ch1 = cw_frequency();
+        *ch2 = (double)snap.increment * host_timer_rate(host_timer(0)) / 4294967296.0;
+    }
+    static double latency_us() {
+        return 1e6 / host_timer_rate(host_timer(0));
+    }
+    static const char* latch() {
+        return "next sample";
+    }
+    static void settle() {
+        // Frequency changes wait for the next carrier period boundary
+        phase_shifted_dac_stats_t before, now;
+        phase_shifted_dac_get_stats(&before);
+        for (int i = 0; i < 1000; i++) {
+            host_timer_fire(host_timer(0));
+            phase_shifted_dac_get_stats(&now);
+            if (now.reconfigurations != before.reconfigurations) return;
+        }
+        CHECK(false, "staged clock change never applied");
+    }
+};
+
+/**
+ * Init calibrates the ISR cost before the timer runs; that must not drive
+ * the pad or call the ISR-only timer and critical section functions
+ */
+static void check_dac_isr_calibration() {
+    uint32_t errors = host_isr_context_errors();
+    DacIsrBackend backend;
+    CHECK(backend.init(40000.0f, PHASE_ZERO), "init failed");
+    uint32_t sample_rate, isr_cycles;
+    backend.sample_clock(&sample_rate, &isr_cycles);
+    uint32_t code = GET_PERI_REG_BITS2(RTC_IO_PAD_DAC2_REG, RTC_IO_PDAC2_DAC, RTC_IO_PDAC2_DAC_S);
+    printf("calibration (dac_isr): %u cycles, %u S/s, DAC2 code %u\n", isr_cycles, sample_rate, code);
+    CHECK(code == 0, "calibration wrote DAC2 code %u before start()", code);
+    CHECK(host_isr_context_errors() == errors, "%u ISR-only calls outside an ISR",
+          host_isr_context_errors() - errors);
+    CHECK(isr_cycles > 0, "ISR cost not measured");
+}
+
+/**
+ * Fire the sample ISR once and check the DAC2 code against the synthesis
+ */
+static void check_dac_isr_sample() {
+    scope_snapshot_t snap;
+    phase_shifted_dac_snapshot(&snap);
+    uint8_t expected = dac_synth_sample(snap.lut, snap.accumulator, snap.offset);
+    CHECK(host_timer_fire(host_timer(0)), "sample timer not armed");
+    uint32_t code = GET_PERI_REG_BITS2(RTC_IO_PAD_DAC2_REG, RTC_IO_PDAC2_DAC, RTC_IO_PDAC2_DAC_S);
+    CHECK(code == expected, "DAC2 code %u, synthesis says %u", code, expected);
+    CHECK(READ_PERI_REG(RTC_IO_PAD_DAC2_REG) & RTC_IO_PDAC2_XPD_DAC, "DAC2 pad not powered");
+}
+
+/**
+ * Scope frame under the DAC ISR: channel 2 exact, channel 1 modelled at the CW frequency
+ */
+static void check_dac_isr_scope() {
+    DacIsrBackend backend;
+    scope_snapshot_t snap;
+    backend.scope_snapshot(&snap);
+    double ch1 = scope_ch1_frequency_mhz(&snap) / 1000.0;
+    double carrier = (double)snap.increment * snap.sample_rate / 4294967296.0;
+    printf("scope (dac_isr): ch1 model %.2f Hz, ch2 exact %.2f Hz\n", ch1, carrier);
+    CHECK(fabs(ch1 - cw_frequency()) < 0.01, "scope ch1 at %.2f Hz, CW generator at %.2f Hz",
+          ch1, cw_frequency());
+
+    uint8_t frame[2 * 256];
+    scope_render(&snap, frame, 256);
+    uint32_t accumulator = snap.accumulator;
+    uint32_t mismatches = 0;
+    for (int i = 0; i < 256; i++) {
+        if (frame[2 * i + 1] != dac_synth_sample(snap.lut, accumulator, snap.offset)) mismatches++;
+        accumulator += snap.increment;
+    }
+    CHECK(mismatches == 0, "scope ch2 differs from the ISR synthesis in %u samples", mismatches);
+}
+
+/**
+ * Sample rate changes while running: the rate reported back is the one the
+ * output switches to at the period boundary, not the one still running
+ */
+static void check_dac_isr_sample_rate() {
+    DacIsrBackend backend;
+    const uint32_t requests[] = {160000, 0};     // 31.25 timer counts; auto
+    for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+        uint32_t applied = 0, running, isr_cycles;
+        backend.sample_clock(&running, &isr_cycles);
+        CHECK(backend.set_sample_rate(requests[i], &applied), "set_sample_rate(%u) failed", requests[i]);
+        DacIsrProbe::settle();
+        uint32_t now;
+        backend.sample_clock(&now, &isr_cycles);
+        printf("sample rate (dac_isr): requested %u, was %u, applied %u, now %u\n",
+               requests[i], running, applied, now);
+        CHECK(applied == now, "set_sample_rate(%u) reported %u, output switched to %u", requests[i], applied, now);
+        CHECK(fabs(host_timer_rate(host_timer(0)) - now) < 1.0, "timer at %.1f Hz, sample rate %u",
+              host_timer_rate(host_timer(0)), now);
+    }
+}
+
+/**
+ * Run every check on one backend
+ * @param tolerance_steps Worst allowed phase error in backend steps
+ *                        (0.5 when the backend rounds, 1 when it truncates)
+ */
+template <typename Backend, typename Probe>
+static void bench(uint32_t sweep, uint32_t calls, double tolerance_steps) {
+    int failures_before = g_failures;
+    Backend backend;
+    printf("%s\n", Backend::name());
+
+    CHECK(backend.init(40000.0f, PHASE_ZERO), "init failed");
+    CHECK(!Probe::running(), "outputs running before start()");
+    backend.start();
+    CHECK(Probe::running(), "outputs idle after start()");
+
+    // Sweep the full turn
+    std::set<uint32_t> reached;
+    double worst = 0;
+    for (uint32_t i = 0; i < sweep; i++) {
+        phase_t requested = phase_from_turns((uint32_t)(((uint64_t)i << 32) / sweep));
+        backend.set_phase(requested);
+        phase_t achieved = Probe::phase();
+        reached.insert(achieved.turns);
+        double err = fabs(phase_error(achieved, requested));
+        if (err > worst) worst = err;
+    }
+    double step = 1.0 / Backend::phase_steps();
+    printf("  phase steps     %zu reached, PHASE_STEPS %u\n", reached.size(), Backend::phase_steps());
+    printf("  phase error     %.4f° worst (limit %.4f°)\n",
+           turns_to_degrees(worst), turns_to_degrees(step * tolerance_steps));
+    CHECK(reached.size() == Backend::phase_steps(), "reached %zu phase steps", reached.size());
+    CHECK(worst <= step * tolerance_steps + 1e-9, "phase error above limit");
+
+    // Cost per call, phases spread over the turn
+    double start = now_ns();
+    uint32_t turns = 0;
+    for (uint32_t i = 0; i < calls; i++) {
+        backend.set_phase(phase_from_turns(turns));
+        turns += 0x9E3779B9u;
+    }
+    double cost_ns = (now_ns() - start) / calls;
+    printf("  set_phase       %.1f ns/call\n", cost_ns);
+    printf("  update latency  <= %.1f µs (%s)\n", cost_ns / 1000 + Probe::latency_us(), Probe::latch());
+
+    // Frequency as programmed
+    printf("  frequency      ");
+    const float requested[] = {39000.0f, 40000.0f, 41000.0f};
+    for (size_t i = 0; i < sizeof(requested) / sizeof(requested[0]); i++) {
+        backend.set_frequency(requested[i]);
+        Probe::settle();
+        double ch1, ch2;
+        Probe::frequency(&ch1, &ch2);
+        if (fabs(ch1 - ch2) < 0.05) {
+            printf(" %.0f -> %.1f Hz", requested[i], ch1);
+        } else {
+            printf(" %.0f -> %.1f / %.1f Hz", requested[i], ch1, ch2);
+        }
+        // CW fstep is the coarsest: 8.5 MHz / 65536 = 130 Hz
+        CHECK(fabs(ch1 - requested[i]) < 130 && fabs(ch2 - requested[i]) < 130,
+              "%.0f Hz programmed as %.1f / %.1f Hz", requested[i], ch1, ch2);
+    }
+    printf("\n");
+
+    backend.stop();
+    CHECK(!Probe::running(), "outputs running after stop()");
+    printf("  %s\n\n", g_failures == failures_before ? "ok" : "FAILED");
+}
+
+int main(int argc, char** argv) {
+    uint32_t sweep = 65536;
+    uint32_t calls = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--sweep") && i + 1 < argc) {
+            sweep = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--calls") && i + 1 < argc) {
+            calls = strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--sweep N] [--calls N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    bench<LedcBackend, LedcProbe>(sweep, calls, 0.5);
+    host_reset_peripherals();
+    bench<McpwmBackend, McpwmProbe>(sweep, calls, 0.5);
+    host_reset_peripherals();
+    bench<CosineBackend, CosineProbe>(sweep, calls, 0.5);
+    host_reset_peripherals();
+
+    // Calibration first, while the DAC pad is still at its power-on code;
+    // started again for the sample check: the ISR only runs while started
+    check_dac_isr_calibration();
+    bench<DacIsrBackend, DacIsrProbe>(sweep, calls, 1.0);
+    phase_shifted_dac_start();
+    check_dac_isr_sample();
+    check_dac_isr_scope();
+    check_dac_isr_sample_rate();
+    phase_shifted_dac_stop();
+    CHECK(host_isr_context_errors() == 0, "%u ISR-only calls outside an ISR", host_isr_context_errors());
+
+    printf("%s\n", g_failures ? "FAILED" : "all backends ok");
+    return g_failures ? 1 : 0;
+}
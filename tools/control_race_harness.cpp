@@ -0,0 +1,342 @@
+/**
+ * Control-plane race harness
+ *
+ * Builds src/levitation_control.cpp with the dac_isr backend unchanged
+ * against the tools/host stand-ins (FreeRTOS mutex and critical sections,
+ * the sample timer, DAC and CW-generator registers) and drives it the way
+ * the firmware does, but all at once:
+ *   - producer threads issue control calls as HTTP, serial, UDP and the
+ *     rig sync task would (set_phase, move, trim, set_frequency,
+ *     set_sample_rate), throttled to a target total command rate
+ *   - a reader thread polls what /state, /stats and the scope stream read
+ *   - a timer thread fires timer_isr() at the programmed sample rate
+ * For each target rate it reports the command rate achieved, how many
+ * calls found the control mutex taken, the worst call latency, ISR
+ * samples against the expected count, and the ISR deadline misses the
+ * firmware itself counts. The highest rate held within 5% while the ISR
+ * also got at least 95% of its samples is reported as the maximum
+ * sustained command rate. A moves-only stage then checks that
+ * concurrent levitation_move() calls lose no steps, and after every stage
+ * the cached phase/frequency must agree with what the sample ISR uses.
+ *
+ * Build it with -fsanitize=thread to have ThreadSanitizer report every
+ * data race on top; it then exits with status 66 if it found any. The
+ * words the firmware shares lock-free on purpose are listed, with the
+ * reason, in tools/control_race_harness.supp:
+ *   TSAN_OPTIONS=suppressions=tools/control_race_harness.supp ./control_race_harness
+ * Deadline misses measure this host's scheduling of the timer thread as
+ * much as the firmware, so compare them between runs, not with hardware.
+ * Exits non-zero if an invariant check fails.
+ *
+ * Build (host):
+ *   g++ -O1 -g -std=c++11 -pthread -fsanitize=thread -DLEVITATION_BACKEND_DAC_ISR \
+ *       -I tools/host -I src -o control_race_harness tools/control_race_harness.cpp \
+ *       src/levitation_control.cpp src/dac_isr_backend.cpp src/cw_generator.cpp \
+ *       src/phase_shifted_dac.cpp tools/host/esp_host.cpp
+ *   (drop -fsanitize=thread and use -O2 for the rate figures alone)
+ *
+ * Usage:
+ *   control_race_harness [--producers N] [--seconds S]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "esp_host.h"
+#include "levitation_control.h"
+#include "phase_shifted_dac.h"
+
+#ifndef LEVITATION_BACKEND_DAC_ISR
+#error "build with -DLEVITATION_BACKEND_DAC_ISR: the harness needs the sample ISR"
+#endif
+
+typedef std::chrono::steady_clock clock_type;
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do {                       \
+    if (!(cond)) {                                  \
+        printf("  FAIL: " __VA_ARGS__);             \
+        printf("\n");                               \
+        g_failures++;                               \
+    }                                               \
+} while (0)
+
+// Phases and sync offsets producers use: all multiples of 90°, so any
+// consistent user + sync offset is one too
+static const phase_t QUADRANTS[] = {
+    phase_from_degrees(0.0), phase_from_degrees(90.0),
+    phase_from_degrees(180.0), phase_from_degrees(270.0),
+};
+static const float FREQUENCIES[] = {39500.0f, 40000.0f, 40500.0f};
+static const uint32_t SAMPLE_RATES[] = {200000, 156250, 125000, PHASE_SHIFTED_DAC_AUTO_RATE};
+#define TRIM_PPB_LIMIT          100
+
+static std::atomic<bool> g_stop_timer(false);
+static std::atomic<bool> g_stop_stage(false);
+static std::atomic<uint64_t> g_timer_fires(0);
+static std::atomic<uint64_t> g_timer_resyncs(0);
+
+/**
+ * Fire the sample ISR at the rate the timer is programmed for
+ * If the thread falls more than 4 periods behind (preempted), it counts a
+ * resync and restarts the schedule instead of firing a burst
+ */
+static void timer_thread() {
+    hw_timer_t* timer = host_timer(0);
+    clock_type::time_point next = clock_type::now();
+    while (!g_stop_timer.load()) {
+        double rate = host_timer_rate(timer);
+        if (rate <= 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            next = clock_type::now();
+            continue;
+        }
+        std::chrono::nanoseconds period((int64_t)(1e9 / rate));
+        next += period;
+        clock_type::time_point now = clock_type::now();
+        if (now > next + 4 * period) {
+            g_timer_resyncs++;
+            next = now;
+        }
+        while (clock_type::now() < next) {
+            // Spin: sleep granularity is far coarser than a sample period
+        }
+        if (host_timer_fire(timer)) g_timer_fires++;
+    }
+}
+
+/**
+ * Small per-thread generator, so producers never share state
+ */
+static uint32_t next_random(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+typedef struct {
+    uint64_t calls;
+    int64_t worst_ns;
+    int64_t net_moves;          // Moves stage: sum of directions
+} producer_result_t;
+
+/**
+ * Mixed control traffic at rate_per_thread calls/s (0 = unthrottled)
+ */
+static void producer_thread(int id, double rate_per_thread, bool moves_only, producer_result_t* result) {
+    uint32_t random = 0x9e3779b9u * (id + 1);
+    clock_type::time_point next = clock_type::now();
+    std::chrono::nanoseconds interval(rate_per_thread > 0 ? (int64_t)(1e9 / rate_per_thread) : 0);
+    memset(result, 0, sizeof(*result));
+
+    while (!g_stop_stage.load()) {
+        if (rate_per_thread > 0) {
+            next += interval;
+            clock_type::time_point now = clock_type::now();
+            if (next > now) {
+                std::this_thread::sleep_until(next);
+            } else if (now - next > std::chrono::milliseconds(10)) {
+                next = now;     // Fell behind: don't burst to catch up
+            }
+        }
+        uint32_t r = next_random(&random);
+        clock_type::time_point start = clock_type::now();
+        if (moves_only) {
+            int direction = (r & 1) ? 1 : -1;
+            levitation_move(direction, PHASE_ONE_DEGREE);
+            result->net_moves += direction;
+        } else {
+            uint32_t op = r % 1024;
+            if (op < 800) {
+                levitation_set_phase(QUADRANTS[(r >> 10) % 4]);
+            } else if (op < 960) {
+                levitation_move((r >> 10) & 1 ? 1 : -1, phase_from_degrees(90.0));
+            } else if (op < 1020) {
+                int32_t ppb = (int32_t)((r >> 10) % (2 * TRIM_PPB_LIMIT + 1)) - TRIM_PPB_LIMIT;
+                levitation_trim_carrier(ppb, QUADRANTS[(r >> 12) % 4]);
+            } else if (op < 1023) {
+                levitation_set_frequency(FREQUENCIES[(r >> 10) % 3]);
+            } else {
+                uint32_t applied;
+                levitation_set_sample_rate(SAMPLE_RATES[(r >> 10) % 4], &applied);
+            }
+        }
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count();
+        if (ns > result->worst_ns) result->worst_ns = ns;
+        result->calls++;
+    }
+}
+
+/**
+ * What GET /state, GET /stats and the scope stream read, lock-free
+ */
+static void reader_thread(uint64_t* reads) {
+    *reads = 0;
+    while (!g_stop_stage.load()) {
+        volatile float frequency = levitation_get_frequency();
+        volatile phase_t phase = levitation_get_phase();
+        levitation_stats_t stats;
+        levitation_get_stats(&stats);
+        scope_snapshot_t snapshot;
+        levitation_get_scope_snapshot(&snapshot);
+        phase_t carrier;
+        int64_t time_us;
+        levitation_read_carrier(&carrier, &time_us);
+        (void)frequency;
+        (void)phase;
+        (*reads)++;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+typedef struct {
+    double target;
+    double achieved;
+    double contended_pct;
+    int64_t worst_ns;
+    uint64_t isr_samples;
+    double isr_expected;
+    uint32_t misses;
+    uint64_t resyncs;
+} stage_result_t;
+
+static stage_result_t run_stage(int producers, double target_rate, double seconds, bool moves_only,
+                                int64_t* net_moves) {
+    levitation_stats_t before;
+    levitation_get_stats(&before);
+    uint64_t resyncs = g_timer_resyncs.load();
+    double rate_before = (double)levitation_get_sample_rate();
+
+    std::vector<producer_result_t> results(producers);
+    std::vector<std::thread> threads;
+    uint64_t reads = 0;
+    g_stop_stage = false;
+    clock_type::time_point start = clock_type::now();
+    for (int i = 0; i < producers; i++) {
+        threads.push_back(std::thread(producer_thread, i, target_rate / producers, moves_only, &results[i]));
+    }
+    std::thread reader(reader_thread, &reads);
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(seconds * 1e6)));
+    g_stop_stage = true;
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+    reader.join();
+    double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    levitation_stats_t after;
+    levitation_get_stats(&after);
+    stage_result_t stage;
+    memset(&stage, 0, sizeof(stage));
+    uint64_t calls = 0;
+    *net_moves = 0;
+    for (int i = 0; i < producers; i++) {
+        calls += results[i].calls;
+        *net_moves += results[i].net_moves;
+        if (results[i].worst_ns > stage.worst_ns) stage.worst_ns = results[i].worst_ns;
+    }
+    stage.target = target_rate;
+    stage.achieved = calls / elapsed;
+    uint32_t commands = after.commands - before.commands;
+    stage.contended_pct = commands ? 100.0 * (after.contended - before.contended) / commands : 0;
+    stage.isr_samples = after.isr_samples - before.isr_samples;
+    // Approximate when the rate changed mid-stage
+    stage.isr_expected = elapsed * (rate_before + levitation_get_sample_rate()) / 2;
+    stage.misses = after.isr_deadline_misses - before.isr_deadline_misses;
+    stage.resyncs = g_timer_resyncs.load() - resyncs;
+    return stage;
+}
+
+/**
+ * Cached control state against what the ISR is using
+ */
+static void check_consistency(const char* stage) {
+    scope_snapshot_t snapshot;
+    phase_shifted_dac_snapshot(&snapshot);
+    // offset = user shift + sync offset; both come from QUADRANTS in the
+    // mixed stage and the sync offset stays a multiple of 90° in moves
+    uint32_t sync = snapshot.offset - levitation_get_phase().turns;
+    CHECK((sync & 0x3fffffffu) == 0, "%s: ISR offset %.3f° disagrees with cached phase %.3f°", stage,
+          phase_to_degrees(phase_from_turns(snapshot.offset)), phase_to_degrees(levitation_get_phase()));
+    CHECK(levitation_get_frequency() == phase_shifted_dac_get_frequency(),
+          "%s: cached frequency %.0f Hz, sample ISR %.0f Hz", stage,
+          levitation_get_frequency(), phase_shifted_dac_get_frequency());
+    // Any trim is within ±TRIM_PPB_LIMIT ppb of the untrimmed increment
+    uint32_t base = phase_increment(phase_shifted_dac_get_frequency(), phase_shifted_dac_get_sample_rate());
+    int64_t delta = (int64_t)snapshot.increment - base;
+    CHECK(llabs(delta) <= (int64_t)base * TRIM_PPB_LIMIT / 1000000000LL + 1,
+          "%s: ISR increment %u, expected %u within the trim range", stage,
+          (unsigned)snapshot.increment, (unsigned)base);
+}
+
+int main(int argc, char** argv) {
+    int producers = 4;
+    double seconds = 1.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--producers") && i + 1 < argc) {
+            producers = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--producers N] [--seconds S]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (producers < 1) producers = 1;
+
+    if (!levitation_init(40000.0f, PHASE_ZERO)) {
+        printf("levitation_init failed\n");
+        return 1;
+    }
+    levitation_start();
+    std::thread timer(timer_thread);
+
+    printf("%s backend, %u S/s, %d producers + 1 reader + timer ISR, %u hardware threads\n",
+           levitation_get_backend_name(), (unsigned)levitation_get_sample_rate(), producers,
+           std::thread::hardware_concurrency());
+    printf("%10s %10s %10s %10s %12s %12s %8s %8s\n", "target/s", "achieved/s", "contended",
+           "worst us", "isr samples", "expected", "misses", "resyncs");
+
+    static const double TARGETS[] = {1000, 10000, 100000, 0};
+    double max_sustained = 0;
+    for (size_t t = 0; t < sizeof(TARGETS) / sizeof(TARGETS[0]); t++) {
+        int64_t net_moves;
+        stage_result_t stage = run_stage(producers, TARGETS[t], seconds, false, &net_moves);
+        char target[16];
+        if (TARGETS[t] > 0) {
+            snprintf(target, sizeof(target), "%.0f", TARGETS[t]);
+        } else {
+            snprintf(target, sizeof(target), "max");
+        }
+        printf("%10s %10.0f %9.1f%% %10.1f %12llu %12.0f %8u %8llu\n", target, stage.achieved,
+               stage.contended_pct, stage.worst_ns / 1000.0, (unsigned long long)stage.isr_samples,
+               stage.isr_expected, (unsigned)stage.misses, (unsigned long long)stage.resyncs);
+        // Sustained: the producers got their rate and the ISR its samples
+        bool isr_kept_up = stage.isr_samples >= 0.95 * stage.isr_expected;
+        if ((TARGETS[t] == 0 || stage.achieved >= 0.95 * TARGETS[t]) && isr_kept_up) {
+            if (stage.achieved > max_sustained) max_sustained = stage.achieved;
+        }
+        check_consistency(target);
+    }
+    printf("max sustained command rate: %.0f/s\n", max_sustained);
+
+    // Lost updates: every move is a read-modify-write of the phase
+    levitation_trim_carrier(0, PHASE_ZERO);
+    levitation_set_phase(PHASE_ZERO);
+    int64_t net_moves;
+    stage_result_t stage = run_stage(producers, 0, seconds, true, &net_moves);
+    phase_t expected = phase_from_turns((uint32_t)(net_moves * (int64_t)PHASE_ONE_DEGREE.turns));
+    printf("moves: %.0f/s, net %lld steps, phase %.3f° (expected %.3f°)\n", stage.achieved,
+           (long long)net_moves, phase_to_degrees(levitation_get_phase()), phase_to_degrees(expected));
+    CHECK(phase_equal(levitation_get_phase(), expected), "moves lost steps");
+    check_consistency("moves");
+
+    g_stop_timer = true;
+    timer.join();
+    levitation_stop();
+
+    printf("%s\n", g_failures ? "FAILED" : "all invariants held");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,347 @@
+/**
+ * DAC predistortion table generator
+ *
+ * Builds the 8-bit sine LUT the DAC ISR plays (src/dac_predistort_table.h,
+ * used with -DDAC_PREDISTORT) so that the *voltage* the DAC actually puts
+ * out is as close to a pure sine as 8 bits allow, and reports THD and the
+ * effective fundamental amplitude of the plain generate_sine_lut() table
+ * against the corrected one.
+ *
+ * Two stages, both offline so the ISR still does one table read per sample:
+ *   1. DAC transfer curve: each target voltage is mapped to the code whose
+ *      measured output is nearest (inverts INL/DNL and gain/offset error).
+ *   2. Harmonic cancellation: the output through the curve is analysed
+ *      (DFT, harmonics 2..N) and the residual harmonics are subtracted from
+ *      the target; repeated for --iterations, keeping the best table.
+ *      Only harmonics with a non-zero weight are cancelled. Weights are the
+ *      transducer's response at that harmonic relative to the fundamental,
+ *      so headroom is not spent on harmonics it does not radiate, and the
+ *      weighted THD estimates the distortion in the acoustic output.
+ *   3. Code refinement: single codes are nudged by ±1 LSB while that
+ *      lowers the weighted THD without shrinking the fundamental, for
+ *      --refine passes; this is what helps on a DAC that is already linear.
+ *
+ * Transfer curve: CSV "code,volts" measured with a DMM or scope (any
+ * subset of codes, at least two; linear interpolation in between). Without
+ * --curve the DAC is ideal, VDD * code / 256. --model-inl adds a bow-shaped
+ * INL of the given peak in LSB, to try the pipeline before measuring.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -I src -o dac_predistort_gen tools/dac_predistort_gen.cpp
+ *
+ * Usage:
+ *   dac_predistort_gen [--curve FILE] [--vdd V] [--model-inl LSB]
+ *                      [--harmonics N] [--weight K=W]... [--iterations N]
+ *                      [--refine PASSES] [--out FILE]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "dac_synth.h"
+
+#define DAC_CODES           256
+#define MAX_HARMONIC        (DAC_SYNTH_LUT_SIZE / 2 - 1)
+
+typedef struct {
+    const char* curve_path;
+    double vdd;
+    double model_inl_lsb;
+    int harmonics;                      // Highest harmonic analysed
+    int iterations;
+    int refine_passes;
+    double weights[MAX_HARMONIC + 1];   // Per harmonic, [1] is the fundamental
+} predistort_config_t;
+
+typedef struct {
+    double fundamental_v;               // Peak amplitude of the fundamental
+    double thd;                         // sqrt(sum H_k^2) / H_1, k = 2..N
+    double weighted_thd;                // Same with H_k scaled by the weights
+    double re[MAX_HARMONIC + 1];        // Cosine/sine coefficients per harmonic
+    double im[MAX_HARMONIC + 1];
+} spectrum_t;
+
+static bool load_curve(const char* path, std::vector<double>* volts) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    std::vector<int> codes;
+    std::vector<double> values;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        int code;
+        double v;
+        if (line[0] == '#' || sscanf(line, "%d,%lf", &code, &v) != 2) continue;
+        if (code < 0 || code >= DAC_CODES) continue;
+        codes.push_back(code);
+        values.push_back(v);
+    }
+    fclose(f);
+    if (codes.size() < 2) {
+        fprintf(stderr, "%s: need at least two code,volts points\n", path);
+        return false;
+    }
+
+    // Sort by code, then interpolate (and extrapolate the end segments)
+    for (size_t i = 1; i < codes.size(); i++) {
+        for (size_t j = i; j > 0 && codes[j] < codes[j - 1]; j--) {
+            std::swap(codes[j], codes[j - 1]);
+            std::swap(values[j], values[j - 1]);
+        }
+    }
+    size_t seg = 0;
+    for (int c = 0; c < DAC_CODES; c++) {
+        while (seg + 2 < codes.size() && c > codes[seg + 1]) seg++;
+        int c0 = codes[seg], c1 = codes[seg + 1];
+        double t = c1 != c0 ? (double)(c - c0) / (c1 - c0) : 0.0;
+        (*volts)[c] = values[seg] + t * (values[seg + 1] - values[seg]);
+    }
+    return true;
+}
+
+static bool build_curve(const predistort_config_t* cfg, std::vector<double>* volts) {
+    volts->assign(DAC_CODES, 0.0);
+    if (cfg->curve_path) {
+        if (!load_curve(cfg->curve_path, volts)) return false;
+    } else {
+        for (int c = 0; c < DAC_CODES; c++) {
+            (*volts)[c] = cfg->vdd * c / 256.0;
+        }
+    }
+    double lsb = ((*volts)[DAC_CODES - 1] - (*volts)[0]) / (DAC_CODES - 1);
+    for (int c = 0; c < DAC_CODES; c++) {
+        (*volts)[c] += cfg->model_inl_lsb * lsb * sin(M_PI * c / (DAC_CODES - 1));
+    }
+    return true;
+}
+
+/**
+ * Spectrum of the voltage the DAC emits when it plays lut once per period
+ */
+static void analyze(const uint8_t* lut, const std::vector<double>& volts,
+                    const predistort_config_t* cfg, spectrum_t* s) {
+    const int n = DAC_SYNTH_LUT_SIZE;
+    double sum = 0.0, weighted = 0.0;
+    for (int k = 1; k <= cfg->harmonics; k++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < n; i++) {
+            double angle = 2.0 * M_PI * k * i / n;
+            re += volts[lut[i]] * cos(angle);
+            im += volts[lut[i]] * sin(angle);
+        }
+        s->re[k] = 2.0 * re / n;
+        s->im[k] = 2.0 * im / n;
+        double power = s->re[k] * s->re[k] + s->im[k] * s->im[k];
+        if (k == 1) {
+            s->fundamental_v = sqrt(power);
+        } else {
+            sum += power;
+            weighted += power * cfg->weights[k] * cfg->weights[k];
+        }
+    }
+    s->thd = sqrt(sum) / s->fundamental_v;
+    s->weighted_thd = sqrt(weighted) / s->fundamental_v;
+}
+
+static uint8_t nearest_code(const std::vector<double>& volts, double target) {
+    // Full scan: a measured curve need not be monotonic
+    int best = 0;
+    for (int c = 1; c < DAC_CODES; c++) {
+        if (fabs(volts[c] - target) < fabs(volts[best] - target)) best = c;
+    }
+    return (uint8_t)best;
+}
+
+/**
+ * Predistorted LUT with the lowest weighted THD over the iterations, or
+ * the plain table if no iteration beats it
+ */
+static void build_lut(const std::vector<double>& volts, const predistort_config_t* cfg,
+                      const uint8_t* plain, const spectrum_t* plain_spectrum,
+                      uint8_t* out, spectrum_t* out_spectrum) {
+    const int n = DAC_SYNTH_LUT_SIZE;
+    double vmin = volts[0], vmax = volts[0];
+    for (int c = 1; c < DAC_CODES; c++) {
+        if (volts[c] < vmin) vmin = volts[c];
+        if (volts[c] > vmax) vmax = volts[c];
+    }
+    // Same swing as the plain table: rail to rail
+    double mid = 0.5 * (vmax + vmin);
+    double half = 0.5 * (vmax - vmin);
+
+    std::vector<double> correction(n, 0.0);
+    uint8_t lut[DAC_SYNTH_LUT_SIZE];
+    spectrum_t s;
+    // Never worse than the plain table
+    double best = plain_spectrum->weighted_thd;
+    memcpy(out, plain, n);
+    *out_spectrum = *plain_spectrum;
+
+    for (int it = 0; it <= cfg->iterations; it++) {
+        for (int i = 0; i < n; i++) {
+            double target = mid + half * sin(2.0 * M_PI * i / n) + correction[i];
+            lut[i] = nearest_code(volts, target);
+        }
+        analyze(lut, volts, cfg, &s);
+        double score = s.weighted_thd;
+        if (score < best) {
+            best = score;
+            memcpy(out, lut, n);
+            *out_spectrum = s;
+        }
+
+        for (int k = 2; k <= cfg->harmonics; k++) {
+            if (cfg->weights[k] <= 0.0) continue;
+            for (int i = 0; i < n; i++) {
+                double angle = 2.0 * M_PI * k * i / n;
+                correction[i] -= s.re[k] * cos(angle) + s.im[k] * sin(angle);
+            }
+        }
+    }
+}
+
+/**
+ * Greedy ±1 code search on the best table: quantization error that the
+ * target cannot express moves out of the weighted harmonics
+ */
+static void refine_lut(const std::vector<double>& volts, const predistort_config_t* cfg,
+                       uint8_t* lut, spectrum_t* s) {
+    for (int pass = 0; pass < cfg->refine_passes; pass++) {
+        bool improved = false;
+        for (int i = 0; i < DAC_SYNTH_LUT_SIZE; i++) {
+            for (int step = -1; step <= 1; step += 2) {
+                int code = lut[i] + step;
+                if (code < 0 || code >= DAC_CODES) continue;
+                uint8_t previous = lut[i];
+                lut[i] = (uint8_t)code;
+                spectrum_t trial;
+                analyze(lut, volts, cfg, &trial);
+                // Keep the fundamental: a quieter but smaller sine is no gain
+                if (trial.weighted_thd < s->weighted_thd &&
+                    trial.fundamental_v >= s->fundamental_v * 0.999) {
+                    *s = trial;
+                    improved = true;
+                } else {
+                    lut[i] = previous;
+                }
+            }
+        }
+        if (!improved) break;
+    }
+}
+
+static void print_spectrum(const char* name, const spectrum_t* s, const predistort_config_t* cfg) {
+    printf("%-14s fundamental %.4f V peak   THD %.3f%%   weighted THD %.3f%%\n",
+           name, s->fundamental_v, 100.0 * s->thd, 100.0 * s->weighted_thd);
+    printf("%-14s", "");
+    for (int k = 2; k <= cfg->harmonics && k <= 7; k++) {
+        double h = sqrt(s->re[k] * s->re[k] + s->im[k] * s->im[k]);
+        printf(" H%d %.1f dBc ", k, 20.0 * log10(h / s->fundamental_v + 1e-12));
+    }
+    printf("\n");
+}
+
+static void write_header(FILE* out, int argc, char** argv, const uint8_t* lut,
+                         const spectrum_t* before, const spectrum_t* after) {
+    fprintf(out, "#ifndef DAC_PREDISTORT_TABLE_H\n#define DAC_PREDISTORT_TABLE_H\n\n");
+    fprintf(out, "// Generated by tools/dac_predistort_gen.cpp, do not edit\n//");
+    bool defaults = true;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--out")) {
+            i++;
+            continue;
+        }
+        fprintf(out, " %s", argv[i]);
+        defaults = false;
+    }
+    if (defaults) fprintf(out, " (defaults: ideal DAC, all harmonic weights 1)");
+    fprintf(out, "\n// THD %.3f%% -> %.3f%%, weighted THD %.3f%% -> %.3f%%, fundamental %.4f V -> %.4f V\n\n",
+            100.0 * before->thd, 100.0 * after->thd,
+            100.0 * before->weighted_thd, 100.0 * after->weighted_thd,
+            before->fundamental_v, after->fundamental_v);
+    fprintf(out, "#include <stdint.h>\n\n");
+    fprintf(out, "#define DAC_PREDISTORT_LUT_SIZE %d\n\n", DAC_SYNTH_LUT_SIZE);
+    fprintf(out, "// DAC codes for one carrier period, 0..2π\n");
+    fprintf(out, "static const uint8_t DAC_PREDISTORT_LUT[DAC_PREDISTORT_LUT_SIZE] = {");
+    for (int i = 0; i < DAC_SYNTH_LUT_SIZE; i++) {
+        fprintf(out, "%s%3u%s", (i % 16) ? " " : "\n    ", lut[i],
+                i + 1 < DAC_SYNTH_LUT_SIZE ? "," : "");
+    }
+    fprintf(out, "\n};\n\n#endif // DAC_PREDISTORT_TABLE_H\n");
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: dac_predistort_gen [--curve FILE] [--vdd V] [--model-inl LSB]\n"
+            "                          [--harmonics N] [--weight K=W]... [--iterations N]\n"
+            "                          [--refine PASSES] [--out FILE]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    predistort_config_t cfg;
+    cfg.curve_path = nullptr;
+    cfg.vdd = 3.3;
+    cfg.model_inl_lsb = 0.0;
+    cfg.harmonics = 15;
+    cfg.iterations = 30;
+    cfg.refine_passes = 8;
+    for (int k = 0; k <= MAX_HARMONIC; k++) {
+        cfg.weights[k] = 1.0;
+    }
+    const char* out_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage();
+        if (!strcmp(argv[i], "--curve")) cfg.curve_path = argv[++i];
+        else if (!strcmp(argv[i], "--vdd")) cfg.vdd = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--model-inl")) cfg.model_inl_lsb = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--harmonics")) cfg.harmonics = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations")) cfg.iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--refine")) cfg.refine_passes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out")) out_path = argv[++i];
+        else if (!strcmp(argv[i], "--weight")) {
+            int k;
+            double w;
+            if (sscanf(argv[++i], "%d=%lf", &k, &w) != 2 || k < 2 || k > MAX_HARMONIC || w < 0.0) usage();
+            cfg.weights[k] = w;
+        }
+        else usage();
+    }
+    if (cfg.harmonics < 2 || cfg.harmonics > MAX_HARMONIC || cfg.iterations < 0 || cfg.refine_passes < 0) usage();
+
+    std::vector<double> volts;
+    if (!build_curve(&cfg, &volts)) return 1;
+
+    uint8_t plain[DAC_SYNTH_LUT_SIZE];
+    generate_sine_lut(plain, DAC_SYNTH_LUT_SIZE);
+    spectrum_t before;
+    analyze(plain, volts, &cfg, &before);
+
+    uint8_t corrected[DAC_SYNTH_LUT_SIZE];
+    spectrum_t after;
+    build_lut(volts, &cfg, plain, &before, corrected, &after);
+    refine_lut(volts, &cfg, corrected, &after);
+
+    print_spectrum("plain", &before, &cfg);
+    print_spectrum("predistorted", &after, &cfg);
+    printf("fundamental %+.2f dB, THD %.3f%% -> %.3f%%\n",
+           20.0 * log10(after.fundamental_v / before.fundamental_v),
+           100.0 * before.thd, 100.0 * after.thd);
+
+    if (out_path) {
+        FILE* out = fopen(out_path, "w");
+        if (!out) {
+            perror(out_path);
+            return 1;
+        }
+        write_header(out, argc, argv, corrected, &before, &after);
+        fclose(out);
+        printf("wrote %s\n", out_path);
+    }
+    return 0;
+}
@@ -0,0 +1,265 @@
+"""
+IRAM / DRAM / flash footprint report from the linker map
+
+Runs after every link as a PlatformIO post script (see extra_scripts in
+platformio.ini): asks the linker for a map file, attributes every input
+section to a module and prints a per-module table. The build fails when a
+budget is exceeded. Budgets are project options, so an env can override them:
+
+    custom_footprint_iram_pct   Max share of the IRAM segment (iram0_0_seg)
+    custom_footprint_dram_pct   Max share of the static DRAM segment (dram0_0_seg);
+                                whatever is left becomes heap
+    custom_footprint_flash      Max bytes stored in flash (code, rodata,
+                                initialized data) - the app partition size
+    custom_footprint_app_iram   Max IRAM used by our own src/ modules
+    custom_footprint_app_dram   Max static DRAM used by our own src/ modules
+
+Modules are: src/<file> for our sources, arduino/<file> for the Arduino
+core (String, HardwareSerial, ...), and the archive name for libraries
+(libWebServer.a, libWiFi.a, libSPIFFS.a, ...) and ESP-IDF components.
+
+Standalone:
+    python3 tools/footprint.py .pio/build/esp32dev/firmware.footprint.map [--top N]
+"""
+import os
+import re
+import sys
+
+REGIONS = ("iram", "dram", "flash")
+
+# Output sections -> region; .rtc*, .flash.rodata_noload etc. are not counted
+SECTION_REGIONS = (
+    (".iram0.", "iram"),
+    (".dram0.", "dram"),
+    (".noinit", "dram"),
+    (".flash.text", "flash"),
+    (".flash.rodata", "flash"),
+    (".flash.appdesc", "flash"),
+)
+NOT_COUNTED = (".flash.rodata_noload", ".dram0.heap_start", ".iram0.text_end")
+
+# Initialized data is copied out of flash at boot, so it costs flash too
+FLASH_COPY_SECTIONS = (".iram0.vectors", ".iram0.text", ".iram0.data", ".dram0.data")
+
+SEGMENTS = {"iram": "iram0_0_seg", "dram": "dram0_0_seg"}
+
+INPUT_SAME_LINE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+INPUT_NAME_ONLY = re.compile(r"^ (\S+)$")
+INPUT_CONTINUED = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+OUTPUT_SECTION = re.compile(r"^(\.\S+)")
+MEMORY_LINE = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+ARCHIVE_MEMBER = re.compile(r"^(.*?)([^/\\]+\.a)\((.+)\)$")
+
+
+def region_of(section):
+    if section.startswith(NOT_COUNTED):
+        return None
+    for prefix, region in SECTION_REGIONS:
+        if section.startswith(prefix):
+            return region
+    return None
+
+
+def module_of(path):
+    path = path.strip()
+    match = ARCHIVE_MEMBER.match(path)
+    if match:
+        archive, member = match.group(2), match.group(3)
+        if archive == "libFrameworkArduino.a":
+            return "arduino/" + re.sub(r"\.o$", "", member)
+        return archive
+    name = re.sub(r"\.o$", "", os.path.basename(path))
+    parts = path.replace("\\", "/").split("/")
+    if "src" in parts:
+        return "src/" + name
+    return name
+
+
+def parse_map(path):
+    """
+    Returns ({module: {region: bytes}}, {region: bytes flash copy},
+             {segment: length})
+    """
+    modules = {}
+    flash_copy = 0
+    segments = {}
+    in_memory_config = False
+    in_map = False
+    output_section = None
+    pending_input = None
+
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Memory Configuration"):
+                in_memory_config = True
+                continue
+            if line.startswith("Linker script and memory map"):
+                in_memory_config = False
+                in_map = True
+                continue
+            if in_memory_config:
+                match = MEMORY_LINE.match(line)
+                if match:
+                    segments[match.group(1)] = int(match.group(3), 16)
+                continue
+            if not in_map:
+                continue
+
+            match = OUTPUT_SECTION.match(line)
+            if match:
+                output_section = match.group(1)
+                pending_input = None
+                continue
+
+            size = None
+            source = None
+            match = INPUT_SAME_LINE.match(line)
+            if match:
+                size, source = int(match.group(3), 16), match.group(4)
+            elif pending_input:
+                match = INPUT_CONTINUED.match(line)
+                if match:
+                    size, source = int(match.group(2), 16), match.group(3)
+                pending_input = None
+            else:
+                match = INPUT_NAME_ONLY.match(line)
+                if match and not line.startswith(" *"):
+                    pending_input = match.group(1)
+                continue
+
+            if size is None or not size or output_section is None:
+                continue
+            region = region_of(output_section)
+            if region is None:
+                continue
+            entry = modules.setdefault(module_of(source), dict.fromkeys(REGIONS, 0))
+            entry[region] += size
+            if output_section.startswith(FLASH_COPY_SECTIONS):
+                flash_copy += size
+
+    return modules, flash_copy, segments
+
+
+def totals(modules, predicate=lambda name: True):
+    sums = dict.fromkeys(REGIONS, 0)
+    for name, sizes in modules.items():
+        if predicate(name):
+            for region in REGIONS:
+                sums[region] += sizes[region]
+    return sums
+
+
+def print_report(modules, flash_copy, top):
+    ranked = sorted(modules.items(), key=lambda item: -sum(item[1].values()))
+    print("%-36s %8s %8s %9s" % ("module", "iram", "dram", "flash"))
+    for name, sizes in ranked[:top]:
+        print("%-36s %8d %8d %9d" % (name, sizes["iram"], sizes["dram"], sizes["flash"]))
+    if len(ranked) > top:
+        rest = totals(dict(ranked[top:]))
+        print("%-36s %8d %8d %9d" % ("(%d more)" % (len(ranked) - top),
+                                      rest["iram"], rest["dram"], rest["flash"]))
+    app = totals(modules, lambda name: name.startswith("src/"))
+    total = totals(modules)
+    print("%-36s %8d %8d %9d" % ("= src/ (our code)", app["iram"], app["dram"], app["flash"]))
+    print("%-36s %8d %8d %9d" % ("= total", total["iram"], total["dram"],
+                                  total["flash"] + flash_copy))
+
+
+def check_budgets(modules, flash_copy, segments, budgets):
+    """
+    budgets: dict of option name (without custom_footprint_) -> number or None
+    Returns a list of violation messages
+    """
+    total = totals(modules)
+    app = totals(modules, lambda name: name.startswith("src/"))
+    used = {
+        "iram": total["iram"],
+        "dram": total["dram"],
+        "flash": total["flash"] + flash_copy,
+    }
+    failures = []
+
+    for region in ("iram", "dram"):
+        pct = budgets.get(region + "_pct")
+        segment = segments.get(SEGMENTS[region])
+        if pct is not None and segment:
+            limit = int(segment * pct / 100)
+            print("%s: %d of %d bytes (%.1f%%, budget %d%%)" % (
+                region.upper(), used[region], segment, 100.0 * used[region] / segment, pct))
+            if used[region] > limit:
+                failures.append("%s %d bytes exceeds %d%% of %s (%d bytes)" % (
+                    region.upper(), used[region], pct, SEGMENTS[region], limit))
+
+    flash = budgets.get("flash")
+    if flash is not None:
+        print("FLASH: %d of %d bytes (%.1f%%)" % (used["flash"], flash, 100.0 * used["flash"] / flash))
+        if used["flash"] > flash:
+            failures.append("flash %d bytes exceeds budget %d" % (used["flash"], flash))
+
+    for region in ("iram", "dram"):
+        limit = budgets.get("app_" + region)
+        if limit is not None and app[region] > limit:
+            failures.append("src/ %s %d bytes exceeds budget %d" % (region.upper(), app[region], limit))
+
+    return failures
+
+
+def report(map_path, budgets, top=25):
+    modules, flash_copy, segments = parse_map(map_path)
+    if not modules:
+        print("footprint: no sections found in %s" % map_path)
+        return 1
+    print_report(modules, flash_copy, top)
+    failures = check_budgets(modules, flash_copy, segments, budgets)
+    for failure in failures:
+        print("footprint: BUDGET EXCEEDED: " + failure)
+    return 1 if failures else 0
+
+
+BUDGET_OPTIONS = ("iram_pct", "dram_pct", "flash", "app_iram", "app_dram")
+
+
+def pio_main(env):
+    map_path = os.path.join(env.subst("$BUILD_DIR"), env.subst("${PROGNAME}") + ".footprint.map")
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+
+    budgets = {}
+    for option in BUDGET_OPTIONS:
+        value = env.GetProjectOption("custom_footprint_" + option, "")
+        budgets[option] = int(value) if value else None
+
+    def after_link(target, source, env):
+        print("Footprint report (%s)" % env.subst("$PIOENV"))
+        return report(map_path, budgets)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)
+
+
+def cli_main(argv):
+    if len(argv) < 2:
+        print("usage: footprint.py MAP [--top N] [--iram-pct P] [--dram-pct P] [--flash BYTES]"
+              " [--app-iram BYTES] [--app-dram BYTES]")
+        return 2
+    top = 25
+    budgets = dict.fromkeys(BUDGET_OPTIONS)
+    args = argv[2:]
+    while args:
+        flag = args.pop(0)
+        if not args:
+            print("missing value for " + flag)
+            return 2
+        value = int(args.pop(0))
+        if flag == "--top":
+            top = value
+        else:
+            budgets[flag[2:].replace("-", "_")] = value
+    return report(argv[1], budgets, top)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by SCons when run as a PlatformIO script
+    pio_main(env)  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        sys.exit(cli_main(sys.argv))
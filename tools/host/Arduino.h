@@ -0,0 +1,47 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in, see esp_host.h: the arduino-esp32 core API used under src/
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_host.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+typedef struct hw_timer_s hw_timer_t;
+
+static inline unsigned long millis() {
+    return (unsigned long)(host_time_us() / 1000);
+}
+
+static inline unsigned long micros() {
+    return (unsigned long)host_time_us();
+}
+
+void delay(uint32_t ms);
+
+static inline uint32_t getCpuFrequencyMhz() {
+    return 240;
+}
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool count_up);
+void timerEnd(hw_timer_t* timer);
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge);
+void timerDetachInterrupt(hw_timer_t* timer);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarm_value, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+void timerWrite(hw_timer_t* timer, uint64_t value);
+
+#endif // HOST_ARDUINO_H
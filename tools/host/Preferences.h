@@ -0,0 +1,25 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+// Host stand-in, see esp_host.h: an in-memory NVS that counts flash writes
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool read_only = false);
+    void end();
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t max_len);
+    size_t getBytesLength(const char* key);
+    bool remove(const char* key);
+
+private:
+    std::string m_namespace;
+    bool m_open = false;
+    bool m_read_only = false;
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,20 @@
+#ifndef HOST_DRIVER_DAC_H
+#define HOST_DRIVER_DAC_H
+
+// Host stand-in, see esp_host.h
+
+#include "esp_err.h"
+
+typedef enum {
+    DAC_CHANNEL_1 = 0,      // GPIO25
+    DAC_CHANNEL_2 = 1,      // GPIO26
+    DAC_CHANNEL_MAX,
+} dac_channel_t;
+
+/**
+ * Power up the channel's pad (RTC_IO_PDACn_XPD_DAC)
+ */
+esp_err_t dac_output_enable(dac_channel_t channel);
+esp_err_t dac_output_disable(dac_channel_t channel);
+
+#endif // HOST_DRIVER_DAC_H
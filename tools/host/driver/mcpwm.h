@@ -0,0 +1,107 @@
+#ifndef HOST_DRIVER_MCPWM_H
+#define HOST_DRIVER_MCPWM_H
+
+// Host stand-in, see esp_host.h: the legacy (IDF 4.x) MCPWM driver API
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    MCPWM_UNIT_0 = 0,
+    MCPWM_UNIT_1,
+    MCPWM_UNIT_MAX,
+} mcpwm_unit_t;
+
+typedef enum {
+    MCPWM_TIMER_0 = 0,
+    MCPWM_TIMER_1,
+    MCPWM_TIMER_2,
+    MCPWM_TIMER_MAX,
+} mcpwm_timer_t;
+
+typedef enum {
+    MCPWM0A = 0, MCPWM0B, MCPWM1A, MCPWM1B, MCPWM2A, MCPWM2B,
+} mcpwm_io_signals_t;
+
+typedef enum {
+    MCPWM_GEN_A = 0,
+    MCPWM_GEN_B,
+    MCPWM_GEN_MAX,
+} mcpwm_generator_t;
+
+typedef enum {
+    MCPWM_DUTY_MODE_0 = 0,      // Active high
+    MCPWM_DUTY_MODE_1,          // Active low
+    MCPWM_DUTY_MODE_FORCE_LOW,
+    MCPWM_DUTY_MODE_FORCE_HIGH,
+    MCPWM_DUTY_MODE_MAX,
+} mcpwm_duty_type_t;
+
+typedef enum {
+    MCPWM_FREEZE_COUNTER = 0,
+    MCPWM_UP_COUNTER,
+    MCPWM_DOWN_COUNTER,
+    MCPWM_UP_DOWN_COUNTER,
+} mcpwm_counter_type_t;
+
+typedef enum {
+    MCPWM_DEADTIME_BYPASS = 0,
+    MCPWM_BYPASS_RED,
+    MCPWM_BYPASS_FED,
+    MCPWM_ACTIVE_HIGH_MODE,
+    MCPWM_ACTIVE_LOW_MODE,
+    MCPWM_ACTIVE_HIGH_COMPLIMENT_MODE,
+    MCPWM_ACTIVE_LOW_COMPLIMENT_MODE,
+} mcpwm_deadtime_type_t;
+
+typedef enum {
+    MCPWM_SWSYNC_SOURCE_SYNCIN = 0,
+    MCPWM_SWSYNC_SOURCE_TEZ,
+    MCPWM_SWSYNC_SOURCE_TEP,
+    MCPWM_SWSYNC_SOURCE_DISABLED,
+} mcpwm_timer_sync_trigger_t;
+
+typedef enum {
+    MCPWM_SELECT_NO_INPUT = 0,
+    MCPWM_SELECT_TIMER0_SYNC,
+    MCPWM_SELECT_TIMER1_SYNC,
+    MCPWM_SELECT_TIMER2_SYNC,
+} mcpwm_sync_signal_t;
+
+typedef enum {
+    MCPWM_TIMER_DIRECTION_UP = 0,
+    MCPWM_TIMER_DIRECTION_DOWN,
+} mcpwm_timer_direction_t;
+
+typedef struct {
+    uint32_t frequency;
+    float cmpr_a;                   // Duty in percent
+    float cmpr_b;
+    mcpwm_duty_type_t duty_mode;
+    mcpwm_counter_type_t counter_mode;
+} mcpwm_config_t;
+
+typedef struct {
+    mcpwm_sync_signal_t sync_sig;
+    uint32_t timer_val;             // Phase on sync, per mille of the period
+    mcpwm_timer_direction_t count_direction;
+} mcpwm_sync_config_t;
+
+esp_err_t mcpwm_gpio_init(mcpwm_unit_t mcpwm_num, mcpwm_io_signals_t io_signal, int gpio_num);
+esp_err_t mcpwm_group_set_resolution(mcpwm_unit_t mcpwm_num, unsigned long int resolution);
+esp_err_t mcpwm_timer_set_resolution(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, unsigned long int resolution);
+esp_err_t mcpwm_init(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, const mcpwm_config_t* mcpwm_conf);
+esp_err_t mcpwm_set_frequency(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, uint32_t frequency);
+esp_err_t mcpwm_deadtime_enable(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_deadtime_type_t dt_mode,
+                                uint32_t red, uint32_t fed);
+esp_err_t mcpwm_set_timer_sync_output(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num,
+                                      mcpwm_timer_sync_trigger_t trigger);
+esp_err_t mcpwm_sync_configure(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, const mcpwm_sync_config_t* sync_conf);
+esp_err_t mcpwm_start(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num);
+esp_err_t mcpwm_stop(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num);
+esp_err_t mcpwm_set_duty_type(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_generator_t gen,
+                              mcpwm_duty_type_t duty_type);
+esp_err_t mcpwm_set_signal_low(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_generator_t gen);
+esp_err_t mcpwm_set_signal_high(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_generator_t gen);
+
+#endif // HOST_DRIVER_MCPWM_H
@@ -0,0 +1,21 @@
+#ifndef HOST_DRIVER_TIMER_H
+#define HOST_DRIVER_TIMER_H
+
+// Host stand-in, see esp_host.h: group/index map onto the Arduino timers
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    TIMER_GROUP_0 = 0,
+    TIMER_GROUP_1 = 1,
+} timer_group_t;
+
+typedef enum {
+    TIMER_0 = 0,
+    TIMER_1 = 1,
+} timer_idx_t;
+
+void timer_group_set_alarm_value_in_isr(timer_group_t group, timer_idx_t timer, uint64_t alarm_value);
+
+#endif // HOST_DRIVER_TIMER_H
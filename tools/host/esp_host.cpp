@@ -0,0 +1,781 @@
+/**
+ * Simulated ESP32 peripherals for the host tools (see esp_host.h)
+ */
+#include "esp_host.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+#include "Arduino.h"
+#include "Preferences.h"
+#include "freertos/task.h"
+#include "driver/dac.h"
+#include "driver/ledc.h"
+#include "driver/mcpwm.h"
+#include "driver/timer.h"
+#include "esp_wifi.h"
+#include "soc/mcpwm_struct.h"
+#include "soc/rtc_io_reg.h"
+
+#define APB_CLK_HZ              80000000ULL
+
+// RTC_CNTL, RTC_IO and SENS share this 4 KB window
+#define REG_WINDOW_BASE         0x3ff48000
+#define REG_WINDOW_WORDS        1024
+
+// ===== Clock =====
+
+static std::atomic<bool> g_virtual_clock(false);
+static std::atomic<int64_t> g_virtual_us(0);
+
+static std::chrono::steady_clock::time_point clock_origin() {
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return origin;
+}
+
+int64_t host_time_us() {
+    if (g_virtual_clock.load()) return g_virtual_us.load();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - clock_origin()).count();
+}
+
+uint32_t host_cycle_count() {
+    if (g_virtual_clock.load()) return (uint32_t)(g_virtual_us.load() * getCpuFrequencyMhz());
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - clock_origin()).count();
+    return (uint32_t)(ns * getCpuFrequencyMhz() / 1000);
+}
+
+void host_clock_set_virtual() {
+    g_virtual_us = host_time_us();
+    g_virtual_clock = true;
+}
+
+// ===== Tasks =====
+//
+// Every task is a thread. A task is either runnable or blocked in a delay
+// or a notification wait; whoever ends the wait (the clock, a notifier, or
+// the task itself on a real-clock timeout) marks it runnable again, so
+// g_runnable never undercounts and the virtual clock can tell when all
+// tasks have caught up.
+
+struct host_task {
+    TaskFunction_t fn;
+    void* arg;
+    std::string name;
+    bool blocked;
+    int64_t deadline_us;        // Wake time, -1 for none
+    bool waits_notify;
+    uint32_t notify_value;
+    bool started;
+    pthread_t thread;
+};
+
+static std::mutex g_sched_mutex;
+static std::condition_variable g_sched_cv;
+static std::vector<host_task*> g_tasks;
+static int g_runnable = 0;
+static thread_local host_task* t_self = nullptr;
+
+static void wake_locked(host_task* task) {
+    task->blocked = false;
+    task->waits_notify = false;
+    g_runnable++;
+}
+
+/**
+ * Block the calling task until woken; the caller holds g_sched_mutex
+ */
+static void block_locked(std::unique_lock<std::mutex>& lock, int64_t deadline_us, bool waits_notify) {
+    host_task* self = t_self;
+    self->blocked = true;
+    self->deadline_us = deadline_us;
+    self->waits_notify = waits_notify;
+    g_runnable--;
+    g_sched_cv.notify_all();
+    while (self->blocked) {
+        if (g_virtual_clock.load() || deadline_us < 0) {
+            g_sched_cv.wait(lock);
+        } else {
+            g_sched_cv.wait_until(lock, clock_origin() + std::chrono::microseconds(deadline_us));
+            if (self->blocked && host_time_us() >= deadline_us) wake_locked(self);
+        }
+    }
+}
+
+/**
+ * Wait until a deadline; non-task threads simply sleep
+ */
+static void sleep_until_us(int64_t deadline_us) {
+    if (!t_self) {
+        while (host_time_us() < deadline_us) {
+            std::this_thread::sleep_for(std::chrono::microseconds(deadline_us - host_time_us()));
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(g_sched_mutex);
+    if (host_time_us() < deadline_us) block_locked(lock, deadline_us, false);
+}
+
+static void settle_locked(std::unique_lock<std::mutex>& lock) {
+    g_sched_cv.wait(lock, [] { return g_runnable == 0; });
+}
+
+void host_tasks_settle() {
+    std::unique_lock<std::mutex> lock(g_sched_mutex);
+    settle_locked(lock);
+}
+
+int64_t host_task_cpu_us(const char* name) {
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    for (host_task* task : g_tasks) {
+        clockid_t clock;
+        struct timespec ts;
+        if (task->name == name && task->started && pthread_getcpuclockid(task->thread, &clock) == 0 &&
+            clock_gettime(clock, &ts) == 0) {
+            return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        }
+    }
+    return -1;
+}
+
+void host_clock_advance_us(int64_t us) {
+    std::unique_lock<std::mutex> lock(g_sched_mutex);
+    int64_t target = g_virtual_us.load() + us;
+    settle_locked(lock);
+    while (true) {
+        // Next expiring wait before the target, in time order
+        int64_t next = target;
+        for (host_task* task : g_tasks) {
+            if (task->blocked && task->deadline_us >= 0 && task->deadline_us < next) {
+                next = task->deadline_us;
+            }
+        }
+        if (next > g_virtual_us.load()) g_virtual_us = next;
+        for (host_task* task : g_tasks) {
+            if (task->blocked && task->deadline_us >= 0 && task->deadline_us <= next) {
+                wake_locked(task);
+            }
+        }
+        g_sched_cv.notify_all();
+        settle_locked(lock);
+        if (next >= target) break;
+    }
+}
+
+static void task_entry(host_task* task) {
+    t_self = task;
+    {
+        std::lock_guard<std::mutex> lock(g_sched_mutex);
+        task->thread = pthread_self();
+        task->started = true;
+    }
+    task->fn(task->arg);
+    // FreeRTOS tasks must not return; treat it as deleting itself
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    g_runnable--;
+    task->blocked = true;
+    task->deadline_us = -1;
+    g_sched_cv.notify_all();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)stack_depth;
+    (void)priority;
+    (void)core;
+    host_task* task = new host_task();
+    task->fn = fn;
+    task->arg = arg;
+    task->name = name;
+    task->blocked = false;
+    task->deadline_us = -1;
+    task->waits_notify = false;
+    task->notify_value = 0;
+    task->started = false;
+    {
+        std::lock_guard<std::mutex> lock(g_sched_mutex);
+        g_tasks.push_back(task);
+        g_runnable++;
+    }
+    if (handle) *handle = task;
+    std::thread(task_entry, task).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Only used on tasks that have not run yet or on failure paths; the
+    // thread keeps its slot but is never woken again
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    if (task && !task->blocked) {
+        task->blocked = true;
+        task->deadline_us = -1;
+        g_runnable--;
+        g_sched_cv.notify_all();
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    sleep_until_us(host_time_us() + (int64_t)ticks * 1000);
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake, TickType_t increment) {
+    *previous_wake += increment;
+    sleep_until_us((int64_t)*previous_wake * 1000);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(host_time_us() / 1000);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(g_sched_mutex);
+    host_task* self = t_self;
+    if (self->notify_value == 0 && ticks_to_wait != 0) {
+        int64_t deadline = ticks_to_wait == portMAX_DELAY ? -1 : host_time_us() + (int64_t)ticks_to_wait * 1000;
+        block_locked(lock, deadline, true);
+    }
+    uint32_t value = self->notify_value;
+    if (value) self->notify_value = clear_on_exit ? 0 : value - 1;
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(g_sched_mutex);
+    task->notify_value++;
+    if (task->blocked && task->waits_notify) {
+        wake_locked(task);
+        g_sched_cv.notify_all();
+    }
+    return pdPASS;
+}
+
+void delay(uint32_t ms) {
+    vTaskDelay(ms);
+}
+
+// ===== Registers =====
+
+// Hardware registers are not shared memory in the C++ sense: relaxed
+// atomics keep the simulation itself out of the race detector's reports
+static std::atomic<uint32_t> g_regs[REG_WINDOW_WORDS];
+
+static std::atomic<uint32_t>& reg_at(uint32_t addr) {
+    if (addr < REG_WINDOW_BASE || addr >= REG_WINDOW_BASE + REG_WINDOW_WORDS * 4 || (addr & 3)) {
+        fprintf(stderr, "esp_host: register 0x%08x is not simulated\n", addr);
+        abort();
+    }
+    return g_regs[(addr - REG_WINDOW_BASE) / 4];
+}
+
+uint32_t host_reg_read(uint32_t addr) {
+    return reg_at(addr).load(std::memory_order_relaxed);
+}
+
+void host_reg_write(uint32_t addr, uint32_t value) {
+    reg_at(addr).store(value, std::memory_order_relaxed);
+}
+
+// ===== DAC =====
+
+esp_err_t dac_output_enable(dac_channel_t channel) {
+    uint32_t reg = channel == DAC_CHANNEL_1 ? RTC_IO_PAD_DAC1_REG : RTC_IO_PAD_DAC2_REG;
+    SET_PERI_REG_MASK(reg, RTC_IO_PDAC1_XPD_DAC);
+    return ESP_OK;
+}
+
+esp_err_t dac_output_disable(dac_channel_t channel) {
+    uint32_t reg = channel == DAC_CHANNEL_1 ? RTC_IO_PAD_DAC1_REG : RTC_IO_PAD_DAC2_REG;
+    CLEAR_PERI_REG_MASK(reg, RTC_IO_PDAC1_XPD_DAC);
+    return ESP_OK;
+}
+
+// ===== Hardware timers =====
+
+// The timer registers are hardware, not memory the firmware shares: a lock
+// keeps the model itself race-free when a tool fires the ISR from its own
+// thread while firmware code reprograms the timer
+static std::mutex g_timer_mutex;
+static hw_timer_t g_timers[4];
+
+hw_timer_t* host_timer(uint8_t num) {
+    return num < 4 ? &g_timers[num] : nullptr;
+}
+
+// Set on the thread running an ISR through host_timer_fire()
+static thread_local bool g_in_isr = false;
+static std::atomic<uint32_t> g_isr_context_errors(0);
+
+void host_isr_only_call() {
+    if (!g_in_isr) g_isr_context_errors++;
+}
+
+uint32_t host_isr_context_errors() {
+    return g_isr_context_errors.load();
+}
+
+bool host_timer_fire(hw_timer_t* timer) {
+    void (*isr)();
+    {
+        std::lock_guard<std::mutex> lock(g_timer_mutex);
+        isr = timer->alarm_enabled ? timer->isr : nullptr;
+    }
+    if (!isr) return false;
+    g_in_isr = true;
+    isr();
+    g_in_isr = false;
+    return true;
+}
+
+double host_timer_rate(const hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    if (!timer->divider || !timer->alarm) return 0;
+    return (double)APB_CLK_HZ / timer->divider / timer->alarm;
+}
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool count_up) {
+    (void)count_up;
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    hw_timer_t* timer = num < 4 ? &g_timers[num] : nullptr;
+    if (!timer || timer->started) return nullptr;
+    memset(timer, 0, sizeof(*timer));
+    timer->num = num;
+    timer->divider = divider;
+    timer->started = true;
+    return timer;
+}
+
+void timerEnd(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    memset(timer, 0, sizeof(*timer));
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge) {
+    (void)edge;
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    timer->isr = fn;
+}
+
+void timerDetachInterrupt(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    timer->isr = nullptr;
+}
+
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarm_value, bool autoreload) {
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    timer->alarm = alarm_value;
+    timer->autoreload = autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    timer->alarm_enabled = true;
+}
+
+void timerAlarmDisable(hw_timer_t* timer) {
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    timer->alarm_enabled = false;
+}
+
+void timerWrite(hw_timer_t* timer, uint64_t value) {
+    (void)timer;
+    (void)value;
+}
+
+void timer_group_set_alarm_value_in_isr(timer_group_t group, timer_idx_t timer, uint64_t alarm_value) {
+    host_isr_only_call();
+    std::lock_guard<std::mutex> lock(g_timer_mutex);
+    g_timers[group * 2 + timer].alarm = alarm_value;
+}
+
+// ===== LEDC =====
+
+host_ledc_timer_t host_ledc_timers[4];
+host_ledc_channel_t host_ledc_channels[8];
+
+/**
+ * Divider for a frequency at a duty resolution, as the driver computes it
+ * @return 10.8 fixed-point divider, 0 if out of the hardware's range
+ */
+static uint32_t ledc_divider(uint32_t freq_hz, uint32_t resolution) {
+    if (!freq_hz) return 0;
+    uint64_t div = (APB_CLK_HZ << 8) / freq_hz / (1ULL << resolution);
+    return (div < 256 || div >= (1ULL << 18)) ? 0 : (uint32_t)div;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t* cfg) {
+    if (cfg->speed_mode != LEDC_HIGH_SPEED_MODE || cfg->timer_num >= LEDC_TIMER_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t div = ledc_divider(cfg->freq_hz, cfg->duty_resolution);
+    if (!div) return ESP_FAIL;
+    host_ledc_timer_t* timer = &host_ledc_timers[cfg->timer_num];
+    timer->configured = true;
+    timer->duty_resolution = cfg->duty_resolution;
+    timer->div_param = div;
+    timer->freq_hz = cfg->freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_freq(ledc_mode_t mode, ledc_timer_t timer_num, uint32_t freq_hz) {
+    if (mode != LEDC_HIGH_SPEED_MODE || timer_num >= LEDC_TIMER_MAX) return ESP_ERR_INVALID_ARG;
+    host_ledc_timer_t* timer = &host_ledc_timers[timer_num];
+    if (!timer->configured) return ESP_ERR_INVALID_STATE;
+    uint32_t div = ledc_divider(freq_hz, timer->duty_resolution);
+    if (!div) return ESP_FAIL;
+    timer->div_param = div;
+    timer->freq_hz = freq_hz;
+    return ESP_OK;
+}
+
+double host_ledc_frequency(uint32_t timer_num) {
+    const host_ledc_timer_t* timer = &host_ledc_timers[timer_num];
+    if (!timer->div_param) return 0;
+    return (double)(APB_CLK_HZ << 8) / ((double)timer->div_param * (1ULL << timer->duty_resolution));
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t* cfg) {
+    if (cfg->speed_mode != LEDC_HIGH_SPEED_MODE || cfg->channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Applied immediately, output enabled
+    host_ledc_channel_t* ch = &host_ledc_channels[cfg->channel];
+    ch->configured = true;
+    ch->gpio = cfg->gpio_num;
+    ch->timer = cfg->timer_sel;
+    ch->duty = ch->next_duty = cfg->duty;
+    ch->hpoint = ch->next_hpoint = (uint32_t)cfg->hpoint;
+    ch->update_pending = false;
+    ch->output_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint) {
+    if (mode != LEDC_HIGH_SPEED_MODE || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    host_ledc_channel_t* ch = &host_ledc_channels[channel];
+    uint32_t max = 1UL << host_ledc_timers[ch->timer].duty_resolution;
+    if (hpoint >= max || duty > max) return ESP_ERR_INVALID_ARG;
+    ch->next_duty = duty;
+    ch->next_hpoint = hpoint;
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel) {
+    if (mode != LEDC_HIGH_SPEED_MODE || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    host_ledc_channel_t* ch = &host_ledc_channels[channel];
+    ch->update_pending = true;
+    ch->output_enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t ledc_stop(ledc_mode_t mode, ledc_channel_t channel, uint32_t idle_level) {
+    if (mode != LEDC_HIGH_SPEED_MODE || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    host_ledc_channel_t* ch = &host_ledc_channels[channel];
+    ch->output_enabled = false;
+    ch->idle_level = idle_level;
+    return ESP_OK;
+}
+
+void host_ledc_period_boundary() {
+    for (int i = 0; i < LEDC_CHANNEL_MAX; i++) {
+        host_ledc_channel_t* ch = &host_ledc_channels[i];
+        if (ch->update_pending) {
+            ch->duty = ch->next_duty;
+            ch->hpoint = ch->next_hpoint;
+            ch->update_pending = false;
+        }
+    }
+}
+
+// ===== MCPWM =====
+
+host_mcpwm_unit_t host_mcpwm[2];
+mcpwm_dev_t MCPWM0;
+mcpwm_dev_t MCPWM1;
+
+static mcpwm_dev_t* mcpwm_regs(mcpwm_unit_t unit) {
+    return unit == MCPWM_UNIT_0 ? &MCPWM0 : &MCPWM1;
+}
+
+static bool mcpwm_args_valid(mcpwm_unit_t unit, mcpwm_timer_t timer) {
+    return unit < MCPWM_UNIT_MAX && timer < MCPWM_TIMER_MAX;
+}
+
+esp_err_t mcpwm_gpio_init(mcpwm_unit_t unit, mcpwm_io_signals_t signal, int gpio_num) {
+    if (unit >= MCPWM_UNIT_MAX || signal > MCPWM2B) return ESP_ERR_INVALID_ARG;
+    host_mcpwm[unit].gpio[signal] = gpio_num;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_group_set_resolution(mcpwm_unit_t unit, unsigned long int resolution) {
+    // 160 MHz source, 8-bit prescaler
+    if (unit >= MCPWM_UNIT_MAX || !resolution || 160000000UL % resolution ||
+        160000000UL / resolution > 256) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_mcpwm[unit].group_resolution_hz = resolution;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_set_resolution(mcpwm_unit_t unit, mcpwm_timer_t timer, unsigned long int resolution) {
+    if (!mcpwm_args_valid(unit, timer)) return ESP_ERR_INVALID_ARG;
+    uint32_t group = host_mcpwm[unit].group_resolution_hz;
+    if (!resolution || resolution > group || group % resolution || group / resolution > 256) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_mcpwm[unit].timer[timer].resolution_hz = resolution;
+    mcpwm_regs(unit)->timer[timer].period.prescale = group / resolution - 1;
+    return ESP_OK;
+}
+
+static esp_err_t mcpwm_program_period(mcpwm_unit_t unit, mcpwm_timer_t timer, uint32_t frequency) {
+    host_mcpwm_timer_t* t = &host_mcpwm[unit].timer[timer];
+    if (!frequency) return ESP_ERR_INVALID_ARG;
+    uint32_t period = t->resolution_hz / frequency;
+    if (period < 2 || period > 65535) return ESP_ERR_INVALID_ARG;
+    t->frequency = frequency;
+    mcpwm_regs(unit)->timer[timer].period.period = period;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_init(mcpwm_unit_t unit, mcpwm_timer_t timer, const mcpwm_config_t* cfg) {
+    if (!mcpwm_args_valid(unit, timer)) return ESP_ERR_INVALID_ARG;
+    host_mcpwm_timer_t* t = &host_mcpwm[unit].timer[timer];
+    esp_err_t err = mcpwm_program_period(unit, timer, cfg->frequency);
+    if (err != ESP_OK) return err;
+    t->cmpr_a = cfg->cmpr_a;
+    t->cmpr_b = cfg->cmpr_b;
+    t->duty_mode = cfg->duty_mode;
+    t->gen_mode[MCPWM_GEN_A] = cfg->duty_mode;
+    t->gen_mode[MCPWM_GEN_B] = cfg->duty_mode;
+    t->counter_mode = cfg->counter_mode;
+    // The driver starts the timer as part of init
+    t->running = true;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_set_frequency(mcpwm_unit_t unit, mcpwm_timer_t timer, uint32_t frequency) {
+    if (!mcpwm_args_valid(unit, timer)) return ESP_ERR_INVALID_ARG;
+    return mcpwm_program_period(unit, timer, frequency);
+}
+
+esp_err_t mcpwm_deadtime_enable(mcpwm_unit_t unit, mcpwm_timer_t timer, mcpwm_deadtime_type_t mode,
+                                uint32_t red, uint32_t fed) {
+    if (!mcpwm_args_valid(unit, timer) || red > 65535 || fed > 65535) return ESP_ERR_INVALID_ARG;
+    host_mcpwm_timer_t* t = &host_mcpwm[unit].timer[timer];
+    t->deadtime_enabled = true;
+    t->deadtime_mode = mode;
+    t->deadtime_red = red;
+    t->deadtime_fed = fed;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_set_timer_sync_output(mcpwm_unit_t unit, mcpwm_timer_t timer, mcpwm_timer_sync_trigger_t trigger) {
+    if (!mcpwm_args_valid(unit, timer)) return ESP_ERR_INVALID_ARG;
+    host_mcpwm[unit].timer[timer].sync_out = trigger;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_sync_configure(mcpwm_unit_t unit, mcpwm_timer_t timer, const mcpwm_sync_config_t* cfg) {
+    if (!mcpwm_args_valid(unit, timer) || cfg->timer_val > 999) return ESP_ERR_INVALID_ARG;
+    host_mcpwm_timer_t* t = &host_mcpwm[unit].timer[timer];
+    t->sync_in = true;
+    t->sync_sig = cfg->sync_sig;
+    t->sync_direction = cfg->count_direction;
+    // The driver only has per-mille phase resolution
+    host_mcpwm_timer_regs_t* regs = &mcpwm_regs(unit)->timer[timer];
+    regs->sync.in_en = 1;
+    regs->sync.timer_phase = regs->period.period * cfg->timer_val / 1000;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_start(mcpwm_unit_t unit, mcpwm_timer_t timer) {
+    if (!mcpwm_args_valid(unit, timer)) return ESP_ERR_INVALID_ARG;
+    host_mcpwm[unit].timer[timer].running = true;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_stop(mcpwm_unit_t unit, mcpwm_timer_t timer) {
+    if (!mcpwm_args_valid(unit, timer)) return ESP_ERR_INVALID_ARG;
+    host_mcpwm[unit].timer[timer].running = false;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_set_duty_type(mcpwm_unit_t unit, mcpwm_timer_t timer, mcpwm_generator_t gen,
+                              mcpwm_duty_type_t duty_type) {
+    if (!mcpwm_args_valid(unit, timer) || gen >= MCPWM_GEN_MAX || duty_type >= MCPWM_DUTY_MODE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_mcpwm[unit].timer[timer].gen_mode[gen] = duty_type;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_set_signal_low(mcpwm_unit_t unit, mcpwm_timer_t timer, mcpwm_generator_t gen) {
+    return mcpwm_set_duty_type(unit, timer, gen, MCPWM_DUTY_MODE_FORCE_LOW);
+}
+
+esp_err_t mcpwm_set_signal_high(mcpwm_unit_t unit, mcpwm_timer_t timer, mcpwm_generator_t gen) {
+    return mcpwm_set_duty_type(unit, timer, gen, MCPWM_DUTY_MODE_FORCE_HIGH);
+}
+
+/**
+ * Generator output: forced level, else switching (or frozen mid-period)
+ */
+static int mcpwm_generator_level(const host_mcpwm_timer_t* t, int gen) {
+    if (t->gen_mode[gen] == MCPWM_DUTY_MODE_FORCE_LOW) return 0;
+    if (t->gen_mode[gen] == MCPWM_DUTY_MODE_FORCE_HIGH) return 1;
+    return -1;
+}
+
+int host_mcpwm_output_level(int unit, int timer, int gen) {
+    const host_mcpwm_timer_t* t = &host_mcpwm[unit].timer[timer];
+    int a = mcpwm_generator_level(t, MCPWM_GEN_A);
+    if (!t->deadtime_enabled) return mcpwm_generator_level(t, gen);
+    // The complementary modes derive both pads from generator A
+    switch (t->deadtime_mode) {
+    case MCPWM_ACTIVE_HIGH_COMPLIMENT_MODE:
+        return a < 0 ? -1 : gen == 0 ? a : !a;
+    case MCPWM_ACTIVE_LOW_COMPLIMENT_MODE:
+        return a < 0 ? -1 : gen == 0 ? !a : a;
+    default:
+        return mcpwm_generator_level(t, gen);
+    }
+}
+
+// ===== NVS =====
+
+static std::mutex g_nvs_mutex;
+static std::map<std::string, std::vector<uint8_t> > g_nvs;
+static host_nvs_stats_t g_nvs_stats;
+
+static std::string nvs_key(const std::string& ns, const char* key) {
+    return ns + "/" + key;
+}
+
+void host_nvs_set(const char* ns, const char* key, const void* value, uint32_t len) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    const uint8_t* bytes = (const uint8_t*)value;
+    g_nvs[nvs_key(ns, key)] = std::vector<uint8_t>(bytes, bytes + len);
+}
+
+void host_nvs_get_stats(host_nvs_stats_t* stats) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    *stats = g_nvs_stats;
+}
+
+void host_nvs_reset_stats() {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    memset(&g_nvs_stats, 0, sizeof(g_nvs_stats));
+}
+
+bool Preferences::begin(const char* name, bool read_only) {
+    // NVS namespace names are at most 15 characters
+    if (!name || strlen(name) > 15) return false;
+    m_namespace = name;
+    m_read_only = read_only;
+    m_open = true;
+    return true;
+}
+
+void Preferences::end() {
+    m_open = false;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!m_open || m_read_only || !len) return 0;
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    const uint8_t* bytes = (const uint8_t*)value;
+    std::vector<uint8_t>& stored = g_nvs[nvs_key(m_namespace, key)];
+    // NVS compares before writing: an identical blob costs no flash
+    if (stored.size() == len && memcmp(stored.data(), bytes, len) == 0) return len;
+    stored.assign(bytes, bytes + len);
+    g_nvs_stats.puts++;
+    g_nvs_stats.bytes += len;
+    // Blob index entry, data chunk header, then the data in 32-byte entries
+    g_nvs_stats.entries += 2 + (uint32_t)((len + 31) / 32);
+    return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t max_len) {
+    if (!m_open) return 0;
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    std::map<std::string, std::vector<uint8_t> >::const_iterator it = g_nvs.find(nvs_key(m_namespace, key));
+    // Like the Arduino core: a blob larger than the buffer is not read at all
+    if (it == g_nvs.end() || it->second.size() > max_len) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!m_open) return 0;
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    std::map<std::string, std::vector<uint8_t> >::const_iterator it = g_nvs.find(nvs_key(m_namespace, key));
+    return it == g_nvs.end() ? 0 : it->second.size();
+}
+
+bool Preferences::remove(const char* key) {
+    if (!m_open || m_read_only) return false;
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    return g_nvs.erase(nvs_key(m_namespace, key)) > 0;
+}
+
+// ===== Wi-Fi =====
+
+// Station default after WiFi.begin()
+static std::atomic<int> g_wifi_ps(WIFI_PS_MIN_MODEM);
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type) {
+    if (type < WIFI_PS_NONE || type > WIFI_PS_MAX_MODEM) return ESP_ERR_INVALID_ARG;
+    g_wifi_ps = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t* type) {
+    if (!type) return ESP_ERR_INVALID_ARG;
+    *type = (wifi_ps_type_t)g_wifi_ps.load();
+    return ESP_OK;
+}
+
+// ===== Reset =====
+
+void host_reset_peripherals() {
+    for (int i = 0; i < REG_WINDOW_WORDS; i++) {
+        g_regs[i].store(0, std::memory_order_relaxed);
+    }
+    memset(g_timers, 0, sizeof(g_timers));
+    memset(host_ledc_timers, 0, sizeof(host_ledc_timers));
+    memset(host_ledc_channels, 0, sizeof(host_ledc_channels));
+    memset(&MCPWM0, 0, sizeof(MCPWM0));
+    memset(&MCPWM1, 0, sizeof(MCPWM1));
+    for (int u = 0; u < 2; u++) {
+        memset(&host_mcpwm[u], 0, sizeof(host_mcpwm[u]));
+        // Driver defaults: 10 MHz group clock, 1 MHz timers
+        host_mcpwm[u].group_resolution_hz = 10000000;
+        for (int g = 0; g < 6; g++) host_mcpwm[u].gpio[g] = -1;
+        for (int t = 0; t < 3; t++) {
+            host_mcpwm[u].timer[t].resolution_hz = 1000000;
+            host_mcpwm[u].timer[t].sync_out = -1;
+        }
+    }
+}
+
+// Peripherals come up in their power-on state
+static struct host_power_on {
+    host_power_on() {
+        host_reset_peripherals();
+    }
+} g_power_on;
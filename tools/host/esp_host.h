@@ -0,0 +1,202 @@
+#ifndef ESP_HOST_H
+#define ESP_HOST_H
+
+#include <stdint.h>
+
+/**
+ * Host stand-in for the ESP32 peripherals the firmware modules touch
+ *
+ * The headers next to this one (Arduino.h, esp_wifi.h and the driver, soc,
+ * hal, freertos and lwip directories) declare the subset of the
+ * Arduino/ESP-IDF API used under src/, so firmware translation units build
+ * unchanged on Linux. Their calls land in the simulated peripherals below,
+ * which the host tools read back to check what the firmware programmed.
+ *
+ * Build a tool with:
+ *   g++ -std=c++11 -pthread -I tools/host -I src ... tools/host/esp_host.cpp
+ *
+ * Only the peripheral behaviour the firmware depends on is modelled; in
+ * particular nothing here runs in real time unless a tool asks for it.
+ */
+
+// ===== Clock =====
+
+/**
+ * Microseconds since the first call (esp_timer_get_time, micros, millis)
+ */
+int64_t host_time_us();
+
+/**
+ * CPU cycles at getCpuFrequencyMhz() (cpu_hal_get_cycle_count)
+ */
+uint32_t host_cycle_count();
+
+/**
+ * Replace the real clock with one that only moves in host_clock_advance_us()
+ * Call before any task is created. Tasks then run in lock-step with the
+ * tool, so debounce and timeout logic can be checked deterministically.
+ */
+void host_clock_set_virtual();
+
+/**
+ * Advance the virtual clock, waking every task whose delay or timeout
+ * expires on the way, in time order; returns once they have all blocked again
+ * @param us Microseconds to advance
+ */
+void host_clock_advance_us(int64_t us);
+
+// ===== Tasks (freertos/task.h) =====
+
+/**
+ * Wait until every task is blocked in a delay or a notification wait,
+ * e.g. after the tool notified one through a firmware call
+ */
+void host_tasks_settle();
+
+/**
+ * CPU time the task's thread has used so far
+ * @param name Name the task was created with
+ * @return Microseconds, -1 if no such task is running
+ */
+int64_t host_task_cpu_us(const char* name);
+
+// ===== Peripheral registers (SENS, RTC_IO: DAC and CW generator) =====
+
+uint32_t host_reg_read(uint32_t addr);
+void host_reg_write(uint32_t addr, uint32_t value);
+
+// ===== Hardware timers (Arduino hw_timer_t) =====
+
+struct hw_timer_s {
+    uint8_t num;
+    uint16_t divider;
+    uint64_t alarm;             // Timer counts per alarm
+    bool autoreload;
+    bool alarm_enabled;
+    bool started;
+    void (*isr)();
+};
+
+/**
+ * Timer handle as returned by timerBegin()
+ * @param num Timer number 0..3
+ */
+struct hw_timer_s* host_timer(uint8_t num);
+
+/**
+ * Run the attached ISR once, as the alarm would
+ * @return false if the alarm is disabled or no ISR is attached
+ */
+bool host_timer_fire(struct hw_timer_s* timer);
+
+/**
+ * Calls to ISR-only functions (the _in_isr timer driver calls,
+ * portENTER/EXIT_CRITICAL_ISR) made outside host_timer_fire()
+ */
+uint32_t host_isr_context_errors();
+
+/**
+ * Alarm rate the timer is programmed for
+ * @return Alarms per second at the 80 MHz APB clock
+ */
+double host_timer_rate(const struct hw_timer_s* timer);
+
+// ===== LEDC (high-speed group) =====
+
+typedef struct {
+    bool configured;
+    uint32_t duty_resolution;   // Bits
+    uint32_t div_param;         // Clock divider, 10.8 fixed point
+    uint32_t freq_hz;           // Last requested
+} host_ledc_timer_t;
+
+typedef struct {
+    bool configured;
+    int gpio;
+    uint32_t timer;
+    bool output_enabled;        // Cleared by ledc_stop(), set by ledc_update_duty()
+    uint32_t idle_level;
+    uint32_t duty;              // Active (latched) values
+    uint32_t hpoint;
+    uint32_t next_duty;         // Written values, latched at the next period start
+    uint32_t next_hpoint;
+    bool update_pending;
+} host_ledc_channel_t;
+
+extern host_ledc_timer_t host_ledc_timers[4];
+extern host_ledc_channel_t host_ledc_channels[8];
+
+/**
+ * Period start: latch pending duty/hpoint updates, as the hardware does
+ */
+void host_ledc_period_boundary();
+
+/**
+ * Output frequency the timer divider actually produces
+ */
+double host_ledc_frequency(uint32_t timer);
+
+// ===== MCPWM =====
+
+typedef struct {
+    uint32_t resolution_hz;
+    uint32_t frequency;         // Last requested
+    float cmpr_a;
+    float cmpr_b;
+    int duty_mode;
+    int gen_mode[2];            // Generator A/B duty type, MCPWM_DUTY_MODE_FORCE_* while forced
+    int counter_mode;
+    bool deadtime_enabled;
+    int deadtime_mode;
+    uint32_t deadtime_red;      // Rising edge delay, group clock counts
+    uint32_t deadtime_fed;      // Falling edge delay, group clock counts
+    int sync_out;               // Sync output source, -1 if none
+    bool sync_in;               // Counter reloads from sync.timer_phase on sync
+    int sync_sig;
+    int sync_direction;
+    bool running;
+} host_mcpwm_timer_t;
+
+typedef struct {
+    uint32_t group_resolution_hz;
+    int gpio[6];                // Per MCPWMxA/B signal, -1 if not routed
+    host_mcpwm_timer_t timer[3];
+} host_mcpwm_unit_t;
+
+extern host_mcpwm_unit_t host_mcpwm[2];
+
+/**
+ * Level on an MCPWM output pad, after the dead-time module
+ * @param gen 0 = xA, 1 = xB
+ * @return 0 or 1 while held at a defined level, -1 while switching, or
+ *         frozen by mcpwm_stop() at whatever level it last had
+ */
+int host_mcpwm_output_level(int unit, int timer, int gen);
+
+// ===== NVS (Preferences) =====
+
+typedef struct {
+    uint32_t puts;              // putBytes() etc. that changed flash
+    uint32_t bytes;             // Payload bytes written
+    uint32_t entries;           // 32-byte NVS entries written (blob index + header + data)
+} host_nvs_stats_t;
+
+/**
+ * Store a raw value, as a previous firmware would have left it
+ */
+void host_nvs_set(const char* ns, const char* key, const void* value, uint32_t len);
+
+/**
+ * Flash writes since boot or the last reset
+ */
+void host_nvs_get_stats(host_nvs_stats_t* stats);
+void host_nvs_reset_stats();
+
+// ===== Reset =====
+
+/**
+ * Return every simulated peripheral to its power-on state
+ */
+void host_reset_peripherals();
+
+#endif // ESP_HOST_H
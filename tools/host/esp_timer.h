@@ -0,0 +1,14 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+// Host stand-in, see esp_host.h
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_host.h"
+
+static inline int64_t esp_timer_get_time() {
+    return host_time_us();
+}
+
+#endif // HOST_ESP_TIMER_H
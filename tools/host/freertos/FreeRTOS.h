@@ -0,0 +1,39 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// Host stand-in, see esp_host.h: critical sections are a plain mutex
+
+#include <stdint.h>
+#include <mutex>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  1
+#define pdFAIL                  0
+#define portMAX_DELAY           0xffffffffUL
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define configTICK_RATE_HZ      1000
+
+struct host_portmux {
+    std::mutex mutex;
+};
+typedef struct host_portmux portMUX_TYPE;
+
+// Counts a call that is only legal inside an ISR when made outside one
+// (see host_isr_context_errors() in esp_host.h)
+void host_isr_only_call();
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux)         ((mux)->mutex.lock())
+#define portEXIT_CRITICAL(mux)          ((mux)->mutex.unlock())
+#define portENTER_CRITICAL_ISR(mux)     (host_isr_only_call(), (mux)->mutex.lock())
+#define portEXIT_CRITICAL_ISR(mux)      (host_isr_only_call(), (mux)->mutex.unlock())
+#define portENTER_CRITICAL_SAFE(mux)    ((mux)->mutex.lock())
+#define portEXIT_CRITICAL_SAFE(mux)     ((mux)->mutex.unlock())
+
+#endif // HOST_FREERTOS_H
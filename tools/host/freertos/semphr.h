@@ -0,0 +1,39 @@
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+// Host stand-in, see esp_host.h: a mutex semaphore is a timed mutex;
+// timeouts count ticks as milliseconds, like the firmware's 1 kHz tick
+
+#include <chrono>
+#include <mutex>
+#include "freertos/FreeRTOS.h"
+
+struct host_semaphore {
+    std::timed_mutex mutex;
+};
+typedef struct host_semaphore StaticSemaphore_t;
+typedef struct host_semaphore* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer) {
+    return buffer;
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new host_semaphore();
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        sem->mutex.lock();
+        return pdTRUE;
+    }
+    if (ticks == 0) return sem->mutex.try_lock() ? pdTRUE : pdFALSE;
+    return sem->mutex.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    sem->mutex.unlock();
+    return pdTRUE;
+}
+
+#endif // HOST_FREERTOS_SEMPHR_H
@@ -0,0 +1,12 @@
+#ifndef HOST_CPU_HAL_H
+#define HOST_CPU_HAL_H
+
+// Host stand-in, see esp_host.h
+
+#include "esp_host.h"
+
+static inline uint32_t cpu_hal_get_cycle_count() {
+    return host_cycle_count();
+}
+
+#endif // HOST_CPU_HAL_H
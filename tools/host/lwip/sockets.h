@@ -0,0 +1,33 @@
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+// Host stand-in, see esp_host.h: lwIP's BSD socket API is the POSIX one
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+static inline int closesocket(int fd) {
+    return close(fd);
+}
+
+// lwIP gives every connection a small send buffer (CONFIG_LWIP_TCP_SND_BUF_DEFAULT),
+// where Linux autotunes to megabytes: a peer that stops reading would take
+// hours instead of seconds to fill it
+#define HOST_LWIP_TCP_SND_BUF   5744
+
+static inline int host_lwip_accept(int fd, struct sockaddr* addr, socklen_t* addr_len) {
+    int conn = accept(fd, addr, addr_len);
+    if (conn >= 0) {
+        int size = HOST_LWIP_TCP_SND_BUF;
+        setsockopt(conn, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+    return conn;
+}
+#define accept host_lwip_accept
+
+#endif // HOST_LWIP_SOCKETS_H
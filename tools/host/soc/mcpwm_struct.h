@@ -0,0 +1,26 @@
+#ifndef HOST_SOC_MCPWM_STRUCT_H
+#define HOST_SOC_MCPWM_STRUCT_H
+
+// Host stand-in, see esp_host.h: only the timer fields the firmware touches
+
+#include <stdint.h>
+
+typedef struct {
+    struct {
+        uint32_t prescale;
+        uint32_t period;            // Counts per period
+    } period;
+    struct {
+        uint32_t in_en;
+        uint32_t timer_phase;       // Counter value loaded on sync
+    } sync;
+} host_mcpwm_timer_regs_t;
+
+typedef struct {
+    host_mcpwm_timer_regs_t timer[3];
+} mcpwm_dev_t;
+
+extern mcpwm_dev_t MCPWM0;
+extern mcpwm_dev_t MCPWM1;
+
+#endif // HOST_SOC_MCPWM_STRUCT_H
@@ -0,0 +1,8 @@
+#ifndef HOST_SOC_RTC_H
+#define HOST_SOC_RTC_H
+
+// Host stand-in, see esp_host.h
+
+#define RTC_FAST_CLK_FREQ_APPROX    8500000
+
+#endif // HOST_SOC_RTC_H
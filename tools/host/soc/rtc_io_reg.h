@@ -0,0 +1,18 @@
+#ifndef HOST_SOC_RTC_IO_REG_H
+#define HOST_SOC_RTC_IO_REG_H
+
+// Host stand-in, see esp_host.h: ESP32 addresses and fields, simulated registers
+
+#include "soc/soc.h"
+
+#define RTC_IO_PAD_DAC1_REG         (DR_REG_RTCIO_BASE + 0x84)
+#define RTC_IO_PDAC1_DAC            0x000000FF      // Output code, channel 1
+#define RTC_IO_PDAC1_DAC_S          19
+#define RTC_IO_PDAC1_XPD_DAC        (BIT(18))       // Pad powered
+
+#define RTC_IO_PAD_DAC2_REG         (DR_REG_RTCIO_BASE + 0x88)
+#define RTC_IO_PDAC2_DAC            0x000000FF      // Output code, channel 2
+#define RTC_IO_PDAC2_DAC_S          19
+#define RTC_IO_PDAC2_XPD_DAC        (BIT(18))       // Pad powered
+
+#endif // HOST_SOC_RTC_IO_REG_H
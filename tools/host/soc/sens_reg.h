@@ -0,0 +1,21 @@
+#ifndef HOST_SOC_SENS_REG_H
+#define HOST_SOC_SENS_REG_H
+
+// Host stand-in, see esp_host.h: ESP32 addresses and fields, simulated registers
+
+#include "soc/soc.h"
+
+#define SENS_SAR_DAC_CTRL1_REG      (DR_REG_SENS_BASE + 0x0098)
+#define SENS_SW_FSTEP               0x0000FFFF      // CW generator frequency step
+#define SENS_SW_FSTEP_S             0
+#define SENS_SW_TONE_EN             (BIT(16))       // CW generator enable
+
+#define SENS_SAR_DAC_CTRL2_REG      (DR_REG_SENS_BASE + 0x009c)
+#define SENS_DAC_INV1               0x00000003      // CW output inversion, channel 1
+#define SENS_DAC_INV1_S             20
+#define SENS_DAC_INV2               0x00000003      // CW output inversion, channel 2
+#define SENS_DAC_INV2_S             22
+#define SENS_DAC_CW_EN1_M           (BIT(24))       // CW generator drives channel 1
+#define SENS_DAC_CW_EN2_M           (BIT(25))       // CW generator drives channel 2
+
+#endif // HOST_SOC_SENS_REG_H
@@ -0,0 +1,25 @@
+#ifndef HOST_SOC_SOC_H
+#define HOST_SOC_SOC_H
+
+// Host stand-in, see esp_host.h: register access goes to the simulated file
+
+#include "esp_host.h"
+
+#define BIT(n)                      (1UL << (n))
+
+#define DR_REG_RTCIO_BASE           0x3ff48400
+#define DR_REG_SENS_BASE            0x3ff48800
+
+#define READ_PERI_REG(reg)          host_reg_read(reg)
+#define WRITE_PERI_REG(reg, val)    host_reg_write((reg), (val))
+#define SET_PERI_REG_MASK(reg, mask) \
+    host_reg_write((reg), host_reg_read(reg) | (uint32_t)(mask))
+#define CLEAR_PERI_REG_MASK(reg, mask) \
+    host_reg_write((reg), host_reg_read(reg) & ~(uint32_t)(mask))
+#define GET_PERI_REG_BITS2(reg, bit_map, shift) \
+    ((host_reg_read(reg) >> (shift)) & (bit_map))
+#define SET_PERI_REG_BITS(reg, bit_map, value, shift) \
+    host_reg_write((reg), (host_reg_read(reg) & ~((uint32_t)(bit_map) << (shift))) | \
+                          (((uint32_t)(value) & (bit_map)) << (shift)))
+
+#endif // HOST_SOC_SOC_H
@@ -0,0 +1,113 @@
+/**
+ * Host decoder for the binary event log
+ *
+ * With -DEVENT_LOG_BINARY the firmware never formats log text: the drain
+ * task writes each event as EVENT_LOG_FRAME_MAGIC followed by the raw
+ * event_log_record_t (src/event_log_format.h). This tool turns a serial
+ * capture back into timestamped lines with the same formatter and event
+ * table the firmware would have used. Bytes outside frames (boot messages
+ * printed directly with Serial) are passed through unchanged.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -I src -o log_decode tools/log_decode.cpp
+ *
+ * Usage:
+ *   stty -F /dev/ttyUSB0 115200 raw && log_decode < /dev/ttyUSB0
+ *   log_decode capture.bin [--no-text] [--relative]
+ *       --no-text   Drop bytes that are not part of a frame
+ *       --relative  Timestamps relative to the first event
+ *
+ * Lost events show up as "Log: N events dropped" where the device ring
+ * overflowed.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "event_log_format.h"
+
+static const size_t FRAME_SIZE = sizeof(uint32_t) + sizeof(event_log_record_t);
+
+static bool g_pass_text = true;
+static bool g_relative = false;
+static bool g_have_first = false;
+static uint32_t g_first_us = 0;
+static uint32_t g_events = 0;
+
+static void print_record(const event_log_record_t* rec) {
+    if (!g_have_first) {
+        g_first_us = rec->timestamp_us;
+        g_have_first = true;
+    }
+    uint32_t t = g_relative ? rec->timestamp_us - g_first_us : rec->timestamp_us;
+
+    char line[256];
+    event_log_format(rec, line, sizeof(line));
+    printf("[%6lu.%06lu] %s\n", (unsigned long)(t / 1000000), (unsigned long)(t % 1000000), line);
+    fflush(stdout);
+    g_events++;
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--no-text")) {
+            g_pass_text = false;
+        } else if (!strcmp(argv[i], "--relative")) {
+            g_relative = true;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: log_decode [capture.bin] [--no-text] [--relative]\n");
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    FILE* in = path ? fopen(path, "rb") : stdin;
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    // Sliding window: a frame is recognised by its magic, anything else is text
+    uint8_t buf[4096];
+    size_t len = 0;
+    for (;;) {
+        size_t n = fread(buf + len, 1, sizeof(buf) - len, in);
+        len += n;
+        bool eof = n == 0;
+
+        size_t pos = 0;
+        while (pos < len) {
+            if (len - pos >= sizeof(uint32_t) && read_u32(buf + pos) == EVENT_LOG_FRAME_MAGIC) {
+                if (len - pos < FRAME_SIZE) break;  // Rest of the frame not read yet
+                event_log_record_t rec;
+                const uint8_t* p = buf + pos + sizeof(uint32_t);
+                rec.timestamp_us = read_u32(p);
+                rec.id = (uint16_t)(p[4] | (p[5] << 8));
+                rec.reserved = 0;
+                for (int a = 0; a < EVENT_LOG_MAX_ARGS; a++) {
+                    rec.args[a] = read_u32(p + 8 + 4 * a);
+                }
+                print_record(&rec);
+                pos += FRAME_SIZE;
+            } else if (len - pos < sizeof(uint32_t) && !eof) {
+                break;  // Could be the start of a magic
+            } else {
+                if (g_pass_text) putchar(buf[pos]);
+                pos++;
+            }
+        }
+        memmove(buf, buf + pos, len - pos);
+        len -= pos;
+
+        if (eof) break;
+    }
+
+    if (in != stdin) fclose(in);
+    fprintf(stderr, "%lu events\n", (unsigned long)g_events);
+    return 0;
+}
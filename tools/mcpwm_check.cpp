@@ -0,0 +1,266 @@
+/**
+ * MCPWM timing and register check
+ *
+ * Checks the pure helpers in src/mcpwm_backend.h against independently
+ * computed values, then runs McpwmBackend against the simulated MCPWM in
+ * tools/host and checks what it programs:
+ *   - mcpwm_compute_timing(): period and dead-time ticks at 39, 40 and
+ *     41 kHz (and dead-times from 0 to 1 µs), dead-time well inside half
+ *     a period
+ *   - mcpwm_phase_ticks(): every tick of lag at each frequency, plus the
+ *     edges (0, one turn unit, half a tick, one tick, just below 360°);
+ *     the result is always a valid counter value (< period) and the lag
+ *     it produces is within half a tick of the request
+ *   - registers: group/timer resolution, pin routing, period, dead-time,
+ *     sync source and the sync phase after set_phase() and after a
+ *     frequency change, also across 39-41 kHz in 10 Hz steps where the
+ *     driver's integer period must match the one the phase is computed for
+ *   - output levels: after init() and stop() every high side (xA) is held
+ *     low and every low side (xB) high, not frozen mid-period; after
+ *     start() both pairs switch again
+ * Exits non-zero if any check fails.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -pthread -I tools/host -I src -DMCPWM_DEADTIME_NS=200 \
+ *       -o mcpwm_check tools/mcpwm_check.cpp src/mcpwm_backend.cpp tools/host/esp_host.cpp
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_host.h"
+#include "driver/mcpwm.h"
+#include "soc/mcpwm_struct.h"
+#include "mcpwm_backend.h"
+
+static int g_failures = 0;
+static int g_checks = 0;
+
+#define CHECK(cond, ...) do {                       \
+    g_checks++;                                     \
+    if (!(cond)) {                                  \
+        printf("  FAIL: " __VA_ARGS__);             \
+        printf("\n");                               \
+        g_failures++;                               \
+    }                                               \
+} while (0)
+
+static const float FREQUENCIES[] = {39000.0f, 40000.0f, 41000.0f};
+#define FREQUENCY_COUNT (sizeof(FREQUENCIES) / sizeof(FREQUENCIES[0]))
+
+/**
+ * Lag in ticks that a sync phase produces (inverse of mcpwm_phase_ticks)
+ */
+static uint32_t lag_for_ticks(uint32_t ticks, uint32_t period) {
+    return ticks == 0 ? 0 : period - ticks;
+}
+
+/**
+ * Signed error in ticks between the achieved lag and the requested phase
+ */
+static double lag_error_ticks(phase_t phase, uint32_t ticks, uint32_t period) {
+    double requested = phase.turns / 4294967296.0 * period;
+    double error = lag_for_ticks(ticks, period) - requested;
+    // Wrap into (-period/2, period/2]
+    if (error > period / 2.0) error -= period;
+    if (error <= -(period / 2.0)) error += period;
+    return error;
+}
+
+static void check_timing() {
+    printf("mcpwm_compute_timing (resolution %lu Hz)\n", (unsigned long)MCPWM_RESOLUTION_HZ);
+    const uint32_t deadtimes[] = {0, 100, 200, 500, 1000};
+    for (size_t f = 0; f < FREQUENCY_COUNT; f++) {
+        // The driver takes an integer frequency and truncates the period
+        uint32_t expected_period = MCPWM_RESOLUTION_HZ / (uint32_t)FREQUENCIES[f];
+        mcpwm_timing_t timing = mcpwm_compute_timing(FREQUENCIES[f], MCPWM_DEADTIME_NS);
+        printf("  %5.0f Hz  period %u ticks (%.2f Hz actual)  dead-time %u ns = %u ticks\n",
+               FREQUENCIES[f], timing.period_ticks, (double)MCPWM_RESOLUTION_HZ / timing.period_ticks,
+               MCPWM_DEADTIME_NS, timing.deadtime_ticks);
+        CHECK(timing.period_ticks == expected_period, "%.0f Hz: period %u, expected %u",
+              FREQUENCIES[f], timing.period_ticks, expected_period);
+        for (size_t d = 0; d < sizeof(deadtimes) / sizeof(deadtimes[0]); d++) {
+            mcpwm_timing_t t = mcpwm_compute_timing(FREQUENCIES[f], deadtimes[d]);
+            uint32_t expected = (uint32_t)llround(deadtimes[d] * 1e-9 * MCPWM_RESOLUTION_HZ);
+            CHECK(t.deadtime_ticks == expected, "%u ns: %u ticks, expected %u",
+                  deadtimes[d], t.deadtime_ticks, expected);
+            // Both edges delayed: each half period must outlast the dead-time
+            CHECK(t.deadtime_ticks < t.period_ticks / 2, "%u ns dead-time swallows the half period",
+                  deadtimes[d]);
+        }
+    }
+}
+
+static void check_phase_ticks() {
+    printf("mcpwm_phase_ticks\n");
+    for (size_t f = 0; f < FREQUENCY_COUNT; f++) {
+        uint32_t period = mcpwm_compute_timing(FREQUENCIES[f], MCPWM_DEADTIME_NS).period_ticks;
+
+        // Every whole-tick lag maps back exactly
+        uint32_t exact_failures = 0;
+        for (uint32_t lag = 0; lag < period; lag++) {
+            phase_t phase = phase_from_turns((uint32_t)((((uint64_t)lag << 32) + period / 2) / period));
+            uint32_t ticks = mcpwm_phase_ticks(phase, period);
+            if (ticks >= period || lag_for_ticks(ticks, period) != lag) exact_failures++;
+        }
+        CHECK(exact_failures == 0, "%.0f Hz: %u of %u tick lags map back wrong",
+              FREQUENCIES[f], exact_failures, period);
+
+        // Edges of the turn
+        struct {
+            const char* name;
+            phase_t phase;
+            uint32_t expected;
+        } edges[] = {
+            {"0°", PHASE_ZERO, 0},
+            {"1 turn unit", phase_from_turns(1), 0},
+            {"0.49 tick", phase_from_turns((uint32_t)(0.49 * 4294967296.0 / period)), 0},
+            {"0.51 tick", phase_from_turns((uint32_t)(0.51 * 4294967296.0 / period)), period - 1},
+            {"1 tick", phase_from_turns((uint32_t)(4294967296.0 / period + 0.5)), period - 1},
+            {"180°", phase_from_degrees(180), period - (period + 1) / 2},
+            {"359.9°", phase_from_degrees(359.9), period - (uint32_t)lround(359.9 / 360 * period)},
+            {"360° - 0.51 tick", phase_from_turns((uint32_t)(4294967296.0 - 0.51 * 4294967296.0 / period)), 1},
+            {"360° - 0.49 tick", phase_from_turns((uint32_t)(4294967296.0 - 0.49 * 4294967296.0 / period)), 0},
+            {"360° - 1 turn unit", phase_from_turns(0xFFFFFFFFu), 0},
+        };
+        printf("  %5.0f Hz (period %u):", FREQUENCIES[f], period);
+        for (size_t e = 0; e < sizeof(edges) / sizeof(edges[0]); e++) {
+            uint32_t ticks = mcpwm_phase_ticks(edges[e].phase, period);
+            double error = lag_error_ticks(edges[e].phase, ticks, period);
+            CHECK(ticks == edges[e].expected, "%.0f Hz %s: %u ticks, expected %u",
+                  FREQUENCIES[f], edges[e].name, ticks, edges[e].expected);
+            CHECK(fabs(error) <= 0.5, "%.0f Hz %s: lag off by %.2f ticks", FREQUENCIES[f], edges[e].name, error);
+        }
+        printf(" %zu edges, %u tick lags\n", sizeof(edges) / sizeof(edges[0]), period);
+
+        // Dense sweep: always a valid counter value within half a tick
+        double worst = 0;
+        for (uint32_t i = 0; i < (1u << 20); i++) {
+            phase_t phase = phase_from_turns(i << 12 | (i & 0xFFF));
+            uint32_t ticks = mcpwm_phase_ticks(phase, period);
+            double error = fabs(lag_error_ticks(phase, ticks, period));
+            if (error > worst) worst = error;
+            if (ticks >= period) {
+                CHECK(false, "%.0f Hz: %u ticks outside the period", FREQUENCIES[f], ticks);
+                break;
+            }
+        }
+        CHECK(worst <= 0.5 + 1e-6, "%.0f Hz: worst lag error %.3f ticks", FREQUENCIES[f], worst);
+    }
+}
+
+/**
+ * Sync phase and period registers against the helpers for one setting
+ */
+static void check_phase_register(float frequency, phase_t phase, const char* label) {
+    const host_mcpwm_timer_regs_t* slave = &MCPWM0.timer[1];
+    uint32_t period = slave->period.period;
+    CHECK(period == MCPWM0.timer[0].period.period, "%s: timer periods differ", label);
+    CHECK(period == mcpwm_compute_timing(frequency, MCPWM_DEADTIME_NS).period_ticks,
+          "%s: driver programmed %u ticks, helper computed %u", label, period,
+          mcpwm_compute_timing(frequency, MCPWM_DEADTIME_NS).period_ticks);
+    CHECK(slave->sync.timer_phase == mcpwm_phase_ticks(phase, period),
+          "%s: timer_phase %u, expected %u", label, slave->sync.timer_phase, mcpwm_phase_ticks(phase, period));
+    CHECK(slave->sync.timer_phase < period, "%s: timer_phase %u outside period %u",
+          label, slave->sync.timer_phase, period);
+}
+
+/**
+ * Idle outputs: high sides off, low sides on, so no bridge drives the
+ * transducer and none is left wherever mcpwm_stop() froze it
+ */
+static void check_idle_levels(const char* label) {
+    for (int t = 0; t < 2; t++) {
+        int a = host_mcpwm_output_level(0, t, 0);
+        int b = host_mcpwm_output_level(0, t, 1);
+        CHECK(a == 0 && b == 1, "%s: timer %d outputs A=%d B=%d, expected A=0 B=1 (-1 = not held)",
+              label, t, a, b);
+    }
+}
+
+static void check_registers() {
+    printf("McpwmBackend register programming\n");
+    McpwmBackend backend;
+    mcpwm_timing_t timing = mcpwm_compute_timing(40000.0f, MCPWM_DEADTIME_NS);
+    CHECK(backend.init(40000.0f, phase_from_degrees(90)), "init failed");
+
+    const host_mcpwm_unit_t* unit = &host_mcpwm[0];
+    CHECK(unit->group_resolution_hz == MCPWM_RESOLUTION_HZ, "group resolution %u", unit->group_resolution_hz);
+    const int pins[] = {25, 33, 26, 27};    // MCPWM0A/B, MCPWM1A/B
+    for (int i = 0; i < 4; i++) {
+        CHECK(unit->gpio[i] == pins[i], "signal %d routed to GPIO%d, expected GPIO%d", i, unit->gpio[i], pins[i]);
+    }
+    for (int t = 0; t < 2; t++) {
+        const host_mcpwm_timer_t* timer = &unit->timer[t];
+        CHECK(timer->resolution_hz == MCPWM_RESOLUTION_HZ, "timer %d resolution %u", t, timer->resolution_hz);
+        CHECK(timer->counter_mode == MCPWM_UP_COUNTER, "timer %d not counting up", t);
+        CHECK(timer->cmpr_a == 50.0f, "timer %d duty %.1f%%", t, timer->cmpr_a);
+        CHECK(timer->deadtime_enabled && timer->deadtime_mode == MCPWM_ACTIVE_HIGH_COMPLIMENT_MODE,
+              "timer %d not complementary", t);
+        CHECK(timer->deadtime_red == timing.deadtime_ticks && timer->deadtime_fed == timing.deadtime_ticks,
+              "timer %d dead-time %u/%u, expected %u", t, timer->deadtime_red, timer->deadtime_fed,
+              timing.deadtime_ticks);
+        CHECK(!timer->running, "timer %d running before start()", t);
+    }
+    CHECK(unit->timer[0].sync_out == MCPWM_SWSYNC_SOURCE_TEZ, "timer 0 does not sync out at TEZ");
+    CHECK(unit->timer[1].sync_in && unit->timer[1].sync_sig == MCPWM_SELECT_TIMER0_SYNC,
+          "timer 1 does not follow timer 0");
+    CHECK(!unit->timer[0].sync_in, "timer 0 must be free-running");
+    check_phase_register(40000.0f, phase_from_degrees(90), "init 90°");
+    check_idle_levels("init()");
+
+    backend.start();
+    CHECK(unit->timer[0].running && unit->timer[1].running, "timers idle after start()");
+    for (int t = 0; t < 2; t++) {
+        CHECK(host_mcpwm_output_level(0, t, 0) < 0 && host_mcpwm_output_level(0, t, 1) < 0,
+              "timer %d outputs still forced after start()", t);
+    }
+
+    // Edges at each frequency, including after a frequency change
+    const phase_t phases[] = {PHASE_ZERO, phase_from_turns(1), phase_from_degrees(180),
+                              phase_from_degrees(359.99), phase_from_turns(0xFFFFFFFFu)};
+    for (size_t f = 0; f < FREQUENCY_COUNT; f++) {
+        backend.set_frequency(FREQUENCIES[f]);
+        for (size_t p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+            backend.set_phase(phases[p]);
+            char label[48];
+            snprintf(label, sizeof(label), "%.0f Hz %.4f°", FREQUENCIES[f], phase_to_degrees(phases[p]));
+            check_phase_register(FREQUENCIES[f], phases[p], label);
+        }
+        // The phase set before a frequency change is re-applied at the new period
+        backend.set_phase(phase_from_degrees(270));
+        backend.set_frequency(FREQUENCIES[(f + 1) % FREQUENCY_COUNT]);
+        check_phase_register(FREQUENCIES[(f + 1) % FREQUENCY_COUNT], phase_from_degrees(270), "re-applied 270°");
+    }
+
+    // Between the spot frequencies the driver's integer period must still
+    // be the one the sync phase is computed for
+    uint32_t mismatches = 0;
+    for (uint32_t hz = 39000; hz <= 41000; hz += 10) {
+        backend.set_frequency((float)hz);
+        backend.set_phase(phase_from_degrees(359.99));    // Sync phase right at the period end
+        if (MCPWM0.timer[1].period.period != mcpwm_compute_timing((float)hz, MCPWM_DEADTIME_NS).period_ticks ||
+            MCPWM0.timer[1].sync.timer_phase >= MCPWM0.timer[1].period.period) {
+            mismatches++;
+        }
+    }
+    printf("  39-41 kHz in 10 Hz steps: %u period mismatches\n", mismatches);
+    CHECK(mismatches == 0, "%u frequencies where period and sync phase disagree", mismatches);
+
+    backend.stop();
+    CHECK(!unit->timer[0].running && !unit->timer[1].running, "timers running after stop()");
+    check_idle_levels("stop()");
+
+    // And again after a restart, which must release them
+    backend.start();
+    CHECK(host_mcpwm_output_level(0, 0, 0) < 0, "outputs still forced after the second start()");
+    backend.stop();
+    check_idle_levels("second stop()");
+}
+
+int main() {
+    check_timing();
+    check_phase_ticks();
+    check_registers();
+    printf("%d checks, %d failed\n", g_checks, g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,250 @@
+/**
+ * Persistence load compatibility and write amplification test
+ *
+ * Runs src/persistence.cpp on the tools/host stand-ins with the virtual
+ * clock, so the writer task and its debounce run in lock-step with the
+ * test, and the in-memory NVS counts every flash write:
+ *   - load: no record, a current record, an older shorter record (missing
+ *     fields keep their defaults and the record is rewritten in the new
+ *     layout at the next change), a newer version, an oversized record and
+ *     a record whose length disagrees with its header
+ *   - drag: UI drags at 60 setpoints/s (a plain drag, a drag with a hold
+ *     shorter than the debounce, one with a hold longer than two debounce
+ *     intervals, a wiggle that ends where it started, a single click),
+ *     reporting saves, NVS commits, flash entries written against writing
+ *     every setpoint, and the delay from the last setpoint to its commit
+ * Exits non-zero if any check fails.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -pthread -I tools/host -I src \
+ *       -o persistence_test tools/persistence_test.cpp src/persistence.cpp tools/host/esp_host.cpp
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_host.h"
+#include "persistence.h"
+
+#define DEBOUNCE_MS             2000
+#define FRAME_US                16667   // 60 Hz pointer events
+#define POLL_US                 10000
+
+// Mirrors the record in persistence.cpp
+#define RECORD_NAMESPACE        "levitator"
+#define RECORD_KEY              "state"
+#define RECORD_VERSION          1
+
+static int g_failures = 0;
+static int g_checks = 0;
+
+#define CHECK(cond, ...) do {                       \
+    g_checks++;                                     \
+    if (!(cond)) {                                  \
+        printf("  FAIL: " __VA_ARGS__);             \
+        printf("\n");                               \
+        g_failures++;                               \
+    }                                               \
+} while (0)
+
+static const levitation_state_t DEFAULTS = {40000, PHASE_ZERO};
+
+// ===== Load =====
+
+/**
+ * Store a raw record: header then the first size bytes of state
+ */
+static void store_record(uint16_t version, uint16_t size, uint32_t len, const levitation_state_t* state) {
+    uint8_t blob[64];
+    memset(blob, 0, sizeof(blob));
+    memcpy(blob, &version, sizeof(version));
+    memcpy(blob + 2, &size, sizeof(size));
+    memcpy(blob + 4, state, size < sizeof(*state) ? size : sizeof(*state));
+    host_nvs_set(RECORD_NAMESPACE, RECORD_KEY, blob, len);
+}
+
+static bool load(levitation_state_t* state) {
+    *state = DEFAULTS;
+    return persistence_load(state);
+}
+
+static bool same(const levitation_state_t* a, const levitation_state_t* b) {
+    return a->frequency_hz == b->frequency_hz && phase_equal(a->phase, b->phase);
+}
+
+static uint32_t wait_for_commit(uint32_t writes_before, int64_t limit_us, int64_t* waited_us) {
+    *waited_us = 0;
+    while (persistence_get_write_count() == writes_before && *waited_us < limit_us) {
+        host_clock_advance_us(POLL_US);
+        *waited_us += POLL_US;
+    }
+    return persistence_get_write_count() - writes_before;
+}
+
+static void check_load() {
+    printf("load\n");
+    levitation_state_t stored = {39500, phase_from_degrees(123.0f)};
+    levitation_state_t state;
+
+    bool ok = load(&state);
+    printf("  no record           %s\n", ok ? "loaded" : "defaults");
+    CHECK(!ok && same(&state, &DEFAULTS), "no record: expected defaults");
+
+    store_record(RECORD_VERSION, sizeof(levitation_state_t), 4 + sizeof(levitation_state_t), &stored);
+    ok = load(&state);
+    printf("  current record      %s\n", ok ? "loaded" : "defaults");
+    CHECK(ok && same(&state, &stored), "current record not restored");
+
+    // Version 0 had only the frequency
+    store_record(0, sizeof(uint32_t), 4 + sizeof(uint32_t), &stored);
+    ok = load(&state);
+    printf("  older, shorter      %s (%lu Hz, %.1f°)\n", ok ? "loaded" : "defaults",
+           (unsigned long)state.frequency_hz, phase_to_degrees(state.phase));
+    CHECK(ok && state.frequency_hz == stored.frequency_hz && phase_equal(state.phase, DEFAULTS.phase),
+          "older record: expected stored frequency and default phase");
+
+    // Unchanged state, but the record on flash is still the old layout
+    host_nvs_reset_stats();
+    uint32_t writes = persistence_get_write_count();
+    persistence_save(&state);
+    int64_t waited;
+    uint32_t commits = wait_for_commit(writes, 3 * DEBOUNCE_MS * 1000LL, &waited);
+    ok = load(&state);
+    printf("  older, after save   %s, %lu commit(s)\n", ok ? "rewritten" : "lost", (unsigned long)commits);
+    CHECK(commits == 1 && ok && state.frequency_hz == stored.frequency_hz,
+          "older record was not rewritten in the current layout");
+
+    store_record(RECORD_VERSION + 1, sizeof(levitation_state_t), 4 + sizeof(levitation_state_t), &stored);
+    ok = load(&state);
+    printf("  newer version       %s\n", ok ? "loaded" : "defaults");
+    CHECK(!ok && same(&state, &DEFAULTS), "newer version: expected defaults");
+
+    store_record(RECORD_VERSION, sizeof(levitation_state_t) + 4, 4 + sizeof(levitation_state_t) + 4, &stored);
+    ok = load(&state);
+    printf("  oversized           %s\n", ok ? "loaded" : "defaults");
+    CHECK(!ok && same(&state, &DEFAULTS), "oversized record: expected defaults");
+
+    store_record(RECORD_VERSION, sizeof(levitation_state_t), 4 + sizeof(uint32_t), &stored);
+    ok = load(&state);
+    printf("  truncated           %s\n", ok ? "loaded" : "defaults");
+    CHECK(!ok && same(&state, &DEFAULTS), "truncated record: expected defaults");
+
+    // Leave a current record behind for the drags
+    store_record(RECORD_VERSION, sizeof(levitation_state_t), 4 + sizeof(levitation_state_t), &DEFAULTS);
+    load(&state);
+}
+
+// ===== Drag =====
+
+typedef struct {
+    const char* name;
+    float hold_s;               // Pause in the middle, 0 for none
+    bool returns;               // Second half undoes the first
+    uint32_t frames;            // Setpoints per half
+    uint32_t expected_commits;
+} scenario_t;
+
+static const scenario_t SCENARIOS[] = {
+    {"drag 3 s",                0.0f, false, 90, 1},
+    {"drag, 1.5 s hold, drag",  1.5f, false, 45, 1},
+    {"drag, 4.5 s hold, drag",  4.5f, false, 45, 2},
+    {"wiggle back to start",    0.0f, true,  60, 0},
+    {"single click",            0.0f, false,  1, 1},
+};
+#define SCENARIO_COUNT (sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+
+static levitation_state_t g_state = DEFAULTS;
+
+static void step(float degrees) {
+    g_state.phase = phase_add(g_state.phase, phase_from_degrees(degrees));
+    persistence_save(&g_state);
+    host_clock_advance_us(FRAME_US);
+}
+
+static void run_drags() {
+    printf("drag at 60 Hz, debounce %d ms\n", DEBOUNCE_MS);
+    printf("  %-24s %6s %8s %8s %11s %6s %10s\n",
+           "scenario", "saves", "commits", "entries", "undebounced", "ratio", "latency ms");
+    uint32_t total_saves = 0;
+    uint32_t total_entries = 0;
+    uint32_t total_undebounced = 0;
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        const scenario_t* sc = &SCENARIOS[s];
+        host_nvs_reset_stats();
+        uint32_t saves = persistence_get_save_count();
+        uint32_t writes = persistence_get_write_count();
+
+        for (uint32_t i = 0; i < sc->frames; i++) step(0.5f);
+        if (sc->hold_s > 0) host_clock_advance_us((int64_t)(sc->hold_s * 1e6f));
+        if (sc->frames > 1) {
+            for (uint32_t i = 0; i < sc->frames; i++) step(sc->returns ? -0.5f : 0.5f);
+        }
+
+        // Latency of the final commit, measured from the last setpoint
+        int64_t waited;
+        uint32_t before_tail = persistence_get_write_count();
+        wait_for_commit(before_tail, 3 * DEBOUNCE_MS * 1000LL, &waited);
+        bool tail_committed = persistence_get_write_count() != before_tail;
+        // Anything still pending would show up here
+        host_clock_advance_us(3 * DEBOUNCE_MS * 1000LL);
+
+        host_nvs_stats_t stats;
+        host_nvs_get_stats(&stats);
+        saves = persistence_get_save_count() - saves;
+        writes = persistence_get_write_count() - writes;
+        // Writing every setpoint: one blob of the same size per save
+        uint32_t per_put = writes ? stats.entries / writes : 3;
+        uint32_t undebounced = saves * per_put;
+        char latency[16];
+        if (tail_committed) {
+            snprintf(latency, sizeof(latency), "%.0f", (waited + FRAME_US) / 1000.0);
+        } else {
+            snprintf(latency, sizeof(latency), "-");
+        }
+        char ratio[16];
+        if (stats.entries) {
+            snprintf(ratio, sizeof(ratio), "%.0fx", (double)undebounced / stats.entries);
+        } else {
+            snprintf(ratio, sizeof(ratio), "-");
+        }
+        printf("  %-24s %6lu %8lu %8lu %11lu %6s %10s\n", sc->name, (unsigned long)saves,
+               (unsigned long)writes, (unsigned long)stats.entries, (unsigned long)undebounced,
+               ratio, latency);
+
+        CHECK(writes == sc->expected_commits, "%s: %lu commits, expected %lu", sc->name,
+              (unsigned long)writes, (unsigned long)sc->expected_commits);
+        CHECK(stats.puts == writes, "%s: %lu flash writes for %lu commits", sc->name,
+              (unsigned long)stats.puts, (unsigned long)writes);
+        if (tail_committed) {
+            // One to two debounce intervals after the last change
+            int64_t latency_us = waited + FRAME_US;
+            CHECK(latency_us >= DEBOUNCE_MS * 1000LL && latency_us <= 2 * DEBOUNCE_MS * 1000LL + POLL_US,
+                  "%s: committed %.0f ms after the last setpoint", sc->name, latency_us / 1000.0);
+        }
+        total_saves += saves;
+        total_entries += stats.entries;
+        total_undebounced += undebounced;
+    }
+    printf("  total: %lu saves, %lu entries written, %lu without debounce\n",
+           (unsigned long)total_saves, (unsigned long)total_entries, (unsigned long)total_undebounced);
+
+    levitation_state_t state;
+    CHECK(load(&state) && same(&state, &g_state), "last drag position not restored");
+}
+
+int main() {
+    host_clock_set_virtual();
+    if (!persistence_init(DEBOUNCE_MS)) {
+        printf("persistence_init failed\n");
+        return 1;
+    }
+    host_tasks_settle();
+
+    check_load();
+    run_drags();
+
+    printf("%d checks, %d failed\n", g_checks, g_failures);
+    // The writer task never returns; leave without joining it
+    fflush(stdout);
+    _Exit(g_failures ? 1 : 0);
+}
@@ -0,0 +1,179 @@
+/**
+ * Phase conversion benchmark
+ *
+ * Times the float-degree phase path the control API used before
+ * src/phase_units.h (fmodf() wrap, then float scaling to the LEDC hpoint
+ * and the DAC LUT index) against the fixed-point phase_t path
+ * (phase_add(), phase_to_steps<1024>(), phase_to_index<8>()), and checks
+ * that both land on the same hpoint and LUT index.
+ *
+ * Inputs are a UI drag: a random walk of small phase steps that crosses
+ * 0°/360° in both directions, as levitation_move() and the slider produce.
+ * A second pass applies fixed moves (levitation_move() with a step that is
+ * not a binary fraction of a degree) for many full turns and reports how
+ * far each path has drifted from the exact phase.
+ *
+ * Host numbers only rank the two paths: the ESP32 has a single-precision
+ * FPU but fmodf() is a libm call on both, and the relative cost is what
+ * the firmware saves on every setpoint.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -I src -o phase_bench tools/phase_bench.cpp
+ *
+ * Usage:
+ *   phase_bench [--count N] [--turns N] [--move-deg D]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <random>
+#include <vector>
+#include "phase_units.h"
+
+#define LEDC_MAX_STEPS      1024        // 10-bit LEDC timer, as the ledc backend
+#define LUT_BITS            8           // 256-entry sine LUT, as phase_shifted_dac
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// ===== Float path (as before phase_units.h) =====
+
+static float old_wrap(float degrees) {
+    float wrapped = fmodf(degrees, 360.0f);
+    if (wrapped < 0) wrapped += 360.0f;
+    return wrapped;
+}
+
+static uint32_t old_hpoint(float degrees) {
+    return (uint32_t)((degrees / 360.0f) * (float)LEDC_MAX_STEPS + 0.5f);
+}
+
+static uint32_t old_lut_index(float degrees) {
+    const uint32_t fixed_two_pi = 65536;
+    uint32_t accumulator = (uint32_t)((degrees / 360.0f) * fixed_two_pi) % fixed_two_pi;
+    return (accumulator >> 8) & 0xFF;
+}
+
+// ===== Fixed-point path =====
+
+static uint32_t new_hpoint(phase_t phase) {
+    return phase_to_steps<LEDC_MAX_STEPS>(phase);
+}
+
+static uint32_t new_lut_index(phase_t phase) {
+    return phase_to_index<LUT_BITS>(phase);
+}
+
+/**
+ * Distance between two step counts on a ring of the given size
+ */
+static uint32_t ring_distance(uint32_t a, uint32_t b, uint32_t size) {
+    uint32_t d = (a + size - b % size) % size;
+    return d > size / 2 ? size - d : d;
+}
+
+int main(int argc, char** argv) {
+    size_t count = 1000000;
+    int turns = 1000;
+    double move_deg = 0.1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+            count = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--turns") && i + 1 < argc) {
+            turns = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--move-deg") && i + 1 < argc) {
+            move_deg = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--count N] [--turns N] [--move-deg D]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Drag steps of up to ±3°, the same walk fed to both paths
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> step_deg(-3.0, 3.0);
+    std::vector<float> steps_float(count);
+    std::vector<phase_t> steps_fixed(count);
+    for (size_t i = 0; i < count; i++) {
+        double d = step_deg(rng);
+        steps_float[i] = (float)d;
+        steps_fixed[i] = phase_from_degrees(d);
+    }
+
+    // Timed: setpoint update plus both backend conversions per step
+    volatile uint32_t sink = 0;
+    float deg = 0.0f;
+    double start = now_ns();
+    for (size_t i = 0; i < count; i++) {
+        deg = old_wrap(deg + steps_float[i]);
+        sink = old_hpoint(deg) + old_lut_index(deg);
+    }
+    double float_ns = (now_ns() - start) / count;
+
+    phase_t phase = PHASE_ZERO;
+    start = now_ns();
+    for (size_t i = 0; i < count; i++) {
+        phase = phase_add(phase, steps_fixed[i]);
+        sink = new_hpoint(phase) + new_lut_index(phase);
+    }
+    double fixed_ns = (now_ns() - start) / count;
+    (void)sink;
+
+    // Untimed: compare the two walks step by step
+    size_t hpoint_diff = 0, index_diff = 0, hpoint_overflow = 0;
+    uint32_t hpoint_worst = 0, index_worst = 0;
+    deg = 0.0f;
+    phase = PHASE_ZERO;
+    for (size_t i = 0; i < count; i++) {
+        deg = old_wrap(deg + steps_float[i]);
+        phase = phase_add(phase, steps_fixed[i]);
+
+        uint32_t oh = old_hpoint(deg), nh = new_hpoint(phase);
+        if (oh >= LEDC_MAX_STEPS) hpoint_overflow++;   // 359.9° rounds to 1024
+        if (oh % LEDC_MAX_STEPS != nh) {
+            hpoint_diff++;
+            uint32_t d = ring_distance(oh, nh, LEDC_MAX_STEPS);
+            if (d > hpoint_worst) hpoint_worst = d;
+        }
+        uint32_t oi = old_lut_index(deg), ni = new_lut_index(phase);
+        if (oi != ni) {
+            index_diff++;
+            uint32_t d = ring_distance(oi, ni, 1 << LUT_BITS);
+            if (d > index_worst) index_worst = d;
+        }
+    }
+
+    printf("drag walk, %zu setpoints (wrap + hpoint + LUT index each)\n", count);
+    printf("  float fmodf path   %7.2f ns/setpoint\n", float_ns);
+    printf("  phase_t path       %7.2f ns/setpoint  (%.1fx)\n", fixed_ns, float_ns / fixed_ns);
+    printf("  hpoint differs     %zu (worst %u steps), float hpoint == %u: %zu\n",
+           hpoint_diff, hpoint_worst, LEDC_MAX_STEPS, hpoint_overflow);
+    printf("  LUT index differs  %zu (worst %u entries)\n", index_diff, index_worst);
+
+    // Fixed moves: the float phase accumulates rounding on every add,
+    // phase_t only the rounding of the step constant
+    long moves = (long)(360.0 * turns / move_deg + 0.5);
+    float float_step = (float)move_deg;
+    phase_t fixed_step = phase_from_degrees(move_deg);
+    deg = 0.0f;
+    phase = PHASE_ZERO;
+    for (long i = 0; i < moves; i++) {
+        deg = old_wrap(deg + float_step);
+        phase = phase_add(phase, fixed_step);
+    }
+    float float_err = deg > 180.0f ? deg - 360.0f : deg;
+    float fixed_err = phase_to_degrees(phase);
+    if (fixed_err > 180.0f) fixed_err -= 360.0f;
+    printf("%ld moves of %g° (%d turns), error against 0°\n", moves, move_deg, turns);
+    printf("  float fmodf path   %+.6f°\n", float_err);
+    printf("  phase_t path       %+.6f°\n", fixed_err);
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+/**
+ * Position loop simulator and benchmark
+ *
+ * Runs the firmware's bead height controller (src/position_pid.cpp, with
+ * feed-forward from src/position_map.cpp) against a simulated plant and a
+ * stand-in sensor plugged in through the same PositionSensor interface as
+ * the firmware sensors, so gains can be tuned on Linux before touching the
+ * rig.
+ *
+ * Plant: the bead is a lightly damped mass-spring in the acoustic trap,
+ *   x'' = -wn² (x - trap - disturbance) - 2 zeta wn x'
+ * where trap = position_map_mm_for_phase(phase) + thermal drift, and the
+ * disturbance is an air-current step expressed as the static offset it
+ * would cause. The sensor adds Gaussian noise, quantization and a delay
+ * of whole loop periods.
+ *
+ * Scenario (per run, closed loop and feed-forward only):
+ *   t = 0.1 s  setpoint step 28.5 -> 30.0 mm         settling time, overshoot
+ *   t = 1.0 s  air current pushes the bead -0.3 mm    peak deviation, recovery
+ *   t = 1.5 s  thermal drift of the standing wave     RMS error until 2.5 s
+ * Then the controller cost per step is measured, and a real-time loop is
+ * run with clock_nanosleep() to report wake-up jitter and step latency.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -I src -o position_loop_sim tools/position_loop_sim.cpp \
+ *       src/position_pid.cpp src/position_map.cpp
+ *
+ * Usage:
+ *   position_loop_sim [--rate HZ] [--kp K] [--ki K] [--kd K] [--d-cutoff HZ]
+ *                     [--trap-hz HZ] [--zeta Z] [--noise MM] [--delay N]
+ *                     [--realtime-s S] [--csv FILE]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "position_pid.h"
+#include "position_map.h"
+#include "position_sensor.h"
+
+// Defaults match src/position_loop.h
+#define DEFAULT_RATE_HZ     1000
+#define DEFAULT_KP          20.0f
+#define DEFAULT_KI          3000.0f
+#define DEFAULT_KD          1.5f
+#define DEFAULT_D_CUTOFF_HZ 150.0f
+#define DEFAULT_MAX_CORRECTION_DEG 60.0f
+
+#define SUBSTEPS            20          // Plant integration steps per loop period
+#define SETTLE_BAND_MM      0.05f
+#define SIM_DURATION_S      2.5
+
+#define STEP_AT_S           0.1
+#define STEP_FROM_MM        28.5f
+#define STEP_TO_MM          30.0f
+#define GUST_AT_S           1.0
+#define GUST_MM             -0.3f
+#define DRIFT_AT_S          1.5
+#define DRIFT_MM_PER_S      0.2f
+
+typedef struct {
+    double trap_hz;
+    double zeta;
+    double x;               // Bead height, mm
+    double v;               // mm/s
+    double drift_mm;        // Standing-wave shift from heating
+    double gust_mm;         // Air current, as the static offset it causes
+    phase_t phase;          // Applied phase
+} plant_t;
+
+static void plant_step(plant_t* p, double dt) {
+    double wn = 2.0 * M_PI * p->trap_hz;
+    double trap = position_map_mm_for_phase(p->phase) + p->drift_mm + p->gust_mm;
+    double a = -wn * wn * (p->x - trap) - 2.0 * p->zeta * wn * p->v;
+    p->v += a * dt;         // Semi-implicit Euler
+    p->x += p->v * dt;
+}
+
+/**
+ * Stand-in for a real sensor: delayed, noisy, quantized view of the plant
+ */
+class SimPositionSensor : public PositionSensor<SimPositionSensor> {
+public:
+    static constexpr const char* NAME = "sim";
+
+    SimPositionSensor(const plant_t* plant, double noise_mm, int delay, double lsb_mm)
+        : m_plant(plant), m_noise(0.0, noise_mm > 0 ? noise_mm : 1e-12),
+          m_delay(delay), m_lsb(lsb_mm), m_rng(1) {}
+
+    bool begin_impl() {
+        m_history.assign(m_delay + 1, m_plant->x);
+        return true;
+    }
+
+    bool read_impl(float* mm) {
+        // Sample now, report the value from m_delay periods ago
+        double sample = m_plant->x + m_noise(m_rng);
+        sample = m_lsb > 0 ? round(sample / m_lsb) * m_lsb : sample;
+        m_history.push_back(sample);
+        *mm = (float)m_history.front();
+        m_history.erase(m_history.begin());
+        return true;
+    }
+
+private:
+    const plant_t* m_plant;
+    std::normal_distribution<double> m_noise;
+    int m_delay;
+    double m_lsb;
+    std::mt19937 m_rng;
+    std::vector<double> m_history;
+};
+
+typedef struct {
+    double settling_s;      // Step to staying within SETTLE_BAND_MM
+    double overshoot_mm;
+    double gust_peak_mm;    // Worst deviation after the gust
+    double gust_recovery_s; // Gust to staying within SETTLE_BAND_MM
+    double drift_rms_mm;
+} scenario_result_t;
+
+/**
+ * Time from `from_s` until the error stays inside the band up to `to_s`
+ */
+static double settle_time(const std::vector<double>& t, const std::vector<double>& err,
+                          double from_s, double to_s) {
+    double last_outside = from_s;
+    for (size_t i = 0; i < t.size(); i++) {
+        if (t[i] < from_s || t[i] >= to_s) continue;
+        if (fabs(err[i]) > SETTLE_BAND_MM) last_outside = t[i];
+    }
+    return last_outside - from_s;
+}
+
+static scenario_result_t run_scenario(const position_pid_gains_t* gains, bool closed_loop,
+                                      uint32_t rate_hz, double trap_hz, double zeta,
+                                      double noise_mm, int delay, FILE* csv) {
+    plant_t plant;
+    plant.trap_hz = trap_hz;
+    plant.zeta = zeta;
+    plant.phase = position_map_phase_for_mm(STEP_FROM_MM);
+    plant.x = position_map_mm_for_phase(plant.phase);
+    plant.v = 0;
+    plant.drift_mm = 0;
+    plant.gust_mm = 0;
+
+    // 12-bit ADC over ~10 mm of calibrated range
+    SimPositionSensor sensor(&plant, noise_mm, delay, 10.0 / 4096);
+    sensor.begin();
+    position_pid_t pid;
+    position_pid_init(&pid, gains);
+
+    double dt = 1.0 / rate_hz;
+    int steps = (int)(SIM_DURATION_S * rate_hz);
+    std::vector<double> times, errors;
+    double drift_sq = 0;
+    int drift_n = 0;
+    scenario_result_t result = {0, 0, 0, 0, 0};
+
+    for (int i = 0; i < steps; i++) {
+        double t = i * dt;
+        float target = t >= STEP_AT_S ? STEP_TO_MM : STEP_FROM_MM;
+        plant.gust_mm = t >= GUST_AT_S ? GUST_MM : 0.0;
+        plant.drift_mm = t >= DRIFT_AT_S ? DRIFT_MM_PER_S * (t - DRIFT_AT_S) : 0.0;
+
+        float measured;
+        sensor.read(&measured);
+        plant.phase = closed_loop ? position_pid_update(&pid, target, measured, (float)dt)
+                                  : position_map_phase_for_mm(target);
+
+        for (int s = 0; s < SUBSTEPS; s++) {
+            plant_step(&plant, dt / SUBSTEPS);
+        }
+
+        double err = plant.x - target;
+        times.push_back(t);
+        errors.push_back(err);
+        if (t >= STEP_AT_S && t < GUST_AT_S && err > result.overshoot_mm) {
+            result.overshoot_mm = err;
+        }
+        if (t >= GUST_AT_S && t < DRIFT_AT_S && fabs(err) > result.gust_peak_mm) {
+            result.gust_peak_mm = fabs(err);
+        }
+        if (t >= DRIFT_AT_S) {
+            drift_sq += err * err;
+            drift_n++;
+        }
+        if (csv) {
+            fprintf(csv, "%.4f,%d,%.4f,%.4f,%.4f,%.2f\n", t, closed_loop ? 1 : 0, target,
+                    plant.x, measured, phase_to_degrees(plant.phase));
+        }
+    }
+
+    result.settling_s = settle_time(times, errors, STEP_AT_S, GUST_AT_S);
+    result.gust_recovery_s = settle_time(times, errors, GUST_AT_S, DRIFT_AT_S);
+    result.drift_rms_mm = drift_n ? sqrt(drift_sq / drift_n) : 0;
+    return result;
+}
+
+static void print_result(const char* label, const scenario_result_t* r) {
+    printf("%-14s settle %7.1f ms  overshoot %6.3f mm  gust peak %6.3f mm  "
+           "recover %7.1f ms  drift rms %6.3f mm\n", label, r->settling_s * 1e3,
+           r->overshoot_mm, r->gust_peak_mm, r->gust_recovery_s * 1e3, r->drift_rms_mm);
+}
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Cost of one loop step (sensor stand-in + PID + feed-forward) on this host
+ */
+static void benchmark_step(const position_pid_gains_t* gains) {
+    plant_t plant = {20, 0.05, 29.0, 0, 0, 0, PHASE_ZERO};
+    SimPositionSensor sensor(&plant, 0.01, 0, 0);
+    sensor.begin();
+    position_pid_t pid;
+    position_pid_init(&pid, gains);
+
+    const int n = 1000000;
+    uint32_t sink = 0;
+    double start = now_ns();
+    for (int i = 0; i < n; i++) {
+        float measured;
+        sensor.read(&measured);
+        sink += position_pid_update(&pid, 29.5f, measured, 0.001f).turns;
+    }
+    double elapsed = now_ns() - start;
+    printf("step cost: %.1f ns (%d steps, checksum %08x)\n", elapsed / n, n, (unsigned)sink);
+}
+
+/**
+ * Fixed-rate loop on the host scheduler, like the firmware task
+ */
+static void benchmark_realtime(const position_pid_gains_t* gains, uint32_t rate_hz, double seconds) {
+    plant_t plant = {20, 0.05, 29.0, 0, 0, 0, PHASE_ZERO};
+    SimPositionSensor sensor(&plant, 0.01, 0, 0);
+    sensor.begin();
+    position_pid_t pid;
+    position_pid_init(&pid, gains);
+
+    long period_ns = 1000000000L / rate_hz;
+    int iterations = (int)(seconds * rate_hz);
+    std::vector<double> jitter_us, latency_us;
+    int overruns = 0;
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (int i = 0; i < iterations; i++) {
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+
+        double deadline = next.tv_sec * 1e9 + next.tv_nsec;
+        double woke = now_ns();
+        float measured;
+        sensor.read(&measured);
+        plant.phase = position_pid_update(&pid, 29.5f, measured, 1.0f / rate_hz);
+        plant_step(&plant, 1.0 / rate_hz);
+        double done = now_ns();
+
+        jitter_us.push_back((woke - deadline) / 1e3);
+        latency_us.push_back((done - deadline) / 1e3);
+        if (done - deadline > period_ns) overruns++;
+    }
+
+    std::sort(jitter_us.begin(), jitter_us.end());
+    std::sort(latency_us.begin(), latency_us.end());
+    size_t n = jitter_us.size();
+    printf("realtime %u Hz for %.1f s: wake jitter p50 %.1f  p99 %.1f  max %.1f us, "
+           "latency p99 %.1f  max %.1f us, overruns %d\n",
+           (unsigned)rate_hz, seconds, jitter_us[n / 2], jitter_us[n * 99 / 100], jitter_us[n - 1],
+           latency_us[n * 99 / 100], latency_us[n - 1], overruns);
+}
+
+int main(int argc, char** argv) {
+    uint32_t rate_hz = DEFAULT_RATE_HZ;
+    position_pid_gains_t gains;
+    gains.kp = DEFAULT_KP;
+    gains.ki = DEFAULT_KI;
+    gains.kd = DEFAULT_KD;
+    gains.d_cutoff_hz = DEFAULT_D_CUTOFF_HZ;
+    gains.max_correction_deg = DEFAULT_MAX_CORRECTION_DEG;
+    double trap_hz = 20.0;
+    double zeta = 0.05;
+    double noise_mm = 0.01;
+    int delay = 1;
+    double realtime_s = 2.0;
+    const char* csv_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "missing value for %s\n", argv[i]);
+            return 2;
+        }
+        const char* flag = argv[i];
+        const char* value = argv[++i];
+        if (!strcmp(flag, "--rate")) rate_hz = (uint32_t)atoi(value);
+        else if (!strcmp(flag, "--kp")) gains.kp = (float)atof(value);
+        else if (!strcmp(flag, "--ki")) gains.ki = (float)atof(value);
+        else if (!strcmp(flag, "--kd")) gains.kd = (float)atof(value);
+        else if (!strcmp(flag, "--d-cutoff")) gains.d_cutoff_hz = (float)atof(value);
+        else if (!strcmp(flag, "--trap-hz")) trap_hz = atof(value);
+        else if (!strcmp(flag, "--zeta")) zeta = atof(value);
+        else if (!strcmp(flag, "--noise")) noise_mm = atof(value);
+        else if (!strcmp(flag, "--delay")) delay = atoi(value);
+        else if (!strcmp(flag, "--realtime-s")) realtime_s = atof(value);
+        else if (!strcmp(flag, "--csv")) csv_path = value;
+        else {
+            fprintf(stderr, "unknown option %s\n", flag);
+            return 2;
+        }
+    }
+    if (rate_hz == 0) rate_hz = DEFAULT_RATE_HZ;
+
+    FILE* csv = nullptr;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            perror(csv_path);
+            return 1;
+        }
+        fprintf(csv, "t_s,closed_loop,target_mm,bead_mm,measured_mm,phase_deg\n");
+    }
+
+    printf("plant %.1f Hz trap, zeta %.2f; sensor noise %.3f mm, delay %d; loop %u Hz, "
+           "kp %.1f ki %.1f kd %.2f\n", trap_hz, zeta, noise_mm, delay, (unsigned)rate_hz,
+           gains.kp, gains.ki, gains.kd);
+    scenario_result_t open = run_scenario(&gains, false, rate_hz, trap_hz, zeta, noise_mm, delay, csv);
+    scenario_result_t closed = run_scenario(&gains, true, rate_hz, trap_hz, zeta, noise_mm, delay, csv);
+    print_result("feed-forward", &open);
+    print_result("closed loop", &closed);
+    if (csv) fclose(csv);
+
+    benchmark_step(&gains);
+    if (realtime_s > 0) {
+        benchmark_realtime(&gains, rate_hz, realtime_s);
+    }
+    return 0;
+}
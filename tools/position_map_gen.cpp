@@ -0,0 +1,276 @@
+/**
+ * Position -> phase map generator
+ *
+ * 1D acoustic model of the two opposed transducers along the levitation
+ * axis. For every phase shift it evaluates the Gor'kov potential of a small
+ * rigid sphere on a dense axial grid, tracks the trap that starts nearest
+ * the chamber centre, and inverts the resulting trap position(phase) curve
+ * into a monotonic position -> phase lookup table for the firmware
+ * (src/position_map_table.h).
+ *
+ * Model (per transducer, on axis, spherical spreading from a virtual
+ * source APERTURE behind the face):
+ *   p1(z) = e^{-ikz} / (a + z)
+ *   p2(z) = e^{-ik(D-z)} e^{-iφ} / (a + D - z)      (channel 2 lags by φ)
+ *   U(z) ∝ |p|² / 3 - |dp/dz|² / (2k²)             (Gor'kov, f1 = f2 = 1)
+ * Trap positions are the local minima of U.
+ *
+ * Build (host):
+ *   g++ -O3 -march=native -std=c++11 -I src -o position_map_gen tools/position_map_gen.cpp
+ *
+ * Usage:
+ *   position_map_gen [--frequency HZ] [--spacing-mm D] [--aperture-mm A]
+ *                    [--entries N] [--out FILE]
+ *   position_map_gen --sweep F0:F1:STEP [--spacing-mm D] ...   (CSV to stdout)
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "phase_units.h"
+
+#define SPEED_OF_SOUND_M_S  343.0f
+#define GRID_POINTS         4096    // Axial samples across the gap
+#define PHASE_POINTS        1024    // Phase samples per turn
+
+typedef struct {
+    float frequency_hz;
+    float spacing_mm;
+    float aperture_mm;
+    int entries;
+} model_config_t;
+
+typedef struct {
+    float min_mm;
+    float max_mm;
+    std::vector<uint32_t> phase_turns;  // One entry per evenly spaced position
+} position_map_t;
+
+/**
+ * Per-transducer field terms that do not depend on phase, split into
+ * real/imag arrays so the per-phase loop is a straight vectorizable pass.
+ */
+typedef struct {
+    std::vector<float> z_mm;
+    std::vector<float> p1_re, p1_im, d1_re, d1_im;  // p1 and dp1/dz
+    std::vector<float> p2_re, p2_im, d2_re, d2_im;  // p2 and dp2/dz (before phase)
+    float inv_2k2;
+} field_terms_t;
+
+static void build_field_terms(const model_config_t* cfg, field_terms_t* f) {
+    const float k = 2.0f * (float)M_PI * cfg->frequency_hz / (SPEED_OF_SOUND_M_S * 1000.0f);  // rad/mm
+    const float D = cfg->spacing_mm;
+    const float a = cfg->aperture_mm;
+    f->inv_2k2 = 1.0f / (2.0f * k * k);
+    
+    f->z_mm.resize(GRID_POINTS);
+    f->p1_re.resize(GRID_POINTS); f->p1_im.resize(GRID_POINTS);
+    f->d1_re.resize(GRID_POINTS); f->d1_im.resize(GRID_POINTS);
+    f->p2_re.resize(GRID_POINTS); f->p2_im.resize(GRID_POINTS);
+    f->d2_re.resize(GRID_POINTS); f->d2_im.resize(GRID_POINTS);
+    
+    for (int i = 0; i < GRID_POINTS; i++) {
+        float z = D * i / (GRID_POINTS - 1);
+        f->z_mm[i] = z;
+        
+        // p1 = e^{-ikz}/r1, dp1/dz = p1 * (-ik - 1/r1)
+        float r1 = a + z;
+        float c1 = cosf(k * z) / r1, s1 = -sinf(k * z) / r1;
+        f->p1_re[i] = c1;
+        f->p1_im[i] = s1;
+        f->d1_re[i] = -c1 / r1 + k * s1;
+        f->d1_im[i] = -s1 / r1 - k * c1;
+        
+        // p2 = e^{-ik(D-z)}/r2, dp2/dz = p2 * (ik + 1/r2)
+        float r2 = a + D - z;
+        float c2 = cosf(k * (D - z)) / r2, s2 = -sinf(k * (D - z)) / r2;
+        f->p2_re[i] = c2;
+        f->p2_im[i] = s2;
+        f->d2_re[i] = c2 / r2 - k * s2;
+        f->d2_im[i] = s2 / r2 + k * c2;
+    }
+}
+
+/**
+ * Gor'kov potential along the axis for one phase shift
+ */
+static void gorkov_potential(const field_terms_t* f, float phase_rad, float* u) {
+    const float cr = cosf(phase_rad), ci = -sinf(phase_rad);  // e^{-iφ}
+    const float inv_2k2 = f->inv_2k2;
+    const float* p1r = f->p1_re.data(); const float* p1i = f->p1_im.data();
+    const float* d1r = f->d1_re.data(); const float* d1i = f->d1_im.data();
+    const float* p2r = f->p2_re.data(); const float* p2i = f->p2_im.data();
+    const float* d2r = f->d2_re.data(); const float* d2i = f->d2_im.data();
+    
+    for (int i = 0; i < GRID_POINTS; i++) {
+        float pr = p1r[i] + p2r[i] * cr - p2i[i] * ci;
+        float pi = p1i[i] + p2r[i] * ci + p2i[i] * cr;
+        float dr = d1r[i] + d2r[i] * cr - d2i[i] * ci;
+        float di = d1i[i] + d2r[i] * ci + d2i[i] * cr;
+        u[i] = (pr * pr + pi * pi) * (1.0f / 3.0f) - (dr * dr + di * di) * inv_2k2;
+    }
+}
+
+/**
+ * Local minimum of u closest to grid index `near`
+ */
+static int nearest_trap(const float* u, int near) {
+    int best = -1;
+    for (int i = 1; i < GRID_POINTS - 1; i++) {
+        if (u[i] < u[i - 1] && u[i] <= u[i + 1]) {
+            if (best < 0 || abs(i - near) < abs(best - near)) {
+                best = i;
+            }
+        }
+    }
+    return best;
+}
+
+static bool solve(const model_config_t* cfg, position_map_t* map) {
+    field_terms_t f;
+    build_field_terms(cfg, &f);
+    
+    std::vector<float> u(GRID_POINTS);
+    std::vector<float> trap_mm(PHASE_POINTS + 1);
+    
+    // Follow the trap nearest the chamber centre through one full turn
+    int index = GRID_POINTS / 2;
+    for (int p = 0; p <= PHASE_POINTS; p++) {
+        gorkov_potential(&f, 2.0f * (float)M_PI * p / PHASE_POINTS, u.data());
+        index = nearest_trap(u.data(), index);
+        if (index < 0) {
+            return false;
+        }
+        // Sub-grid refinement: vertex of the parabola through the minimum
+        float y0 = u[index - 1], y1 = u[index], y2 = u[index + 1];
+        float denom = y0 - 2.0f * y1 + y2;
+        float offset = denom > 0.0f ? 0.5f * (y0 - y2) / denom : 0.0f;
+        trap_mm[p] = f.z_mm[index] + offset * (f.z_mm[1] - f.z_mm[0]);
+    }
+    
+    // Orient so position increases with table index
+    float sign = trap_mm[PHASE_POINTS] >= trap_mm[0] ? 1.0f : -1.0f;
+    for (int p = 1; p <= PHASE_POINTS; p++) {
+        // Enforce monotonicity against solver noise at the grid scale
+        if (sign * (trap_mm[p] - trap_mm[p - 1]) < 0.0f) {
+            trap_mm[p] = trap_mm[p - 1];
+        }
+    }
+    
+    map->min_mm = sign > 0 ? trap_mm[0] : trap_mm[PHASE_POINTS];
+    map->max_mm = sign > 0 ? trap_mm[PHASE_POINTS] : trap_mm[0];
+    map->phase_turns.resize(cfg->entries);
+    
+    // Invert position(phase) at evenly spaced positions
+    int p = 0;
+    for (int e = 0; e < cfg->entries; e++) {
+        float target = map->min_mm + (map->max_mm - map->min_mm) * e / (cfg->entries - 1);
+        int q = sign > 0 ? p : PHASE_POINTS - p;
+        while (p < PHASE_POINTS) {
+            int next = sign > 0 ? p + 1 : PHASE_POINTS - p - 1;
+            if (sign * (trap_mm[next] - target) >= 0.0f) break;
+            p++;
+            q = next;
+        }
+        int next = sign > 0 ? q + 1 : q - 1;
+        if (next < 0) next = 0;
+        if (next > PHASE_POINTS) next = PHASE_POINTS;
+        float span = trap_mm[next] - trap_mm[q];
+        float t = span != 0.0f ? (target - trap_mm[q]) / span : 0.0f;
+        if (t < 0.0f) t = 0.0f;
+        if (t > 1.0f) t = 1.0f;
+        double phase_deg = 360.0 * (q + t * (next - q)) / PHASE_POINTS;
+        map->phase_turns[e] = phase_from_degrees(phase_deg).turns;
+    }
+    return true;
+}
+
+static void write_header(FILE* out, const model_config_t* cfg, const position_map_t* map) {
+    fprintf(out, "#ifndef POSITION_MAP_TABLE_H\n#define POSITION_MAP_TABLE_H\n\n");
+    fprintf(out, "// Generated by tools/position_map_gen.cpp, do not edit\n");
+    fprintf(out, "// --frequency %.0f --spacing-mm %.2f --aperture-mm %.2f --entries %d\n\n",
+            cfg->frequency_hz, cfg->spacing_mm, cfg->aperture_mm, cfg->entries);
+    fprintf(out, "#include <stdint.h>\n\n");
+    fprintf(out, "#define POSITION_MAP_FREQUENCY_HZ   %.0f\n", cfg->frequency_hz);
+    fprintf(out, "#define POSITION_MAP_ENTRIES        %d\n", cfg->entries);
+    fprintf(out, "#define POSITION_MAP_MIN_MM         %.4ff\n", map->min_mm);
+    fprintf(out, "#define POSITION_MAP_MAX_MM         %.4ff\n\n", map->max_mm);
+    fprintf(out, "// Phase (turns, 2^32 = 360°) for evenly spaced trap positions MIN..MAX\n");
+    fprintf(out, "static const uint32_t POSITION_MAP_PHASE[POSITION_MAP_ENTRIES] = {");
+    for (int e = 0; e < cfg->entries; e++) {
+        fprintf(out, "%s0x%08lx%s", (e % 6) ? " " : "\n    ",
+                (unsigned long)map->phase_turns[e], e + 1 < cfg->entries ? "," : "");
+    }
+    fprintf(out, "\n};\n\n#endif // POSITION_MAP_TABLE_H\n");
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: position_map_gen [--frequency HZ] [--spacing-mm D] [--aperture-mm A]\n"
+            "                        [--entries N] [--out FILE] [--sweep F0:F1:STEP]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    model_config_t cfg;
+    cfg.frequency_hz = 40000.0f;
+    cfg.spacing_mm = 50.0f;
+    cfg.aperture_mm = 8.0f;
+    cfg.entries = 64;
+    const char* out_path = nullptr;
+    const char* sweep = nullptr;
+    
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage();
+        if (!strcmp(argv[i], "--frequency")) cfg.frequency_hz = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--spacing-mm")) cfg.spacing_mm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--aperture-mm")) cfg.aperture_mm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--entries")) cfg.entries = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out")) out_path = argv[++i];
+        else if (!strcmp(argv[i], "--sweep")) sweep = argv[++i];
+        else usage();
+    }
+    if (cfg.entries < 2) usage();
+    
+    position_map_t map;
+    
+    if (sweep) {
+        float f0, f1, step;
+        if (sscanf(sweep, "%f:%f:%f", &f0, &f1, &step) != 3 || step <= 0.0f) usage();
+        
+        auto t0 = std::chrono::steady_clock::now();
+        int count = 0;
+        printf("frequency_hz,min_mm,max_mm\n");
+        for (float f = f0; f <= f1 + 0.5f * step; f += step) {
+            cfg.frequency_hz = f;
+            if (!solve(&cfg, &map)) {
+                fprintf(stderr, "no trap found at %.0f Hz\n", f);
+                return 1;
+            }
+            printf("%.0f,%.4f,%.4f\n", f, map.min_mm, map.max_mm);
+            count++;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        fprintf(stderr, "%d tables in %.1f ms (%.2f ms/table)\n", count, ms, ms / count);
+        return 0;
+    }
+    
+    if (!solve(&cfg, &map)) {
+        fprintf(stderr, "no trap found\n");
+        return 1;
+    }
+    
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        perror(out_path);
+        return 1;
+    }
+    write_header(out, &cfg, &map);
+    if (out != stdout) fclose(out);
+    
+    fprintf(stderr, "trap range %.3f .. %.3f mm\n", map.min_mm, map.max_mm);
+    return 0;
+}
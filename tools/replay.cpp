@@ -0,0 +1,358 @@
+/**
+ * Offline replay of an input capture exported from GET /record
+ *
+ * Feeds the recorded setpoint stream through the same sample synthesis the
+ * DAC ISR uses (src/dac_synth.h), so channel 2 is bit-identical to what
+ * the dac_isr backend emitted, and reports input timing. Channel 1 comes
+ * from the CW generator on the device, which runs from the RTC clock at
+ * its own fstep-quantized frequency (src/cw_fstep.h); like the scope, it
+ * is modelled as an ideal sine at that frequency, starting in phase with
+ * the carrier, so it slips against channel 2 as the real output does.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -I src -o replay tools/replay.cpp
+ *   (add -DDAC_PREDISTORT if the firmware was built with it)
+ *
+ * Usage:
+ *   replay record.bin [--session N] --events
+ *       Timeline of inputs with inter-arrival times and a rate summary
+ *   replay record.bin [--session N] --waveform out.csv [--from US] [--to US]
+ *       Per-sample CSV (t_us, ch1, ch2, phase_deg, frequency_hz) of the
+ *       window [from, to) relative to the start of the session. Frequency
+ *       and sample-rate changes switch at the next carrier period boundary,
+ *       as on the device; each switch is reported on stderr with its
+ *       latency and the gap from the last sample on the old clock to the
+ *       first sample on the new one.
+ *
+ * Sessions are separated by reset markers; the default is the last one
+ * (the boot that was exported), use --session -2 for the boot before it.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "cw_fstep.h"
+#include "dac_synth.h"
+#include "input_recorder.h"
+#include "scope_frame.h"
+
+static const char* source_name(uint8_t source) {
+    switch (source) {
+        case INPUT_SOURCE_BOOT: return "boot";
+        case INPUT_SOURCE_HTTP: return "http";
+        case INPUT_SOURCE_SERIAL: return "serial";
+        case INPUT_SOURCE_UDP: return "udp";
+        case INPUT_SOURCE_SYNC: return "sync";
+        default: return "?";
+    }
+}
+
+static const char* kind_name(uint8_t kind) {
+    switch (kind) {
+        case INPUT_KIND_RESET: return "reset";
+        case INPUT_KIND_PHASE: return "phase";
+        case INPUT_KIND_FREQUENCY: return "frequency";
+        case INPUT_KIND_START: return "start";
+        case INPUT_KIND_STOP: return "stop";
+        case INPUT_KIND_SAMPLE_RATE: return "rate";
+        default: return "?";
+    }
+}
+
+static bool load(const char* path, std::vector<input_record_t>* records) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    input_export_header_t header;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              header.magic == INPUT_RECORDER_MAGIC &&
+              header.version == INPUT_RECORDER_VERSION &&
+              header.record_size == sizeof(input_record_t);
+    if (ok) {
+        records->resize(header.count);
+        ok = fread(records->data(), sizeof(input_record_t), header.count, f) == header.count;
+        if (header.total > header.count) {
+            fprintf(stderr, "note: %u older records were overwritten on the device\n",
+                    (unsigned)(header.total - header.count));
+        }
+        // Filler for records overwritten during the export carries no input
+        size_t kept = 0;
+        for (size_t i = 0; i < records->size(); i++) {
+            if ((*records)[i].kind != INPUT_KIND_PAD) (*records)[kept++] = (*records)[i];
+        }
+        if (kept < records->size()) {
+            fprintf(stderr, "note: %u records were overwritten during the export and skipped\n",
+                    (unsigned)(records->size() - kept));
+            records->resize(kept);
+        }
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s: not a valid capture\n", path);
+    return ok;
+}
+
+/**
+ * Slice [begin, end) of the requested session; negative N counts from the end
+ */
+static bool select_session(const std::vector<input_record_t>& all, int session,
+                           size_t* begin, size_t* end) {
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < all.size(); i++) {
+        if (all[i].kind == INPUT_KIND_RESET) starts.push_back(i);
+    }
+    // Capture may start mid-session if the ring wrapped
+    if (starts.empty() || starts[0] != 0) starts.insert(starts.begin(), 0);
+    
+    int n = (int)starts.size();
+    int index = session < 0 ? n + session : session;
+    if (index < 0 || index >= n) {
+        fprintf(stderr, "session %d out of range (%d sessions)\n", session, n);
+        return false;
+    }
+    *begin = starts[index];
+    *end = index + 1 < n ? starts[index + 1] : all.size();
+    return true;
+}
+
+static void print_events(const input_record_t* rec, size_t count) {
+    printf("%12s %10s %-7s %-10s %s\n", "t_us", "dt_us", "source", "kind", "value");
+    uint32_t t0 = count ? rec[0].timestamp_us : 0;
+    uint32_t prev = t0;
+    uint32_t min_dt = UINT32_MAX, max_dt = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        // Unsigned deltas stay correct across the 71 minute micros() wrap
+        uint32_t t = rec[i].timestamp_us - t0;
+        uint32_t dt = rec[i].timestamp_us - prev;
+        prev = rec[i].timestamp_us;
+        if (i > 0) {
+            if (dt < min_dt) min_dt = dt;
+            if (dt > max_dt) max_dt = dt;
+        }
+        
+        printf("%12u %10u %-7s %-10s ", (unsigned)t, (unsigned)dt,
+               source_name(rec[i].source), kind_name(rec[i].kind));
+        if (rec[i].kind == INPUT_KIND_PHASE) {
+            printf("%.2f deg\n", phase_to_degrees(phase_from_turns(rec[i].value)));
+        } else if (rec[i].kind == INPUT_KIND_FREQUENCY || rec[i].kind == INPUT_KIND_SAMPLE_RATE) {
+            printf("%u Hz\n", (unsigned)rec[i].value);
+        } else {
+            printf("%u\n", (unsigned)rec[i].value);
+        }
+    }
+    
+    if (count > 1) {
+        double span_s = (rec[count - 1].timestamp_us - t0) / 1e6;
+        printf("\n%zu inputs over %.3f s (%.1f/s), inter-arrival min %u us, max %u us\n",
+               count, span_s, span_s > 0 ? (count - 1) / span_s : 0.0,
+               (unsigned)min_dt, (unsigned)max_dt);
+    }
+}
+
+/**
+ * Sample clock change waiting for the next carrier period boundary
+ */
+typedef struct {
+    bool pending;
+    float frequency;
+    uint32_t sample_rate;
+    double requested_us;
+} staged_clock_t;
+
+/**
+ * Channel 1 model advance per sample: the CW generator's real frequency
+ */
+static uint32_t cw_increment(float frequency, uint32_t sample_rate) {
+    return phase_increment(cw_fstep_frequency(cw_fstep(frequency)), sample_rate);
+}
+
+/**
+ * Step the synthesizer sample by sample, applying inputs at their timestamps
+ */
+static void replay_waveform(const input_record_t* rec, size_t count, FILE* out,
+                            uint64_t from_us, uint64_t to_us) {
+    uint8_t lut[DAC_SYNTH_LUT_SIZE];
+    dac_synth_build_lut(lut);
+    
+    float frequency = 40000.0f;
+    uint32_t sample_rate = 0;
+    uint32_t accumulator = 0;
+    uint32_t increment = 0;
+    uint32_t offset = 0;
+    uint32_t ch1_accumulator = 0;
+    uint32_t ch1_increment = 0;
+    bool running = false;
+    staged_clock_t staged = {false, 0.0f, 0, 0.0};
+    // A switch is reported at the first sample on the new clock, with the
+    // interval measured since the last sample on the old one, as the ISR does
+    bool measure_gap = false;
+    double last_sample_us = 0.0;
+    double switch_us = 0.0;
+    double switch_latency_us = 0.0;
+    uint32_t old_rate = 0;
+    
+    fprintf(out, "t_us,ch1,ch2,phase_deg,frequency_hz\n");
+    
+    if (count == 0) return;
+    uint32_t t0 = rec[0].timestamp_us;
+    // Without --to, stop one millisecond after the last input
+    double end_us = to_us != UINT64_MAX ? (double)to_us
+                                        : (uint32_t)(rec[count - 1].timestamp_us - t0) + 1000.0;
+    // Time is accumulated per sample because the sample period can change
+    double now_us = 0.0;
+    size_t next = 0;
+    
+    while (true) {
+        // Sample clock only exists once the first frequency is known;
+        // until then inputs are applied in order without advancing time
+        if (now_us >= end_us) break;
+        
+        while (next < count &&
+               (!sample_rate || (uint32_t)(rec[next].timestamp_us - t0) <= now_us)) {
+            const input_record_t* r = &rec[next++];
+            switch (r->kind) {
+                case INPUT_KIND_SAMPLE_RATE:
+                    // Rate calibrated on the device; older captures lack it
+                    if (!r->value) break;
+                    if (!increment) {
+                        sample_rate = r->value;
+                    } else {
+                        if (!staged.pending) staged.frequency = frequency;
+                        staged.sample_rate = r->value;
+                        staged.requested_us = (uint32_t)(r->timestamp_us - t0);
+                        staged.pending = true;
+                    }
+                    break;
+                case INPUT_KIND_FREQUENCY:
+                    if (!increment) {
+                        // First frequency: the carrier starts here
+                        frequency = (float)r->value;
+                        if (!sample_rate) sample_rate = dac_synth_sample_rate(frequency);
+                        increment = phase_increment(frequency, sample_rate);
+                        ch1_increment = cw_increment(frequency, sample_rate);
+                    } else {
+                        if (!staged.pending) staged.sample_rate = sample_rate;
+                        staged.frequency = (float)r->value;
+                        // The CW generator takes its new fstep at once, on the old sample clock
+                        ch1_increment = cw_increment(staged.frequency, sample_rate);
+                        staged.requested_us = (uint32_t)(r->timestamp_us - t0);
+                        staged.pending = true;
+                    }
+                    break;
+                case INPUT_KIND_PHASE:
+                    offset = r->value;
+                    break;
+                case INPUT_KIND_START:
+                    running = true;
+                    break;
+                case INPUT_KIND_STOP:
+                    running = false;
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (!sample_rate) {
+            fprintf(stderr, "capture has no frequency input, nothing to synthesize\n");
+            return;
+        }
+        if (staged.pending && !running) {
+            // Stopped output has no boundary to wait for
+            frequency = staged.frequency;
+            sample_rate = staged.sample_rate;
+            increment = phase_increment(frequency, sample_rate);
+            ch1_increment = cw_increment(frequency, sample_rate);
+            staged.pending = false;
+        }
+        
+        if (running) {
+            if (measure_gap) {
+                fprintf(stderr, "t=%.2f us: reconfigured to %.0f Hz @ %u S/s (was %u S/s), "
+                                "latency %.2f us, gap %.2f us\n",
+                        switch_us, frequency, (unsigned)sample_rate, (unsigned)old_rate,
+                        switch_latency_us, now_us - last_sample_us);
+                measure_gap = false;
+            }
+            last_sample_us = now_us;
+        }
+        
+        if (now_us >= from_us) {
+            // Channel 1: CW generator model; channel 2: the ISR's synthesis with the offset
+            uint8_t ch1 = running ? scope_model_sine(ch1_accumulator) : 0;
+            uint8_t ch2 = running ? dac_synth_sample(lut, accumulator, offset) : 0;
+            fprintf(out, "%.2f,%u,%u,%.2f,%.0f\n", now_us, ch1, ch2,
+                    phase_to_degrees(phase_from_turns(offset)), frequency);
+        }
+        
+        if (running) ch1_accumulator += ch1_increment;
+        if (running && dac_synth_advance(&accumulator, increment) && staged.pending) {
+            // Period boundary: the next sample interval is the new one
+            old_rate = sample_rate;
+            frequency = staged.frequency;
+            sample_rate = staged.sample_rate;
+            increment = phase_increment(frequency, sample_rate);
+            ch1_increment = cw_increment(frequency, sample_rate);
+            staged.pending = false;
+            switch_us = now_us;
+            switch_latency_us = now_us - staged.requested_us;
+            measure_gap = true;
+        }
+        now_us += 1e6 / sample_rate;
+    }
+    if (measure_gap) {
+        fprintf(stderr, "t=%.2f us: reconfigured to %.0f Hz @ %u S/s (was %u S/s), "
+                        "latency %.2f us, gap not reached before the end\n",
+                switch_us, frequency, (unsigned)sample_rate, (unsigned)old_rate, switch_latency_us);
+    }
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: replay CAPTURE [--session N] (--events | --waveform OUT.csv [--from US] [--to US])\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) usage();
+    const char* capture = argv[1];
+    int session = -1;
+    bool events = false;
+    const char* waveform = nullptr;
+    uint64_t from_us = 0, to_us = UINT64_MAX;
+    
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--events")) events = true;
+        else if (i + 1 >= argc) usage();
+        else if (!strcmp(argv[i], "--session")) session = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--waveform")) waveform = argv[++i];
+        else if (!strcmp(argv[i], "--from")) from_us = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--to")) to_us = strtoull(argv[++i], nullptr, 10);
+        else usage();
+    }
+    if (!events && !waveform) usage();
+    
+    std::vector<input_record_t> records;
+    if (!load(capture, &records)) return 1;
+    
+    size_t begin, end;
+    if (!select_session(records, session, &begin, &end)) return 1;
+    const input_record_t* rec = records.data() + begin;
+    size_t count = end - begin;
+    
+    if (events) {
+        print_events(rec, count);
+    }
+    if (waveform) {
+        FILE* out = fopen(waveform, "w");
+        if (!out) {
+            perror(waveform);
+            return 1;
+        }
+        replay_waveform(rec, count, out, from_us, to_us);
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,714 @@
+/**
+ * Multi-rig sync simulator over loopback
+ *
+ * Runs one master and several follower rigs as threads on one Linux host,
+ * each with its own UDP socket on 127.0.0.1, a local clock with its own
+ * offset and crystal error, and a 40 kHz carrier derived from that clock.
+ * The protocol and servo are the firmware's (src/rig_sync_core.cpp); the
+ * node loop mirrors src/rig_sync.cpp. Every datagram passes through a
+ * delay line that adds a base delay, exponential jitter (Wi-Fi queueing),
+ * optional asymmetry and loss.
+ *
+ * Once a second it prints, per follower, its state (P: carrier phase
+ * disciplined, L: locked, rate trim and moves only, -: not locked), the
+ * true error of its master clock estimate, its rate error against the
+ * true crystal ratio and the carrier phase error against the master at
+ * the same true instant. Carrier phase is only corrected while the
+ * expected clock error is under RIG_SYNC_CARRIER_MAX_DEG of carrier
+ * (about 2 us at 40 kHz); until then a follower's carrier runs at the
+ * master's rate with an arbitrary phase offset, and the summary says so.
+ *
+ * The master schedules a coordinated move every --move-every seconds.
+ * Each rig records the true instant its clock estimate put the move at
+ * and when its thread really woke to apply it, and the spread of both
+ * against the master is reported; the second adds host wake-up latency
+ * that an esp_timer one-shot does not have.
+ *
+ * --outage-at takes the master off the air for --outage-ms: requests go
+ * unanswered and followers coast on their last fit. With --restart the
+ * master comes back rebooted, with a new clock, carrier phase and move
+ * ids, and every follower has to notice the step, drop its window and
+ * lock again. The summary reports when each one recovered, i.e. was
+ * locked again with its clock error back under RIG_SYNC_STEP_US.
+ *
+ * Timestamps are taken in the receiving thread after it wakes, like
+ * lwIP software timestamps, so on a loaded or single-CPU host they carry
+ * the scheduler's latency. --hw-timestamps stamps each datagram at the
+ * instant the delay line delivers it instead, as a driver or MAC
+ * timestamp would; only the modelled delay and jitter remain.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -pthread -I src -o rig_sync_sim tools/rig_sync_sim.cpp \
+ *       src/rig_sync_core.cpp
+ *
+ * Usage:
+ *   rig_sync_sim [--nodes N] [--seconds S] [--interval-ms MS]
+ *                [--delay-us US] [--jitter-us US] [--asymmetry-us US]
+ *                [--loss P] [--drift-ppm PPM] [--readout-us US]
+ *                [--move-every S] [--lead-ms MS] [--port P] [--seed N]
+ *                [--hw-timestamps] [--outage-at S] [--outage-ms MS] [--restart]
+ *
+ * --drift-ppm spreads the crystals over ±PPM; --readout-us models reading
+ * the carrier with one sample period of uncertainty (5 us at 200 kS/s).
+ * Exits non-zero if a follower is not locked at the end, or has not
+ * recovered from the outage.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+#include "rig_sync_core.h"
+
+#define CARRIER_HZ      40000.0
+#define MAX_NODES       16
+#define MAX_MOVES       64
+
+typedef struct {
+    int nodes;
+    double seconds;
+    int interval_ms;
+    double delay_us;
+    double jitter_us;
+    double asymmetry_us;        // Added to follower -> master only
+    double loss;
+    double drift_ppm;
+    double readout_us;
+    double move_every_s;
+    int lead_ms;
+    int port;
+    unsigned seed;
+    bool hw_timestamps;
+    double outage_at_s;         // 0 = no outage
+    int outage_ms;
+    bool restart;               // Master reboots at the end of the outage
+} sim_config_t;
+
+static sim_config_t g_cfg;
+static std::atomic<bool> g_stop(false);
+static int64_t g_t0;
+
+static int64_t true_now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_until_true(int64_t true_us) {
+    struct timespec ts;
+    ts.tv_sec = true_us / 1000000;
+    ts.tv_nsec = (true_us % 1000000) * 1000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+}
+
+// ===== Delay line =====
+
+/**
+ * What goes over loopback: the datagram and the true instant the delay
+ * line delivered it, for --hw-timestamps
+ */
+typedef struct __attribute__((packed)) {
+    rig_sync_msg_t msg;
+    int64_t delivered_true_us;
+} sim_datagram_t;
+
+typedef struct {
+    int64_t release_us;
+    int fd;
+    struct sockaddr_in to;
+    rig_sync_msg_t msg;
+} pending_datagram_t;
+
+struct Later {
+    bool operator()(const pending_datagram_t& a, const pending_datagram_t& b) const {
+        return a.release_us > b.release_us;
+    }
+};
+
+static std::mutex g_line_mutex;
+static std::condition_variable g_line_cv;
+static std::priority_queue<pending_datagram_t, std::vector<pending_datagram_t>, Later> g_line;
+static std::mt19937 g_rng;
+
+static void delayed_send(int fd, const rig_sync_msg_t* msg, uint16_t to_port, bool upstream) {
+    std::lock_guard<std::mutex> guard(g_line_mutex);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    if (uniform(g_rng) < g_cfg.loss) return;
+
+    std::exponential_distribution<double> jitter(g_cfg.jitter_us > 0 ? 1.0 / g_cfg.jitter_us : 1.0);
+    double delay = g_cfg.delay_us + (g_cfg.jitter_us > 0 ? jitter(g_rng) : 0.0);
+    if (upstream) delay += g_cfg.asymmetry_us;
+
+    pending_datagram_t d;
+    d.release_us = true_now_us() + (int64_t)delay;
+    d.fd = fd;
+    memset(&d.to, 0, sizeof(d.to));
+    d.to.sin_family = AF_INET;
+    d.to.sin_port = htons(to_port);
+    d.to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    d.msg = *msg;
+    g_line.push(d);
+    g_line_cv.notify_one();
+}
+
+static void delay_line_thread() {
+    std::unique_lock<std::mutex> lock(g_line_mutex);
+    while (!g_stop) {
+        if (g_line.empty()) {
+            g_line_cv.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+        int64_t release = g_line.top().release_us;
+        if (release > true_now_us()) {
+            lock.unlock();
+            sleep_until_true(release);
+            lock.lock();
+            continue;
+        }
+        pending_datagram_t d = g_line.top();
+        g_line.pop();
+        sim_datagram_t out;
+        out.msg = d.msg;
+        // The modelled arrival, not when this thread got round to it
+        out.delivered_true_us = d.release_us;
+        sendto(d.fd, &out, sizeof(out), 0, (struct sockaddr*)&d.to, sizeof(d.to));
+    }
+}
+
+// ===== Simulated rig =====
+
+/**
+ * Receive one datagram
+ * @param rx_true_us True receive instant: delivery with --hw-timestamps,
+ *                   otherwise when this thread got it
+ * @return Length of the rig_sync_msg_t part, or -1
+ */
+static int sim_recv(int fd, rig_sync_msg_t* msg, struct sockaddr_in* from, int64_t* rx_true_us) {
+    sim_datagram_t in;
+    socklen_t from_len = sizeof(*from);
+    int len = recvfrom(fd, &in, sizeof(in), 0, (struct sockaddr*)from, &from_len);
+    *rx_true_us = true_now_us();
+    if (len != (int)sizeof(in)) return -1;
+    *msg = in.msg;
+    if (g_cfg.hw_timestamps) *rx_true_us = in.delivered_true_us;
+    return (int)sizeof(in.msg);
+}
+
+/**
+ * Local clock and carrier of one rig. The carrier is generated from the
+ * local clock like the DAC ISR's accumulator from the crystal, so it runs
+ * off by the same ppm; trim_ppb and offset_turns are what the firmware
+ * feeds to levitation_trim_carrier().
+ */
+class SimRig {
+public:
+    void init(int64_t t0, double offset_us, double drift_ppm) {
+        true_t0_ = t0;
+        offset_us_ = offset_us;
+        drift_ = drift_ppm * 1e-6;
+        carrier_local_us_ = local_us();
+        carrier_cycles_ = 0.0;
+        trim_ppb_ = 0.0;
+        offset_turns_ = 0;
+    }
+
+    /**
+     * Power-cycle: the clock restarts at 0 and the carrier at an arbitrary
+     * phase; the crystal stays the same
+     */
+    void reboot(int64_t true_us, double carrier_fraction) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        true_t0_ = true_us;
+        offset_us_ = 0.0;
+        carrier_local_us_ = 0;
+        carrier_cycles_ = carrier_fraction;
+        trim_ppb_ = 0.0;
+        offset_turns_ = 0;
+    }
+
+    int64_t local_at(int64_t true_us) const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return (int64_t)llround(offset_us_ + (double)(true_us - true_t0_) * (1.0 + drift_));
+    }
+
+    int64_t true_at(int64_t local) const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return true_t0_ + (int64_t)llround(((double)local - offset_us_) / (1.0 + drift_));
+    }
+
+    int64_t local_us() const {
+        return local_at(true_now_us());
+    }
+
+    double rate() const {
+        return 1.0 + drift_;
+    }
+
+    uint32_t carrier_at_local(int64_t local) const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        double cycles = carrier_cycles_ +
+                        CARRIER_HZ * (1.0 + trim_ppb_ * 1e-9) * (double)(local - carrier_local_us_) * 1e-6;
+        return (uint32_t)(int64_t)((cycles - floor(cycles)) * 4294967296.0) + offset_turns_;
+    }
+
+    /**
+     * Read the carrier the way the firmware does, with sample-clock uncertainty
+     */
+    void read_carrier(uint32_t* turns, int64_t* local, std::mt19937* rng) const {
+        *local = local_us();
+        std::uniform_real_distribution<double> readout(-g_cfg.readout_us, 0.0);
+        *turns = carrier_at_local(*local + (int64_t)readout(*rng));
+    }
+
+    void trim(double rate_ppb, int32_t nudge_turns) {
+        int64_t now = local_us();
+        std::lock_guard<std::mutex> guard(mutex_);
+        // Rebase so the trim only changes the carrier from now on
+        carrier_cycles_ += CARRIER_HZ * (1.0 + trim_ppb_ * 1e-9) * (double)(now - carrier_local_us_) * 1e-6;
+        carrier_local_us_ = now;
+        trim_ppb_ = rate_ppb;
+        offset_turns_ += (uint32_t)nudge_turns;
+    }
+
+private:
+    int64_t true_t0_;
+    double offset_us_;
+    double drift_;
+    mutable std::mutex mutex_;
+    int64_t carrier_local_us_;
+    double carrier_cycles_;
+    double trim_ppb_;
+    uint32_t offset_turns_;
+};
+
+typedef struct {
+    int id;
+    int fd;
+    SimRig rig;
+    rig_sync_servo_t servo;
+    std::mutex servo_mutex;
+    uint32_t last_move_id;
+    std::mutex move_mutex;
+    std::condition_variable move_cv;
+    uint32_t move_id;           // Pending move, by record slot (move_slot())
+    int64_t move_local_us;      // ... on the local clock; 0 = none
+    int64_t applied_true_us[MAX_MOVES];    // By slot, thread woke; 0 = not applied
+    int64_t scheduled_true_us[MAX_MOVES];  // By slot, instant the clock estimate chose
+    uint32_t joined_late;       // Moves already due when first seen, applied at once
+    uint32_t aligned;           // Exchanges with the clock fine enough to correct carrier phase
+    bool ever_aligned;
+} sim_node_t;
+
+static sim_node_t g_nodes[MAX_NODES];
+
+// Master-side move state
+static std::mutex g_move_mutex;
+static uint32_t g_move_id = 0;
+static int64_t g_move_at_us = 0;
+// Moves before the master's last reboot; ids restart at 1 after one
+static std::atomic<uint32_t> g_move_base(0);
+
+/**
+ * Record slot of a move: its id plus the moves of earlier master boots
+ */
+static uint32_t move_slot(uint32_t move_id) {
+    return g_move_base + move_id;
+}
+
+static int open_socket(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        exit(1);
+    }
+    struct timeval timeout = {0, 20000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static void schedule_move(sim_node_t* node, uint32_t id, int64_t local_us) {
+    std::lock_guard<std::mutex> guard(node->move_mutex);
+    node->move_id = id;
+    node->move_local_us = local_us;
+    node->move_cv.notify_one();
+}
+
+/**
+ * Applies moves on time, like the firmware's esp_timer one-shot
+ */
+static void move_thread(sim_node_t* node) {
+    std::unique_lock<std::mutex> lock(node->move_mutex);
+    while (!g_stop) {
+        if (!node->move_local_us) {
+            node->move_cv.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+        uint32_t id = node->move_id;
+        int64_t due = node->rig.true_at(node->move_local_us);
+        lock.unlock();
+        sleep_until_true(due);
+        lock.lock();
+        // Rescheduled while asleep: start over with the new deadline
+        if (node->move_id != id || node->rig.true_at(node->move_local_us) != due) continue;
+        if (id < MAX_MOVES) {
+            node->applied_true_us[id] = true_now_us();
+            node->scheduled_true_us[id] = due;
+        }
+        node->move_local_us = 0;
+    }
+}
+
+static void master_thread(sim_node_t* node) {
+    std::mt19937 rng(g_cfg.seed + 1000);
+    int64_t next_move = node->rig.local_us() + (int64_t)(g_cfg.move_every_s * 1e6);
+    int64_t outage_start = g_cfg.outage_at_s > 0 ? g_t0 + (int64_t)(g_cfg.outage_at_s * 1e6) : INT64_MAX;
+    int64_t outage_end = outage_start + g_cfg.outage_ms * 1000LL;
+    bool rebooted = false;
+
+    while (!g_stop) {
+        rig_sync_msg_t msg;
+        struct sockaddr_in from;
+        int64_t rx_true;
+        int len = sim_recv(node->fd, &msg, &from, &rx_true);
+        int64_t now = true_now_us();
+        if (now >= outage_start && now < outage_end) continue;  // Off the air
+        if (now >= outage_end && g_cfg.restart && !rebooted) {
+            // Back from a power cycle: new clock and carrier phase, move ids from 1,
+            // and a move that was pending is lost
+            rebooted = true;
+            std::uniform_real_distribution<double> phase(0.0, 1.0);
+            node->rig.reboot(outage_end, phase(rng));
+            {
+                std::lock_guard<std::mutex> guard(node->move_mutex);
+                node->move_local_us = 0;
+            }
+            std::lock_guard<std::mutex> guard(g_move_mutex);
+            g_move_base += g_move_id;
+            g_move_id = 0;
+            g_move_at_us = 0;
+            next_move = node->rig.local_us() + (int64_t)(g_cfg.move_every_s * 1e6);
+            continue;
+        }
+        int64_t t2 = node->rig.local_at(rx_true);
+
+        // Coordinated moves: scheduled on the master's own clock
+        {
+            std::lock_guard<std::mutex> guard(g_move_mutex);
+            if (t2 >= next_move) {
+                g_move_id++;
+                g_move_at_us = t2 + g_cfg.lead_ms * 1000;
+                schedule_move(node, move_slot(g_move_id), g_move_at_us);
+                next_move += (int64_t)(g_cfg.move_every_s * 1e6);
+            }
+        }
+
+        if (!rig_sync_msg_valid(&msg, len, RIG_SYNC_MSG_REQUEST)) continue;
+
+        rig_sync_msg_t resp;
+        rig_sync_msg_init(&resp, RIG_SYNC_MSG_RESPONSE, 0, msg.seq);
+        resp.t1_us = msg.t1_us;
+        resp.t2_us = t2;
+        uint32_t turns;
+        int64_t at;
+        node->rig.read_carrier(&turns, &at, &rng);
+        resp.anchor_us = at;
+        resp.anchor_turns = turns;
+        resp.frequency_mhz = (uint32_t)(CARRIER_HZ * 1000.0);
+        {
+            std::lock_guard<std::mutex> guard(g_move_mutex);
+            resp.move_id = g_move_id;
+            resp.move_at_us = g_move_at_us;
+        }
+        resp.t3_us = node->rig.local_us();
+        delayed_send(node->fd, &resp, ntohs(from.sin_port), false);
+    }
+}
+
+static void follower_thread(sim_node_t* node) {
+    std::mt19937 rng(g_cfg.seed + node->id);
+    uint32_t seq = 0;
+    int64_t next_poll = true_now_us();
+
+    while (!g_stop) {
+        // Request, then wait for the response or the next poll
+        rig_sync_msg_t req;
+        rig_sync_msg_init(&req, RIG_SYNC_MSG_REQUEST, (uint16_t)node->id, ++seq);
+        req.t1_us = node->rig.local_us();
+        delayed_send(node->fd, &req, (uint16_t)g_cfg.port, true);
+        next_poll += g_cfg.interval_ms * 1000;
+
+        while (!g_stop && true_now_us() < next_poll) {
+            rig_sync_msg_t resp;
+            struct sockaddr_in from;
+            int64_t rx_true;
+            int len = sim_recv(node->fd, &resp, &from, &rx_true);
+            int64_t t4 = node->rig.local_at(rx_true);
+            if (!rig_sync_msg_valid(&resp, len, RIG_SYNC_MSG_RESPONSE) || resp.seq != seq) continue;
+
+            std::lock_guard<std::mutex> guard(node->servo_mutex);
+            rig_sync_servo_update(&node->servo, resp.t1_us, resp.t2_us, resp.t3_us, t4);
+            if (!node->servo.valid) continue;
+
+            uint32_t turns;
+            int64_t at;
+            node->rig.read_carrier(&turns, &at, &rng);
+            node->rig.trim(node->servo.rate_ppb,
+                           rig_sync_carrier_correction(&node->servo, &resp, at, turns));
+            if (rig_sync_carrier_aligned(&node->servo, resp.frequency_mhz)) {
+                node->aligned++;
+                node->ever_aligned = true;
+            }
+
+            if (resp.move_id != node->last_move_id && node->servo.locked) {
+                node->last_move_id = resp.move_id;
+                int64_t at = rig_sync_to_local(&node->servo, resp.move_at_us);
+                if (at <= t4) {
+                    // Locked after the move was due: catch up now, like the firmware
+                    node->joined_late++;
+                    if (move_slot(resp.move_id) < MAX_MOVES) node->applied_true_us[move_slot(resp.move_id)] = -1;
+                    continue;
+                }
+                schedule_move(node, move_slot(resp.move_id), at);
+            }
+        }
+    }
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: rig_sync_sim [--nodes N] [--seconds S] [--interval-ms MS]\n"
+            "                    [--delay-us US] [--jitter-us US] [--asymmetry-us US]\n"
+            "                    [--loss P] [--drift-ppm PPM] [--readout-us US]\n"
+            "                    [--move-every S] [--lead-ms MS] [--port P] [--seed N]\n"
+            "                    [--hw-timestamps] [--outage-at S] [--outage-ms MS] [--restart]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    g_cfg.nodes = 4;
+    g_cfg.seconds = 20.0;
+    g_cfg.interval_ms = 125;
+    g_cfg.delay_us = 800.0;
+    g_cfg.jitter_us = 500.0;
+    g_cfg.asymmetry_us = 0.0;
+    g_cfg.loss = 0.02;
+    g_cfg.drift_ppm = 30.0;
+    g_cfg.readout_us = 5.0;
+    g_cfg.move_every_s = 2.0;
+    g_cfg.lead_ms = 250;
+    g_cfg.port = 42110;
+    g_cfg.seed = 1;
+    g_cfg.hw_timestamps = false;
+    g_cfg.outage_at_s = 0.0;
+    g_cfg.outage_ms = 3000;
+    g_cfg.restart = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--hw-timestamps")) {
+            g_cfg.hw_timestamps = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "--restart")) {
+            g_cfg.restart = true;
+            continue;
+        }
+        if (i + 1 >= argc) usage();
+        if (!strcmp(argv[i], "--nodes")) g_cfg.nodes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds")) g_cfg.seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--interval-ms")) g_cfg.interval_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--delay-us")) g_cfg.delay_us = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--jitter-us")) g_cfg.jitter_us = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--asymmetry-us")) g_cfg.asymmetry_us = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--loss")) g_cfg.loss = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--drift-ppm")) g_cfg.drift_ppm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--readout-us")) g_cfg.readout_us = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--move-every")) g_cfg.move_every_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--lead-ms")) g_cfg.lead_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--port")) g_cfg.port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed")) g_cfg.seed = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--outage-at")) g_cfg.outage_at_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--outage-ms")) g_cfg.outage_ms = atoi(argv[++i]);
+        else usage();
+    }
+    if (g_cfg.nodes < 2 || g_cfg.nodes > MAX_NODES || g_cfg.interval_ms <= 0 || g_cfg.outage_ms < 0) usage();
+    if (g_cfg.restart && g_cfg.outage_at_s <= 0) usage();
+    g_rng.seed(g_cfg.seed);
+
+    // Clocks: arbitrary boot offsets, crystals spread over ±drift
+    std::uniform_real_distribution<double> offsets(0.0, 5e6);
+    std::uniform_real_distribution<double> drifts(-g_cfg.drift_ppm, g_cfg.drift_ppm);
+    int64_t t0 = true_now_us();
+    g_t0 = t0;
+    for (int n = 0; n < g_cfg.nodes; n++) {
+        sim_node_t* node = &g_nodes[n];
+        node->id = n;
+        node->fd = open_socket((uint16_t)(g_cfg.port + n));
+        node->rig.init(t0, offsets(g_rng), n == 0 ? 0.0 : drifts(g_rng));
+        rig_sync_servo_init(&node->servo);
+        node->last_move_id = 0;
+        node->move_id = 0;
+        node->move_local_us = 0;
+        memset(node->applied_true_us, 0, sizeof(node->applied_true_us));
+        memset(node->scheduled_true_us, 0, sizeof(node->scheduled_true_us));
+        node->joined_late = 0;
+        node->aligned = 0;
+        node->ever_aligned = false;
+    }
+
+    printf("%d rigs, delay %.0f us + exp(%.0f us) jitter, asymmetry %.0f us, loss %.0f%%, "
+           "crystals ±%.0f ppm, poll %d ms, %s timestamps\n",
+           g_cfg.nodes, g_cfg.delay_us, g_cfg.jitter_us, g_cfg.asymmetry_us, 100.0 * g_cfg.loss,
+           g_cfg.drift_ppm, g_cfg.interval_ms, g_cfg.hw_timestamps ? "delivery" : "thread");
+    if (g_cfg.outage_at_s > 0) {
+        printf("master off the air at t=%.1fs for %d ms%s\n", g_cfg.outage_at_s, g_cfg.outage_ms,
+               g_cfg.restart ? ", then rebooted" : "");
+    }
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(delay_line_thread);
+    threads.emplace_back(master_thread, &g_nodes[0]);
+    for (int n = 1; n < g_cfg.nodes; n++) {
+        threads.emplace_back(follower_thread, &g_nodes[n]);
+    }
+    for (int n = 0; n < g_cfg.nodes; n++) {
+        threads.emplace_back(move_thread, &g_nodes[n]);
+    }
+
+    // Report the true errors once a second
+    double worst_clock = 0.0, worst_carrier = 0.0;
+    bool aligned_now[MAX_NODES] = {false};
+    // Outage recovery: first second the follower was locked with a sane clock again
+    int64_t outage_end = t0 + (int64_t)(g_cfg.outage_at_s * 1e6) + g_cfg.outage_ms * 1000LL;
+    int recovered_s[MAX_NODES] = {0};
+    uint32_t steps_before[MAX_NODES] = {0};
+    for (int s = 1; s <= (int)g_cfg.seconds; s++) {
+        sleep_until_true(t0 + (int64_t)s * 1000000);
+        int64_t now = true_now_us();
+        int64_t master_local = g_nodes[0].rig.local_at(now);
+        uint32_t master_carrier = g_nodes[0].rig.carrier_at_local(master_local);
+
+        printf("t=%2ds", s);
+        worst_clock = worst_carrier = 0.0;
+        for (int n = 1; n < g_cfg.nodes; n++) {
+            sim_node_t* node = &g_nodes[n];
+            int64_t local = node->rig.local_at(now);
+            std::lock_guard<std::mutex> guard(node->servo_mutex);
+            if (now < outage_end) steps_before[n] = node->servo.steps;
+            if (!node->servo.valid) {
+                printf("  rig%d --", n);
+                worst_clock = worst_carrier = INFINITY;
+                continue;
+            }
+            double clock_err = (double)(rig_sync_to_master(&node->servo, local) - master_local);
+            if (g_cfg.outage_at_s > 0 && now >= outage_end && !recovered_s[n] && node->servo.locked &&
+                fabs(clock_err) < RIG_SYNC_STEP_US) {
+                recovered_s[n] = s;
+            }
+            double true_ppb = (g_nodes[0].rig.rate() / node->rig.rate() - 1.0) * 1e9;
+            double rate_err = node->servo.rate_ppb - true_ppb;
+            int32_t diff = (int32_t)(node->rig.carrier_at_local(local) - master_carrier);
+            double carrier_deg = diff * (360.0 / 4294967296.0);
+            aligned_now[n] = rig_sync_carrier_aligned(&node->servo, (uint32_t)(CARRIER_HZ * 1000.0));
+            printf("  rig%d %s %+6.0fus %+7.0fppb %+6.1f°", n,
+                   aligned_now[n] ? "P" : node->servo.locked ? "L" : "-", clock_err, rate_err, carrier_deg);
+            if (fabs(clock_err) > worst_clock) worst_clock = fabs(clock_err);
+            if (fabs(carrier_deg) > worst_carrier) worst_carrier = fabs(carrier_deg);
+        }
+        printf("\n");
+    }
+    g_stop = true;
+    g_line_cv.notify_all();
+    for (int n = 0; n < g_cfg.nodes; n++) {
+        g_nodes[n].move_cv.notify_all();
+    }
+    for (auto& t : threads) t.join();
+
+    // Move spread: every rig against the master, over the moves all rigs applied
+    int locked = 0, aligned = 0, ever_aligned = 0;
+    uint32_t exchanges = 0, rejected = 0, joined_late = 0, aligned_exchanges = 0;
+    for (int n = 1; n < g_cfg.nodes; n++) {
+        locked += g_nodes[n].servo.locked;
+        aligned += aligned_now[n];
+        ever_aligned += g_nodes[n].ever_aligned;
+        exchanges += g_nodes[n].servo.exchanges;
+        rejected += g_nodes[n].servo.rejected;
+        joined_late += g_nodes[n].joined_late;
+        aligned_exchanges += g_nodes[n].aligned;
+    }
+    double spread_sum = 0.0, spread_max = 0.0;
+    double estimate_sum = 0.0, estimate_max = 0.0;
+    int spread_count = 0;
+    for (uint32_t m = 1; m < MAX_MOVES; m++) {
+        int64_t ref = g_nodes[0].applied_true_us[m];
+        int64_t ref_scheduled = g_nodes[0].scheduled_true_us[m];
+        double spread = 0.0, estimate = 0.0;
+        bool all = ref != 0;
+        for (int n = 1; n < g_cfg.nodes && all; n++) {
+            int64_t at = g_nodes[n].applied_true_us[m];
+            all = at > 0;
+            if (fabs((double)(at - ref)) > spread) spread = fabs((double)(at - ref));
+            double off = (double)(g_nodes[n].scheduled_true_us[m] - ref_scheduled);
+            if (fabs(off) > estimate) estimate = fabs(off);
+        }
+        if (!all) continue;
+        spread_sum += spread;
+        if (spread > spread_max) spread_max = spread;
+        estimate_sum += estimate;
+        if (estimate > estimate_max) estimate_max = estimate;
+        spread_count++;
+    }
+
+    printf("final: %d/%d followers locked, worst clock error %.0f us, worst carrier error %.1f° (last second)\n",
+           locked, g_cfg.nodes - 1, worst_clock, worst_carrier);
+    printf("exchanges: %u accepted, %u rejected by the delay filter\n", exchanges, rejected);
+    if (ever_aligned) {
+        printf("carrier phase: disciplined on %d/%d followers at the end, %d engaged at some point, "
+               "in %u of %u accepted exchanges\n",
+               aligned, g_cfg.nodes - 1, ever_aligned, aligned_exchanges, exchanges);
+    } else {
+        printf("carrier phase: NOT disciplined; no follower's clock estimate got under %d° of carrier, "
+               "so carriers are rate-trimmed only and their phase offsets are arbitrary\n",
+               RIG_SYNC_CARRIER_MAX_DEG);
+    }
+    if (spread_count) {
+        printf("moves: %d applied by every rig, apply time vs master mean %.0f us, worst %.0f us; "
+               "instants the clock estimates chose: mean %.0f us, worst %.0f us\n",
+               spread_count, spread_sum / spread_count, spread_max,
+               estimate_sum / spread_count, estimate_max);
+    }
+    if (joined_late) printf("moves: %u already due when a rig locked, applied at once\n", joined_late);
+
+    int recovered = 0;
+    if (g_cfg.outage_at_s > 0) {
+        printf("outage:");
+        for (int n = 1; n < g_cfg.nodes; n++) {
+            recovered += recovered_s[n] != 0;
+            if (recovered_s[n]) {
+                printf("  rig%d recovered at t=%ds", n, recovered_s[n]);
+            } else {
+                printf("  rig%d NOT recovered", n);
+            }
+            printf(" (%u steps)", g_nodes[n].servo.steps - steps_before[n]);
+        }
+        printf("\n");
+    }
+    bool ok = locked == g_cfg.nodes - 1 && (g_cfg.outage_at_s <= 0 || recovered == g_cfg.nodes - 1);
+    return ok ? 0 : 1;
+}
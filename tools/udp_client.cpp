@@ -0,0 +1,192 @@
+/**
+ * UDP control client and latency probe
+ *
+ * Streams setpoints to the levitator's UDP control port (src/udp_control.h)
+ * and reports the setpoint -> ack round trip, optionally against the HTTP
+ * /set_phase round trip for comparison. Loss and reordering can be
+ * injected on the sending side to check that the device drops stale
+ * setpoints instead of applying them late.
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -I src -o udp_client tools/udp_client.cpp
+ *
+ * Usage:
+ *   udp_client [--host IP] [--count N] [--interval-ms MS]
+ *              [--loss PCT] [--reorder PCT] [--http]
+ *
+ * The setpoints sweep the phase from 0° to 360° over the run.
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "udp_control.h"
+#include "phase_units.h"
+
+static double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void print_latency(const char* label, std::vector<double>& samples) {
+    if (samples.empty()) {
+        printf("%-5s no replies\n", label);
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    printf("%-5s n=%zu  min %.2f  p50 %.2f  p99 %.2f  max %.2f ms\n", label, n,
+           samples[0] / 1000, samples[n / 2] / 1000,
+           samples[std::min(n - 1, n * 99 / 100)] / 1000, samples[n - 1] / 1000);
+}
+
+/**
+ * Time one HTTP GET /set_phase (new connection each time, as the UI does)
+ * @return Round trip in µs, or a negative value on error
+ */
+static double http_set_phase(const char* host, float degrees) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct timeval tv = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(80);
+    inet_pton(AF_INET, host, &addr.sin_addr);
+    
+    char request[128];
+    int len = snprintf(request, sizeof(request),
+                       "GET /set_phase?deg=%.1f HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                       degrees, host);
+    
+    double start = now_us();
+    double result = -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+        send(fd, request, len, 0) == len) {
+        char reply[512];
+        if (recv(fd, reply, sizeof(reply), 0) > 0) {
+            result = now_us() - start;
+        }
+    }
+    close(fd);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const char* host = "192.168.4.1";
+    int count = 200;
+    int interval_ms = 20;
+    double loss_pct = 0;
+    double reorder_pct = 0;
+    bool compare_http = false;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--host") && i + 1 < argc) host = argv[++i];
+        else if (!strcmp(argv[i], "--count") && i + 1 < argc) count = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--interval-ms") && i + 1 < argc) interval_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--loss") && i + 1 < argc) loss_pct = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--reorder") && i + 1 < argc) reorder_pct = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--http")) compare_http = true;
+        else {
+            fprintf(stderr, "usage: %s [--host IP] [--count N] [--interval-ms MS] "
+                            "[--loss PCT] [--reorder PCT] [--http]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (count <= 0) count = 1;
+    srand((unsigned)time(nullptr));
+    
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(UDP_CONTROL_PORT);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "bad host %s\n", host);
+        return 1;
+    }
+    // Short timeout: a late ack is as useless as a lost one
+    struct timeval tv = {0, 1000 * (interval_ms > 0 ? interval_ms : 1)};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    uint32_t session = (uint32_t)rand() ^ (uint32_t)time(nullptr);
+    std::vector<double> sent_at(count + 1, 0);
+    std::vector<double> udp_latency;
+    std::vector<double> http_latency;
+    int lost = 0, applied = 0, stale = 0, held = 0;
+    udp_setpoint_t delayed;
+    bool have_delayed = false;
+    
+    for (int i = 1; i <= count; i++) {
+        udp_setpoint_t msg;
+        msg.magic = UDP_MAGIC;
+        msg.version = UDP_VERSION;
+        msg.type = UDP_MSG_SETPOINT;
+        msg.session = session;
+        msg.seq = (uint32_t)i;
+        msg.phase = phase_from_degrees(360.0 * i / count).turns;
+        msg.frequency_hz = 0;
+        
+        double roll = rand() * 100.0 / RAND_MAX;
+        sent_at[i] = now_us();
+        if (roll < loss_pct) {
+            lost++;
+        } else if (roll < loss_pct + reorder_pct && !have_delayed) {
+            // Hold it back and send it after the next one
+            delayed = msg;
+            have_delayed = true;
+            held++;
+        } else {
+            sendto(fd, &msg, sizeof(msg), 0, (struct sockaddr*)&addr, sizeof(addr));
+            if (have_delayed) {
+                sendto(fd, &delayed, sizeof(delayed), 0, (struct sockaddr*)&addr, sizeof(addr));
+                have_delayed = false;
+            }
+        }
+        
+        // Drain acks until the timeout
+        udp_setpoint_t ack;
+        while (recv(fd, &ack, sizeof(ack), 0) == (ssize_t)sizeof(ack)) {
+            if (ack.magic != UDP_MAGIC || ack.session != session ||
+                ack.seq == 0 || ack.seq > (uint32_t)count) {
+                continue;
+            }
+            if (ack.type == UDP_MSG_ACK_APPLIED) {
+                applied++;
+                udp_latency.push_back(now_us() - sent_at[ack.seq]);
+            } else if (ack.type == UDP_MSG_ACK_STALE) {
+                stale++;
+            }
+        }
+        
+        if (compare_http) {
+            double rtt = http_set_phase(host, (float)(360.0 * i / count));
+            if (rtt >= 0) http_latency.push_back(rtt);
+        }
+    }
+    close(fd);
+    
+    printf("sent %d  dropped %d  reordered %d  applied %d  stale %d\n",
+           count - lost, lost, held, applied, stale);
+    print_latency("udp", udp_latency);
+    if (compare_http) {
+        print_latency("http", http_latency);
+    }
+    return 0;
+}
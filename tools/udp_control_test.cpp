@@ -0,0 +1,409 @@
+/**
+ * UDP control port loopback test
+ *
+ * Runs src/udp_control.cpp in its own task on the tools/host stand-ins, as
+ * a device on 127.0.0.1, with the setpoint entry point faked so every
+ * setpoint it applies is logged. The test is the client:
+ *   - stale drop: streams setpoints with loss and reordering (a held-back
+ *     datagram goes out 1 to 3 datagrams late) and checks that exactly the
+ *     setpoints newer than everything before them are applied, in order,
+ *     and that the acks and counters agree
+ *   - takeover: a second controller takes the port over while the first
+ *     one's datagrams are still arriving; the first one's late datagrams
+ *     must be acked stale and never applied
+ *   - power save: the mode set before the first session comes back once
+ *     the port has been idle for UDP_SESSION_TIMEOUT_MS, and a superseded
+ *     session id may then start afresh
+ * Exits non-zero if a check fails.
+ *
+ * With --serve it only runs the device stand-in, so tools/udp_client.cpp
+ * can be pointed at it with --host 127.0.0.1 (without --http).
+ *
+ * Build (host):
+ *   g++ -O2 -std=c++11 -pthread -I tools/host -I src \
+ *       -o udp_control_test tools/udp_control_test.cpp src/udp_control.cpp \
+ *       tools/host/esp_host.cpp
+ *
+ * Usage:
+ *   udp_control_test [--port N] [--count N] [--loss PCT] [--reorder PCT]
+ *                    [--seed N] [--serve]
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "esp_host.h"
+#include "esp_wifi.h"
+#include "lwip/sockets.h"
+#include "levitation_control.h"
+#include "input_recorder.h"
+#include "setpoint.h"
+#include "udp_control.h"
+
+#define SEND_GAP_US             200         // Keeps the device's receive queue short
+#define ACK_WAIT_MS             500
+
+// Phase carries the session tag in the top byte and the sequence below it,
+// so the applied log says which datagram each setpoint came from
+#define PHASE_FOR(tag, seq)     (((uint32_t)(tag) << 24) | ((seq) & 0xFFFFFF))
+#define PHASE_TAG(turns)        ((turns) >> 24)
+#define PHASE_SEQ(turns)        ((turns) & 0xFFFFFF)
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do {                       \
+    if (!(cond)) {                                  \
+        printf("  FAIL: " __VA_ARGS__);             \
+        printf("\n");                               \
+        g_failures++;                               \
+    }                                               \
+} while (0)
+
+// ===== Device side =====
+
+static std::mutex g_applied_mutex;
+static std::vector<uint32_t> g_applied;     // Phase turns, in apply order
+
+void setpoint_apply_phase(phase_t phase, input_source_t source) {
+    (void)source;
+    std::lock_guard<std::mutex> lock(g_applied_mutex);
+    g_applied.push_back(phase.turns);
+}
+
+float levitation_get_frequency() {
+    return 40000.0f;
+}
+
+void levitation_set_frequency(float frequency) {
+    (void)frequency;
+}
+
+void input_recorder_record(input_source_t source, input_kind_t kind, uint32_t value) {
+    (void)source;
+    (void)kind;
+    (void)value;
+}
+
+static std::vector<uint32_t> take_applied() {
+    std::lock_guard<std::mutex> lock(g_applied_mutex);
+    std::vector<uint32_t> applied;
+    applied.swap(g_applied);
+    return applied;
+}
+
+static void wait_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// ===== Client side =====
+
+typedef struct {
+    uint32_t session;
+    uint32_t tag;
+    uint32_t seq;
+} datagram_t;
+
+typedef struct {
+    uint32_t applied;
+    uint32_t stale;
+} acks_t;
+
+static int g_client = -1;
+static struct sockaddr_in g_device;
+static acks_t g_acks;
+
+static bool read_ack(int flags) {
+    udp_setpoint_t ack;
+    if (recv(g_client, &ack, sizeof(ack), flags) != (ssize_t)sizeof(ack)) return false;
+    if (ack.magic != UDP_MAGIC) return true;
+    if (ack.type == UDP_MSG_ACK_APPLIED) g_acks.applied++;
+    else if (ack.type == UDP_MSG_ACK_STALE) g_acks.stale++;
+    return true;
+}
+
+static void send_datagram(const datagram_t* d) {
+    udp_setpoint_t msg;
+    msg.magic = UDP_MAGIC;
+    msg.version = UDP_VERSION;
+    msg.type = UDP_MSG_SETPOINT;
+    msg.session = d->session;
+    msg.seq = d->seq;
+    msg.phase = PHASE_FOR(d->tag, d->seq);
+    msg.frequency_hz = 0;
+    sendto(g_client, &msg, sizeof(msg), 0, (struct sockaddr*)&g_device, sizeof(g_device));
+    std::this_thread::sleep_for(std::chrono::microseconds(SEND_GAP_US));
+    // Drain as we go so the client's own receive buffer never drops an ack
+    while (read_ack(MSG_DONTWAIT)) {}
+}
+
+/**
+ * Wait until `expected` acks have arrived since the last call, or until
+ * none arrives for ACK_WAIT_MS
+ */
+static void collect_acks(uint32_t expected, acks_t* acks) {
+    struct timeval tv = {0, 1000 * ACK_WAIT_MS};
+    setsockopt(g_client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    while (g_acks.applied + g_acks.stale < expected && read_ack(0)) {}
+    *acks = g_acks;
+    memset(&g_acks, 0, sizeof(g_acks));
+}
+
+/**
+ * Send in order and return the phases the device should apply: the
+ * datagrams newer than everything before them in their session
+ */
+static std::vector<uint32_t> deliver(const std::vector<datagram_t>& order, uint32_t* current_session,
+                                     uint32_t* last_seq) {
+    std::vector<uint32_t> expected;
+    for (size_t i = 0; i < order.size(); i++) {
+        const datagram_t* d = &order[i];
+        send_datagram(d);
+        if (d->session != *current_session) {
+            *current_session = d->session;
+            *last_seq = d->seq - 1;
+        }
+        if ((int32_t)(d->seq - *last_seq) > 0) {
+            *last_seq = d->seq;
+            expected.push_back(PHASE_FOR(d->tag, d->seq));
+        }
+    }
+    return expected;
+}
+
+static void get_stats(udp_control_stats_t* stats) {
+    // The counters belong to the receive task; let it finish the last datagram
+    wait_ms(20);
+    udp_control_get_stats(stats);
+}
+
+// ===== Scenarios =====
+
+static uint32_t g_session = 0;
+static uint32_t g_last_seq = 0;
+
+static void check_stale_drop(uint32_t count, double loss_pct, double reorder_pct, std::mt19937& rng) {
+    printf("stale drop: %u setpoints, %.0f%% loss, %.0f%% reordered\n", count, loss_pct, reorder_pct);
+    std::uniform_real_distribution<double> roll(0.0, 100.0);
+    std::uniform_int_distribution<int> lateness(1, 3);
+    const uint32_t session = 0x1001;
+
+    // Loss and reordering on the way to the device, as Wi-Fi retries cause
+    std::vector<datagram_t> order;
+    std::vector<std::pair<int, datagram_t> > held;
+    uint32_t lost = 0, reordered = 0;
+    for (uint32_t seq = 1; seq <= count; seq++) {
+        datagram_t d = {session, 1, seq};
+        double r = roll(rng);
+        // The first and last datagrams always arrive in place, so the
+        // session starts at 1 and ends on the final setpoint
+        bool pinned = seq == 1 || seq == count;
+        if (!pinned && r < loss_pct) {
+            lost++;
+        } else if (!pinned && r < loss_pct + reorder_pct) {
+            held.push_back(std::make_pair(lateness(rng), d));
+            reordered++;
+        } else {
+            order.push_back(d);
+            for (size_t i = 0; i < held.size();) {
+                if (--held[i].first == 0) {
+                    order.push_back(held[i].second);
+                    held.erase(held.begin() + i);
+                } else {
+                    i++;
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < held.size(); i++) order.push_back(held[i].second);
+
+    udp_control_stats_t before, after;
+    get_stats(&before);
+    std::vector<uint32_t> expected = deliver(order, &g_session, &g_last_seq);
+    acks_t acks;
+    collect_acks((uint32_t)order.size(), &acks);
+    get_stats(&after);
+    std::vector<uint32_t> applied = take_applied();
+
+    uint32_t received = after.received - before.received;
+    uint32_t stale = after.stale - before.stale;
+    printf("  sent %zu  lost %u  reordered %u  received %u  applied %zu  stale %u\n",
+           order.size(), lost, reordered, received, applied.size(), stale);
+    CHECK(received == order.size(), "device received %u of %zu datagrams", received, order.size());
+    CHECK(applied == expected, "applied %zu setpoints, expected %zu (or in a different order)",
+          applied.size(), expected.size());
+    bool ascending = true;
+    for (size_t i = 1; i < applied.size(); i++) {
+        if (PHASE_SEQ(applied[i]) <= PHASE_SEQ(applied[i - 1])) ascending = false;
+    }
+    CHECK(ascending, "a setpoint older than an applied one was applied");
+    CHECK(!applied.empty() && PHASE_SEQ(applied.back()) == count, "final setpoint not applied last");
+    CHECK(stale == order.size() - expected.size(), "%u stale, expected %zu",
+          stale, order.size() - expected.size());
+    CHECK(acks.applied == applied.size() && acks.stale == stale,
+          "acks %u applied / %u stale disagree with the device", acks.applied, acks.stale);
+    wifi_ps_type_t ps;
+    esp_wifi_get_ps(&ps);
+    CHECK(ps == WIFI_PS_NONE, "modem power save still on during a session");
+}
+
+static void check_takeover() {
+    printf("takeover: controller B takes over while A's datagrams are in flight\n");
+    const uint32_t a = 0x2001, b = 0x2002, c = 0x2003;
+    std::vector<datagram_t> order;
+    for (uint32_t seq = 1; seq <= 50; seq++) order.push_back((datagram_t){a, 2, seq});
+    for (uint32_t seq = 1; seq <= 20; seq++) order.push_back((datagram_t){b, 3, seq});
+    // A keeps streaming, interleaved with B, with higher sequence numbers than B's
+    for (uint32_t seq = 21; seq <= 40; seq++) {
+        order.push_back((datagram_t){a, 2, seq + 30});
+        order.push_back((datagram_t){b, 3, seq});
+    }
+    // C takes over from B; B's stragglers and A's are both superseded
+    for (uint32_t seq = 1; seq <= 10; seq++) order.push_back((datagram_t){c, 4, seq});
+    for (uint32_t seq = 41; seq <= 45; seq++) {
+        order.push_back((datagram_t){b, 3, seq});
+        order.push_back((datagram_t){a, 2, seq + 30});
+    }
+    order.push_back((datagram_t){c, 4, 11});
+
+    // What the device should do: everything from a session after it was taken over is dropped
+    std::vector<uint32_t> expected;
+    std::vector<uint32_t> retired;
+    uint32_t superseded_expected = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        const datagram_t* d = &order[i];
+        bool is_retired = false;
+        for (size_t r = 0; r < retired.size(); r++) {
+            if (retired[r] == d->session) is_retired = true;
+        }
+        if (is_retired) {
+            superseded_expected++;
+            continue;
+        }
+        if (d->session != g_session) {
+            retired.push_back(g_session);
+            g_session = d->session;
+            g_last_seq = d->seq - 1;
+        }
+        if ((int32_t)(d->seq - g_last_seq) > 0) {
+            g_last_seq = d->seq;
+            expected.push_back(PHASE_FOR(d->tag, d->seq));
+        }
+    }
+
+    udp_control_stats_t before, after;
+    get_stats(&before);
+    for (size_t i = 0; i < order.size(); i++) send_datagram(&order[i]);
+    acks_t acks;
+    collect_acks((uint32_t)order.size(), &acks);
+    get_stats(&after);
+    std::vector<uint32_t> applied = take_applied();
+
+    uint32_t superseded = after.superseded - before.superseded;
+    uint32_t from_retired = 0;
+    bool b_after_c = false;
+    for (size_t i = 0; i < applied.size(); i++) {
+        if (PHASE_TAG(applied[i]) == 2 && PHASE_SEQ(applied[i]) > 50) from_retired++;
+        if (PHASE_TAG(applied[i]) == 3 && PHASE_SEQ(applied[i]) > 40) b_after_c = true;
+    }
+    printf("  sent %zu  applied %zu  superseded %u  sessions started %u\n", order.size(),
+           applied.size(), superseded, after.sessions - before.sessions);
+    CHECK(applied == expected, "applied %zu setpoints, expected %zu (or in a different order)",
+          applied.size(), expected.size());
+    CHECK(from_retired == 0, "%u late datagrams from A were applied after B took over", from_retired);
+    CHECK(!b_after_c, "late datagrams from B were applied after C took over");
+    CHECK(superseded == superseded_expected, "%u superseded, expected %u", superseded, superseded_expected);
+    CHECK(after.sessions - before.sessions == 3, "%u sessions started, expected 3 (A, B, C)",
+          after.sessions - before.sessions);
+    CHECK(acks.applied == applied.size() && acks.applied + acks.stale == order.size(),
+          "acks %u applied / %u stale for %zu datagrams", acks.applied, acks.stale, order.size());
+    CHECK(!applied.empty() && applied.back() == PHASE_FOR(4, 11), "C's final setpoint not applied last");
+}
+
+static void check_idle(wifi_ps_type_t configured) {
+    printf("idle: session ends after %d ms\n", UDP_SESSION_TIMEOUT_MS);
+    // The receive task checks the timeout at least once a second
+    wait_ms(UDP_SESSION_TIMEOUT_MS + 1500);
+    wifi_ps_type_t ps;
+    esp_wifi_get_ps(&ps);
+    printf("  power save mode %d, configured %d\n", (int)ps, (int)configured);
+    CHECK(ps == configured, "power save mode %d after the session, expected %d", (int)ps, (int)configured);
+
+    // A was superseded before the port went idle; it may start afresh now
+    udp_control_stats_t before, after;
+    get_stats(&before);
+    datagram_t d = {0x2001, 2, 1};
+    send_datagram(&d);
+    acks_t acks;
+    collect_acks(1, &acks);
+    get_stats(&after);
+    std::vector<uint32_t> applied = take_applied();
+    printf("  superseded id after idle: %s\n", acks.applied == 1 ? "applied" : "dropped");
+    CHECK(applied.size() == 1 && after.superseded == before.superseded,
+          "a superseded id was still refused after the port went idle");
+}
+
+int main(int argc, char** argv) {
+    uint16_t port = UDP_CONTROL_PORT;
+    uint32_t count = 2000;
+    double loss_pct = 10;
+    double reorder_pct = 10;
+    unsigned seed = 1;
+    bool serve = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--port") && i + 1 < argc) port = (uint16_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--count") && i + 1 < argc) count = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--loss") && i + 1 < argc) loss_pct = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--reorder") && i + 1 < argc) reorder_pct = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--serve")) serve = true;
+        else {
+            fprintf(stderr, "usage: %s [--port N] [--count N] [--loss PCT] [--reorder PCT] "
+                            "[--seed N] [--serve]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (count < 2) count = 2;
+
+    // Not the station default, so restoring a hard-coded mode would show
+    const wifi_ps_type_t configured = WIFI_PS_MAX_MODEM;
+    esp_wifi_set_ps(configured);
+    if (!udp_control_begin(port)) {
+        printf("udp_control_begin failed on port %u: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    if (serve) {
+        printf("device stand-in on UDP port %u\n", port);
+        while (true) {
+            wait_ms(1000);
+            udp_control_stats_t stats;
+            udp_control_get_stats(&stats);
+            size_t applied = take_applied().size();
+            printf("received %u  applied %u (+%zu)  stale %u  superseded %u  sessions %u\n",
+                   stats.received, stats.applied, applied, stats.stale, stats.superseded,
+                   stats.sessions);
+        }
+    }
+
+    g_client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    memset(&g_device, 0, sizeof(g_device));
+    g_device.sin_family = AF_INET;
+    g_device.sin_port = htons(port);
+    g_device.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::mt19937 rng(seed);
+    check_stale_drop(count, loss_pct, reorder_pct, rng);
+    check_takeover();
+    check_idle(configured);
+
+    printf("%s\n", g_failures ? "FAILED" : "ok");
+    // The receive task never returns; leave without joining it
+    fflush(stdout);
+    _Exit(g_failures ? 1 : 0);
+}